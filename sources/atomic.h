@@ -70,4 +70,10 @@ od_atomic_u64_sub(od_atomic_u64_t *atomic, uint64_t value)
 	__sync_sub_and_fetch(atomic, value);
 }
 
+static inline uint64_t
+od_atomic_u64_cas(od_atomic_u64_t *atomic, uint64_t compare, uint64_t value)
+{
+	return __sync_val_compare_and_swap(atomic, compare, value);
+}
+
 #endif /* ODYSSEY_ATOMIC_H */
@@ -556,7 +556,8 @@ od_auth_backend(od_server_t *server, machine_msg_t *msg)
 			}
 			return 0;
 		case KIWI_BE_ERROR_RESPONSE:
-			od_backend_error(server, "auth", msg);
+			od_backend_error(server, "auth", machine_msg_get_data(msg),
+			                 machine_msg_get_size(msg));
 			machine_msg_free(msg);
 			return -1;
 		default:
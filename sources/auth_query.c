@@ -71,7 +71,8 @@ od_auth_query_do(od_server_t *server, char *query, int len,
 
 		switch (type) {
 		case KIWI_BE_ERROR_RESPONSE:
-			od_backend_error(server, "auth_query", msg);
+			od_backend_error(server, "auth_query", machine_msg_get_data(msg),
+			                 machine_msg_get_size(msg));
 			goto error;
 		case KIWI_BE_ROW_DESCRIPTION:
 			break;
@@ -128,7 +129,8 @@ od_auth_query_do(od_server_t *server, char *query, int len,
 			break;
 		}
 		case KIWI_BE_READY_FOR_QUERY:
-			od_backend_ready(server, msg);
+			od_backend_ready(server, machine_msg_get_data(msg),
+			                 machine_msg_get_size(msg));
 			machine_msg_free(msg);
 			return 0;
 		default:
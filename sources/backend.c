@@ -57,12 +57,27 @@ od_backend_close_connection(od_server_t *server)
 		machine_io_free(server->io);
 		server->io = NULL;
 	}
+	if (server->endpoint) {
+		od_storage_endpoint_release(server->endpoint);
+		server->endpoint = NULL;
+	}
 
 	if (server->error_connect) {
 		machine_msg_free(server->error_connect);
 		server->error_connect = NULL;
 	}
 
+	/* session state is gone with the connection */
+	kiwi_params_free(&server->params);
+	kiwi_params_init(&server->params);
+	kiwi_params_free(&server->deploy_params);
+	kiwi_params_init(&server->deploy_params);
+	server->is_dirty = 0;
+
+	/* statements are gone with the connection */
+	od_prepare_map_free(&server->prepare_map);
+	od_prepare_queue_free(&server->prepare_queue);
+
 	if (server->tls) {
 		machine_tls_free(server->tls);
 		server->tls = NULL;
@@ -71,12 +86,12 @@ od_backend_close_connection(od_server_t *server)
 
 void
 od_backend_error(od_server_t *server, char *context,
-                 machine_msg_t *msg)
+                 char *data, uint32_t size)
 {
 	od_instance_t *instance = server->global->instance;
 	kiwi_fe_error_t error;
 	int rc;
-	rc = kiwi_fe_read_error(msg, &error);
+	rc = kiwi_fe_read_error(data, size, &error);
 	if (rc == -1) {
 		od_error(&instance->logger, context, server->client, server,
 		         "failed to parse error message from server");
@@ -98,11 +113,11 @@ od_backend_error(od_server_t *server, char *context,
 }
 
 int
-od_backend_ready(od_server_t *server, machine_msg_t *msg)
+od_backend_ready(od_server_t *server, char *data, uint32_t size)
 {
 	int status;
 	int rc;
-	rc = kiwi_fe_read_ready(msg, &status);
+	rc = kiwi_fe_read_ready(data, size, &status);
 	if (rc == -1)
 		return -1;
 	if (status == 'I') {
@@ -120,6 +135,36 @@ od_backend_ready(od_server_t *server, machine_msg_t *msg)
 	return 0;
 }
 
+int
+od_backend_parameter(od_server_t *server, char *context,
+                     char *data, uint32_t size)
+{
+	od_instance_t *instance = server->global->instance;
+	char *name;
+	uint32_t name_len;
+	char *value;
+	uint32_t value_len;
+	int rc;
+	rc = kiwi_fe_read_parameter(data, size, &name, &name_len,
+	                            &value, &value_len);
+	if (rc == -1) {
+		od_error(&instance->logger, context, server->client, server,
+		         "failed to parse ParameterStatus message");
+		return -1;
+	}
+	od_debug(&instance->logger, context, server->client, server,
+	         "%.*s = %.*s",
+	         name_len, name, value_len, value);
+
+	/* update last reported server parameter state */
+	kiwi_param_t *param;
+	param = kiwi_param_allocate(name, name_len, value, value_len);
+	if (param == NULL)
+		return -1;
+	kiwi_params_replace(&server->params, param);
+	return 0;
+}
+
 static inline int
 od_backend_startup(od_server_t *server, kiwi_params_t *params)
 {
@@ -169,7 +214,8 @@ od_backend_startup(od_server_t *server, kiwi_params_t *params)
 
 		switch (type) {
 		case KIWI_BE_READY_FOR_QUERY:
-			od_backend_ready(server, msg);
+			od_backend_ready(server, machine_msg_get_data(msg),
+			                 machine_msg_get_size(msg));
 			machine_msg_free(msg);
 			return 0;
 		case KIWI_BE_AUTHENTICATION:
@@ -193,7 +239,9 @@ od_backend_startup(od_server_t *server, kiwi_params_t *params)
 			uint32_t name_len;
 			char *value;
 			uint32_t value_len;
-			rc = kiwi_fe_read_parameter(msg, &name, &name_len, &value, &value_len);
+			rc = kiwi_fe_read_parameter(machine_msg_get_data(msg),
+			                            machine_msg_get_size(msg),
+			                            &name, &name_len, &value, &value_len);
 			if (rc == -1) {
 				machine_msg_free(msg);
 				od_error(&instance->logger, "startup", NULL, server,
@@ -203,17 +251,24 @@ od_backend_startup(od_server_t *server, kiwi_params_t *params)
 			/* track server parameters */
 			kiwi_param_t *param;
 			param = kiwi_param_allocate(name, name_len, value, value_len);
+			if (param == NULL) {
+				machine_msg_free(msg);
+				return -1;
+			}
+			kiwi_params_add(params, param);
+			param = kiwi_param_allocate(name, name_len, value, value_len);
 			machine_msg_free(msg);
 			if (param == NULL)
 				return -1;
-			kiwi_params_add(params, param);
+			kiwi_params_replace(&server->params, param);
 			break;
 		}
 		case KIWI_BE_NOTICE_RESPONSE:
 			machine_msg_free(msg);
 			break;
 		case KIWI_BE_ERROR_RESPONSE:
-			od_backend_error(server, "startup", msg);
+			od_backend_error(server, "startup", machine_msg_get_data(msg),
+			                 machine_msg_get_size(msg));
 			server->error_connect = msg;
 			return -1;
 		default:
@@ -228,9 +283,9 @@ od_backend_startup(od_server_t *server, kiwi_params_t *params)
 }
 
 static inline int
-od_backend_connect_to(od_server_t *server,
-                      char *context,
-                      od_config_storage_t *server_config)
+od_backend_connect_prepare(od_server_t *server,
+                           char *context,
+                           od_config_storage_t *server_config)
 {
 	od_instance_t *instance = server->global->instance;
 	assert(server->io == NULL);
@@ -258,52 +313,62 @@ od_backend_connect_to(od_server_t *server,
 		if (server->tls == NULL)
 			return -1;
 	}
+	return 0;
+}
+
+static inline int
+od_backend_connect_to(od_server_t *server,
+                      char *context,
+                      od_config_storage_t *server_config,
+                      od_storage_endpoint_t *endpoint)
+{
+	od_instance_t *instance = server->global->instance;
+	int rc;
 
 	uint64_t time_connect_start;
 	time_connect_start = machine_time();
 
-	struct sockaddr_un   saddr_un;
-	struct sockaddr_in   saddr_v4;
-	struct sockaddr_in6  saddr_v6;
-	struct sockaddr     *saddr;
-	struct addrinfo *ai = NULL;
+	struct sockaddr_un      saddr_un;
+	struct sockaddr_in      saddr_v4;
+	struct sockaddr_in6     saddr_v6;
+	struct sockaddr_storage saddr_dns[OD_DNS_ADDR_MAX];
+	struct sockaddr        *saddr;
+	int                     saddr_count = 1;
 
 	/* resolve server address */
-	if (server_config->host)
+	if (endpoint)
 	{
 		/* assume IPv6 or IPv4 is specified */
 		int rc_resolve = -1;
-		if (strchr(server_config->host, ':')) {
+		if (strchr(endpoint->host, ':')) {
 			/* v6 */
 			memset(&saddr_v6, 0, sizeof(saddr_v6));
 			saddr_v6.sin6_family = AF_INET6;
-			saddr_v6.sin6_port   = htons(server_config->port);
-			rc_resolve = inet_pton(AF_INET6, server_config->host, &saddr_v6.sin6_addr);
+			saddr_v6.sin6_port   = htons(endpoint->port);
+			rc_resolve = inet_pton(AF_INET6, endpoint->host, &saddr_v6.sin6_addr);
 			saddr = (struct sockaddr*)&saddr_v6;
 		} else {
 			/* v4 or hostname */
 			memset(&saddr_v4, 0, sizeof(saddr_v4));
 			saddr_v4.sin_family = AF_INET;
-			saddr_v4.sin_port   = htons(server_config->port);
-			rc_resolve = inet_pton(AF_INET, server_config->host, &saddr_v4.sin_addr);
+			saddr_v4.sin_port   = htons(endpoint->port);
+			rc_resolve = inet_pton(AF_INET, endpoint->host, &saddr_v4.sin_addr);
 			saddr = (struct sockaddr*)&saddr_v4;
 		}
 
-		/* schedule getaddrinfo() execution */
+		/* use cached addresses or schedule getaddrinfo() execution */
 		if (rc_resolve != 1) {
-			char port[16];
-			od_snprintf(port, sizeof(port), "%d", server_config->port);
-
-			rc = machine_getaddrinfo(server_config->host, port, NULL, &ai, 0);
-			if (rc != 0) {
+			rc = od_dns_resolve(server->global, endpoint->host,
+			                    endpoint->port, saddr_dns, OD_DNS_ADDR_MAX);
+			if (rc == -1) {
 				od_error(&instance->logger, context, NULL, server,
 				         "failed to resolve %s:%d",
-				         server_config->host,
-				         server_config->port);
+				         endpoint->host,
+				         endpoint->port);
 				return -1;
 			}
-			assert(ai != NULL);
-			saddr = ai->ai_addr;
+			saddr = (struct sockaddr*)&saddr_dns[0];
+			saddr_count = rc;
 		}
 	} else {
 		/* set unix socket path */
@@ -319,15 +384,22 @@ od_backend_connect_to(od_server_t *server,
 	uint64_t time_resolve;
 	time_resolve = machine_time() - time_connect_start;
 
-	/* connect to server */
-	rc = machine_connect(server->io, saddr, UINT32_MAX);
-	if (ai)
-		freeaddrinfo(ai);
+	/* connect to server, try resolved addresses in turn */
+	int saddr_pos = 0;
+	for (;;) {
+		rc = machine_connect(server->io, saddr, UINT32_MAX);
+		if (rc == 0 || ++saddr_pos == saddr_count)
+			break;
+		od_debug(&instance->logger, context, server->client, server,
+		         "failed to connect to %s:%d (address %d of %d), trying next",
+		         endpoint->host, endpoint->port, saddr_pos, saddr_count);
+		saddr = (struct sockaddr*)&saddr_dns[saddr_pos];
+	}
 	if (rc == -1) {
-		if (server_config->host) {
+		if (endpoint) {
 			od_error(&instance->logger, context, server->client, server,
-			         "failed to connect to %s:%d", server_config->host,
-			         server_config->port);
+			         "failed to connect to %s:%d", endpoint->host,
+			         endpoint->port);
 		} else {
 			od_error(&instance->logger, context, server->client, server,
 			         "failed to connect to %s", saddr_un.sun_path);
@@ -335,23 +407,16 @@ od_backend_connect_to(od_server_t *server,
 		return -1;
 	}
 
-	/* do tls handshake */
-	if (server_config->tls_mode != OD_TLS_DISABLE) {
-		rc = od_tls_backend_connect(server, &instance->logger, server_config);
-		if (rc == -1)
-			return -1;
-	}
-
 	uint64_t time_connect;
 	time_connect = machine_time() - time_connect_start;
 
 	/* log server connection */
 	if (instance->config.log_session) {
-		if (server_config->host) {
+		if (endpoint) {
 			od_log(&instance->logger, context, server->client, server,
 			       "new server connection %s:%d (connect time: %d usec, resolve time: %d usec)",
-			       server_config->host,
-			       server_config->port,
+			       endpoint->host,
+			       endpoint->port,
 			       (int)time_connect,
 			       (int)time_resolve);
 		} else {
@@ -372,14 +437,66 @@ od_backend_connect(od_server_t *server, char *context)
 	od_route_t *route = server->route;
 	assert(route != NULL);
 
+	od_instance_t *instance = server->global->instance;
 	od_config_storage_t *server_config;
-	server_config = route->config->storage;
-
-	/* connect to server */
+	server_config = od_route_storage(route);
+
+	/* connect to server, try each storage host at most once.
+	 *
+	 * Server connection is counted against the chosen host
+	 * until closed.
+	*/
+	int attempts = server_config->endpoints_count;
 	int rc;
-	rc = od_backend_connect_to(server, context, server_config);
-	if (rc == -1)
-		return -1;
+	for (;;)
+	{
+		od_storage_endpoint_t *endpoint = NULL;
+		if (server_config->endpoints_count > 0) {
+			endpoint = od_storage_endpoint_select(route->storage, server_config);
+			if (endpoint == NULL) {
+				od_error(&instance->logger, context, NULL, server,
+				         "failed to allocate storage host");
+				return -1;
+			}
+			server->endpoint = endpoint;
+		}
+
+		rc = od_backend_connect_prepare(server, context, server_config);
+		if (rc == -1)
+			return -1;
+
+		/* only resolve and connect errors take host out of rotation */
+		uint64_t time_connect_start = machine_time();
+		rc = od_backend_connect_to(server, context, server_config, endpoint);
+		if (rc == 0) {
+			if (endpoint)
+				od_storage_endpoint_connected(route->storage, endpoint,
+				                              machine_time() - time_connect_start);
+			break;
+		}
+		if (endpoint == NULL)
+			return -1;
+
+		/* take host out of rotation */
+		int backoff;
+		backoff = od_storage_endpoint_failed(route->storage, endpoint,
+		                                     server_config->host_backoff);
+		if (backoff > 0)
+			od_log(&instance->logger, context, NULL, server,
+			       "host %s:%d is out of rotation for %d secs",
+			       endpoint->host, endpoint->port, backoff);
+		if (--attempts == 0)
+			return -1;
+		od_backend_close_connection(server);
+	}
+
+	/* do tls handshake */
+	if (server_config->tls_mode != OD_TLS_DISABLE) {
+		rc = od_tls_backend_connect(server, &instance->logger, server_config,
+		                            server->endpoint);
+		if (rc == -1)
+			return -1;
+	}
 
 	kiwi_params_t params;
 	kiwi_params_init(&params);
@@ -399,14 +516,24 @@ od_backend_connect(od_server_t *server, char *context)
 int
 od_backend_connect_cancel(od_server_t *server,
                           od_config_storage_t *server_config,
+                          od_storage_endpoint_t *endpoint,
                           kiwi_key_t *key)
 {
 	od_instance_t *instance = server->global->instance;
 	/* connect to server */
 	int rc;
-	rc = od_backend_connect_to(server, "cancel", server_config);
+	rc = od_backend_connect_prepare(server, "cancel", server_config);
+	if (rc == -1)
+		return -1;
+	rc = od_backend_connect_to(server, "cancel", server_config, endpoint);
 	if (rc == -1)
 		return -1;
+	if (server_config->tls_mode != OD_TLS_DISABLE) {
+		rc = od_tls_backend_connect(server, &instance->logger, server_config,
+		                            endpoint);
+		if (rc == -1)
+			return -1;
+	}
 	/* send cancel request */
 	machine_msg_t *msg;
 	msg = kiwi_fe_write_cancel(key->key_pid, key->key);
@@ -453,12 +580,24 @@ od_backend_ready_wait(od_server_t *server, char *context, int count,
 		         kiwi_be_type_to_string(type));
 
 		if (type == KIWI_BE_ERROR_RESPONSE) {
-			od_backend_error(server, context, msg);
+			od_backend_error(server, context, machine_msg_get_data(msg),
+			                 machine_msg_get_size(msg));
+			machine_msg_free(msg);
+			continue;
+		}
+		if (type == KIWI_BE_PARAMETER_STATUS) {
+			int rc;
+			rc = od_backend_parameter(server, context,
+			                          machine_msg_get_data(msg),
+			                          machine_msg_get_size(msg));
 			machine_msg_free(msg);
+			if (rc == -1)
+				return -1;
 			continue;
 		}
 		if (type == KIWI_BE_READY_FOR_QUERY) {
-			od_backend_ready(server, msg);
+			od_backend_ready(server, machine_msg_get_data(msg),
+			                 machine_msg_get_size(msg));
 			ready++;
 			if (ready == count) {
 				machine_msg_free(msg);
@@ -504,15 +643,22 @@ od_backend_query(od_server_t *server, char *context, char *query, int len)
 
 int
 od_backend_deploy(od_server_t *server, char *context,
-                  machine_msg_t *msg)
+                  char *data, uint32_t size)
 {
 	int rc;
-	switch (*(char*)machine_msg_get_data(msg)) {
+	switch (*data) {
 	case KIWI_BE_ERROR_RESPONSE:
-		od_backend_error(server, context, msg);
+		od_backend_error(server, context, data, size);
+		/* deployed parameters state is unknown */
+		server->is_dirty = 1;
+		break;
+	case KIWI_BE_PARAMETER_STATUS:
+		rc = od_backend_parameter(server, context, data, size);
+		if (rc == -1)
+			return -1;
 		break;
 	case KIWI_BE_READY_FOR_QUERY:
-		rc = od_backend_ready(server, msg);
+		rc = od_backend_ready(server, data, size);
 		if (rc == -1)
 			return -1;
 		server->deploy_sync--;
@@ -539,7 +685,8 @@ od_backend_deploy_wait(od_server_t *server, char *context,
 			return -1;
 		}
 		int rc;
-		rc = od_backend_deploy(server, context, msg);
+		rc = od_backend_deploy(server, context, machine_msg_get_data(msg),
+		                       machine_msg_get_size(msg));
 		machine_msg_free(msg);
 		if (rc == -1)
 			return -1;
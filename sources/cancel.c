@@ -21,10 +21,14 @@
 int
 od_cancel(od_global_t *global,
           od_config_storage_t *server_config,
+          od_storage_endpoint_t *endpoint,
           kiwi_key_t *key,
           od_id_t *server_id)
 {
 	od_instance_t *instance = global->instance;
+	/* server is not connected yet */
+	if (server_config->endpoints_count > 0 && endpoint == NULL)
+		return 0;
 	od_log(&instance->logger, "cancel", NULL, NULL,
 	       "cancel for %s%.*s",
 	       server_id->id_prefix,
@@ -32,34 +36,119 @@ od_cancel(od_global_t *global,
 	od_server_t server;
 	od_server_init(&server);
 	server.global = global;
-	od_backend_connect_cancel(&server, server_config, key);
+	/* connect to the server host */
+	od_backend_connect_cancel(&server, server_config, endpoint, key);
 	od_backend_close_connection(&server);
 	od_backend_close(&server);
 	return 0;
 }
 
-static inline int
-od_cancel_cmp(od_server_t *server, void *arg)
+static inline uint64_t
+od_cancel_hash(kiwi_key_t *key)
 {
-	kiwi_key_t *key = arg;
-	return kiwi_key_cmp(&server->key_client, key);
+	uint64_t hash;
+	hash = ((uint64_t)key->key_pid << 32) | key->key;
+	hash *= 0x9e3779b97f4a7c15ULL;
+	return hash ^ (hash >> 32);
 }
 
-int od_cancel_find(od_route_pool_t *route_pool, kiwi_key_t *key,
-                   od_router_cancel_t *cancel)
+static inline int
+od_cancel_index_resize(od_cancel_index_t *index, int buckets_count)
 {
-	/* match server by client key (forge) */
-	od_server_t *server;
-	server = od_route_pool_server_foreach(route_pool, OD_SERVER_ACTIVE,
-	                                      od_cancel_cmp,
-	                                      key);
-	if (server == NULL)
-		return -1;
-	od_route_t *route = server->route;
-	cancel->id = server->id;
-	cancel->config = od_config_storage_copy(route->config->storage);
-	if (cancel->config == NULL)
+	od_list_t *buckets;
+	buckets = malloc(sizeof(od_list_t) * buckets_count);
+	if (buckets == NULL)
 		return -1;
-	cancel->key = server->key;
+	int i = 0;
+	for (; i < buckets_count; i++)
+		od_list_init(&buckets[i]);
+
+	/* move servers to the new buckets */
+	for (i = 0; i < index->buckets_count; i++) {
+		od_list_t *j, *n;
+		od_list_foreach_safe(&index->buckets[i], j, n) {
+			od_server_t *server;
+			server = od_container_of(j, od_server_t, link_cancel);
+			uint64_t hash = od_cancel_hash(&server->key_client);
+			od_list_append(&buckets[hash & (buckets_count - 1)],
+			               &server->link_cancel);
+		}
+	}
+	free(index->buckets);
+	index->buckets = buckets;
+	index->buckets_count = buckets_count;
 	return 0;
 }
+
+void
+od_cancel_index_add(od_cancel_index_t *index, od_server_t *server)
+{
+	/* index active server by its client key, the index keeps
+	 * chaining into the current buckets if it cannot grow */
+	pthread_mutex_lock(&index->lock);
+	if (index->count >= index->buckets_count) {
+		int buckets_count = index->buckets_count * 2;
+		if (buckets_count == 0)
+			buckets_count = 64;
+		int rc;
+		rc = od_cancel_index_resize(index, buckets_count);
+		if (rc == -1 && index->buckets_count == 0) {
+			pthread_mutex_unlock(&index->lock);
+			return;
+		}
+	}
+	uint64_t hash = od_cancel_hash(&server->key_client);
+	od_list_append(&index->buckets[hash & (index->buckets_count - 1)],
+	               &server->link_cancel);
+	index->count++;
+	pthread_mutex_unlock(&index->lock);
+}
+
+void
+od_cancel_index_delete(od_cancel_index_t *index, od_server_t *server)
+{
+	pthread_mutex_lock(&index->lock);
+	if (! od_list_empty(&server->link_cancel)) {
+		od_list_unlink(&server->link_cancel);
+		od_list_init(&server->link_cancel);
+		assert(index->count > 0);
+		index->count--;
+	}
+	pthread_mutex_unlock(&index->lock);
+}
+
+int od_cancel_find(od_cancel_index_t *index, kiwi_key_t *key,
+                   od_router_cancel_t *cancel)
+{
+	/* match active server by client key (forge).
+	 *
+	 * Server stays attached while it is in the index, so its
+	 * route config can be copied under the index lock.
+	 */
+	int rc = -1;
+	pthread_mutex_lock(&index->lock);
+	if (index->count == 0)
+		goto done;
+	uint64_t hash = od_cancel_hash(key);
+	od_list_t *bucket;
+	bucket = &index->buckets[hash & (index->buckets_count - 1)];
+	od_list_t *i;
+	od_list_foreach(bucket, i) {
+		od_server_t *server;
+		server = od_container_of(i, od_server_t, link_cancel);
+		if (! kiwi_key_cmp(&server->key_client, key))
+			continue;
+		od_route_t *route = server->route;
+		cancel->id = server->id;
+		cancel->config = od_config_storage_copy(od_route_storage(route));
+		if (cancel->config == NULL)
+			break;
+		cancel->key = server->key;
+		cancel->endpoint = server->endpoint;
+		rc = 0;
+		break;
+	}
+done:
+	pthread_mutex_unlock(&index->lock);
+	return rc;
+}
@@ -7,7 +7,11 @@
  * Scalable PostgreSQL connection pooler.
 */
 
-int od_cancel(od_global_t*, od_config_storage_t*, kiwi_key_t*, od_id_t*);
-int od_cancel_find(od_route_pool_t*, kiwi_key_t*, od_router_cancel_t*);
+int od_cancel(od_global_t*, od_config_storage_t*, od_storage_endpoint_t*,
+              kiwi_key_t*, od_id_t*);
+int od_cancel_find(od_cancel_index_t*, kiwi_key_t*, od_router_cancel_t*);
+
+void od_cancel_index_add(od_cancel_index_t*, od_server_t*);
+void od_cancel_index_delete(od_cancel_index_t*, od_server_t*);
 
 #endif /* ODYSSEY_CANCEL_H */
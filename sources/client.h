@@ -10,6 +10,9 @@
 typedef struct od_client_ctl od_client_ctl_t;
 typedef struct od_client     od_client_t;
 
+/* defined by system.h */
+typedef struct od_system_server od_system_server_t;
+
 typedef enum
 {
 	OD_CLIENT_UNDEF,
@@ -36,20 +39,31 @@ struct od_client
 	od_client_ctl_t     ctl;
 	uint64_t            coroutine_id;
 	uint64_t            coroutine_attacher_id;
+	int64_t             machine;
 	machine_io_t       *io;
 	machine_io_t       *io_notify;
 	machine_tls_t      *tls;
 	od_config_route_t  *config;
 	od_config_listen_t *config_listen;
+	od_system_server_t *listen;
+	od_config_priority_t *priority;
+	uint64_t            priority_tag;
+	int                 is_read_only;
+	int                 prepare_skip;
 	uint64_t            time_accept;
 	uint64_t            time_setup;
 	kiwi_be_startup_t   startup;
 	kiwi_params_t       params;
 	kiwi_key_t          key;
+	od_prepare_map_t    prepare_map;
+	machine_msg_t      *relay_msg;
+	machine_msg_t      *router_msg;
+	machine_reply_t    *router_reply;
 	od_server_t        *server;
 	void               *route;
 	od_global_t        *global;
 	od_list_t           link_pool;
+	od_list_t           link_storage;
 	od_list_t           link;
 };
 
@@ -59,10 +73,19 @@ od_client_init(od_client_t *client)
 	client->state = OD_CLIENT_UNDEF;
 	client->coroutine_id = 0;
 	client->coroutine_attacher_id = 0;
+	client->machine = -1;
 	client->io = NULL;
 	client->tls = NULL;
 	client->config = NULL;
 	client->config_listen = NULL;
+	client->listen = NULL;
+	client->priority = NULL;
+	client->priority_tag = 0;
+	client->is_read_only = 0;
+	client->prepare_skip = 0;
+	client->relay_msg = NULL;
+	client->router_msg = NULL;
+	client->router_reply = NULL;
 	client->server = NULL;
 	client->route = NULL;
 	client->global = NULL;
@@ -72,10 +95,42 @@ od_client_init(od_client_t *client)
 	kiwi_be_startup_init(&client->startup);
 	kiwi_params_init(&client->params);
 	kiwi_key_init(&client->key);
+	od_prepare_map_init(&client->prepare_map);
 	od_list_init(&client->link_pool);
+	od_list_init(&client->link_storage);
 	od_list_init(&client->link);
 }
 
+static inline void
+od_client_write_watermark(od_client_t *client, int *high, int *low)
+{
+	/* route settings override listen defaults */
+	if (client->config && client->config->write_queue_high > 0) {
+		*high = client->config->write_queue_high;
+		*low  = client->config->write_queue_low;
+		return;
+	}
+	*high = client->config_listen->write_queue_high;
+	*low  = client->config_listen->write_queue_low;
+}
+
+static inline int
+od_client_priority_id(od_client_t *client)
+{
+	/* no class means the implicit default one */
+	if (client->priority == NULL)
+		return 0;
+	return client->priority->id;
+}
+
+static inline int
+od_client_priority_weight(od_client_t *client)
+{
+	if (client->priority == NULL)
+		return 1;
+	return client->priority->weight;
+}
+
 static inline od_client_t*
 od_client_allocate(void)
 {
@@ -91,6 +146,13 @@ od_client_free(od_client_t *client)
 {
 	kiwi_be_startup_free(&client->startup);
 	kiwi_params_free(&client->params);
+	od_prepare_map_free(&client->prepare_map);
+	if (client->relay_msg)
+		machine_msg_free(client->relay_msg);
+	if (client->router_msg)
+		machine_msg_free(client->router_msg);
+	if (client->router_reply)
+		machine_reply_free(client->router_reply);
 	free(client);
 }
 
@@ -24,9 +24,49 @@ od_client_pool_init(od_client_pool_t *pool)
 	pool->count_active  = 0;
 	pool->count_queue   = 0;
 	pool->count_pending = 0;
+	pool->queue_vtime   = 0;
 	od_list_init(&pool->active);
-	od_list_init(&pool->queue);
 	od_list_init(&pool->pending);
+	int i = 0;
+	for (; i < OD_CONFIG_PRIORITY_MAX; i++) {
+		od_list_init(&pool->queue[i]);
+		pool->count_queue_priority[i] = 0;
+		pool->queue_finish[i] = 0;
+	}
+}
+
+static inline void
+od_client_pool_enqueue(od_client_pool_t *pool, od_client_t *client)
+{
+	/* weighted fair queueing: client is tagged with a virtual
+	 * finish time, which grows slower for heavier classes */
+	int priority = od_client_priority_id(client);
+	uint64_t start = pool->queue_finish[priority];
+	if (start < pool->queue_vtime)
+		start = pool->queue_vtime;
+	client->priority_tag = start + OD_CLIENT_POOL_WFQ_SCALE /
+	                       od_client_priority_weight(client);
+	pool->queue_finish[priority] = client->priority_tag;
+	pool->count_queue_priority[priority]++;
+}
+
+static inline void
+od_client_pool_dequeue(od_client_pool_t *pool, od_client_t *client,
+                       od_client_state_t state)
+{
+	int priority = od_client_priority_id(client);
+	pool->count_queue_priority[priority]--;
+	if (state == OD_CLIENT_ACTIVE) {
+		/* client is served, advance virtual time */
+		if (client->priority_tag > pool->queue_vtime)
+			pool->queue_vtime = client->priority_tag;
+		return;
+	}
+	/* give unused share back to the class of the
+	 * timedout or killed client */
+	if (pool->queue_finish[priority] == client->priority_tag)
+		pool->queue_finish[priority] -= OD_CLIENT_POOL_WFQ_SCALE /
+		                                od_client_priority_weight(client);
 }
 
 void
@@ -42,6 +82,7 @@ od_client_pool_set(od_client_pool_t *pool, od_client_t *client,
 		pool->count_active--;
 		break;
 	case OD_CLIENT_QUEUE:
+		od_client_pool_dequeue(pool, client, state);
 		pool->count_queue--;
 		break;
 	case OD_CLIENT_PENDING:
@@ -57,7 +98,8 @@ od_client_pool_set(od_client_pool_t *pool, od_client_t *client,
 		pool->count_active++;
 		break;
 	case OD_CLIENT_QUEUE:
-		target = &pool->queue;
+		target = &pool->queue[od_client_priority_id(client)];
+		od_client_pool_enqueue(pool, client);
 		pool->count_queue++;
 		break;
 	case OD_CLIENT_PENDING:
@@ -83,9 +125,21 @@ od_client_pool_next(od_client_pool_t *pool, od_client_state_t state)
 		target_count = pool->count_active;
 		break;
 	case OD_CLIENT_QUEUE:
-		target = &pool->queue;
-		target_count = pool->count_queue;
-		break;
+	{
+		/* pick the class head with the smallest finish tag,
+		 * each class queue is FIFO */
+		od_client_t *next = NULL;
+		int i = 0;
+		for (; i < OD_CONFIG_PRIORITY_MAX; i++) {
+			if (pool->count_queue_priority[i] == 0)
+				continue;
+			od_client_t *head;
+			head = od_container_of(pool->queue[i].next, od_client_t, link_pool);
+			if (next == NULL || head->priority_tag < next->priority_tag)
+				next = head;
+		}
+		return next;
+	}
 	case OD_CLIENT_PENDING:
 		target = &pool->pending;
 		target_count = pool->count_pending;
@@ -101,6 +155,24 @@ od_client_pool_next(od_client_pool_t *pool, od_client_state_t state)
 	return client;
 }
 
+static inline od_client_t*
+od_client_pool_foreach_list(od_list_t *target,
+                            od_client_pool_cb_t callback,
+                            void *arg)
+{
+	od_client_t *client;
+	od_list_t *i, *n;
+	od_list_foreach_safe(target, i, n) {
+		client = od_container_of(i, od_client_t, link_pool);
+		int rc;
+		rc = callback(client, arg);
+		if (rc) {
+			return client;
+		}
+	}
+	return NULL;
+}
+
 od_client_t*
 od_client_pool_foreach(od_client_pool_t *pool,
                        od_client_state_t state,
@@ -113,8 +185,17 @@ od_client_pool_foreach(od_client_pool_t *pool,
 		target = &pool->active;
 		break;
 	case OD_CLIENT_QUEUE:
-		target = &pool->queue;
-		break;
+	{
+		int i = 0;
+		for (; i < OD_CONFIG_PRIORITY_MAX; i++) {
+			od_client_t *client;
+			client = od_client_pool_foreach_list(&pool->queue[i],
+			                                     callback, arg);
+			if (client)
+				return client;
+		}
+		return NULL;
+	}
 	case OD_CLIENT_PENDING:
 		target = &pool->pending;
 		break;
@@ -122,15 +203,5 @@ od_client_pool_foreach(od_client_pool_t *pool,
 		assert(0);
 		break;
 	}
-	od_client_t *client;
-	od_list_t *i, *n;
-	od_list_foreach_safe(target, i, n) {
-		client = od_container_of(i, od_client_t, link_pool);
-		int rc;
-		rc = callback(client, arg);
-		if (rc) {
-			return client;
-		}
-	}
-	return NULL;
+	return od_client_pool_foreach_list(target, callback, arg);
 }
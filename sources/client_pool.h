@@ -11,14 +11,21 @@ typedef struct od_client_pool od_client_pool_t;
 
 typedef int (*od_client_pool_cb_t)(od_client_t*, void*);
 
+/* virtual time cost of serving a client of weight 1 */
+#define OD_CLIENT_POOL_WFQ_SCALE 1048576
+
 struct od_client_pool
 {
 	od_list_t active;
-	od_list_t queue;
+	od_list_t queue[OD_CONFIG_PRIORITY_MAX];
 	od_list_t pending;
 	int       count_active;
 	int       count_queue;
+	int       count_queue_priority[OD_CONFIG_PRIORITY_MAX];
 	int       count_pending;
+	/* weighted fair queueing of waiting clients */
+	uint64_t  queue_vtime;
+	uint64_t  queue_finish[OD_CONFIG_PRIORITY_MAX];
 };
 
 void od_client_pool_init(od_client_pool_t*);
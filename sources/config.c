@@ -38,10 +38,14 @@ od_config_init(od_config_t *config)
 	config->log_syslog_ident = NULL;
 	config->log_syslog_facility = NULL;
 	config->readahead = 8192;
+	config->stream_threshold = 1048576;
+	config->copy_splice = 0;
 	config->nodelay = 1;
 	config->keepalive = 7200;
 	config->workers = 1;
 	config->resolvers = 1;
+	config->dns_ttl = 60;
+	config->dns_negative_ttl = 5;
 	config->client_max_set = 0;
 	config->client_max = 0;
 	config->cache_coroutine = 0;
@@ -49,12 +53,20 @@ od_config_init(od_config_t *config)
 	config->coroutine_stack_size = 4;
 	od_list_init(&config->storages);
 	od_list_init(&config->routes);
+	config->routes_index.buckets = NULL;
+	config->routes_index.buckets_count = 0;
+	config->routes_index.count = 0;
 	od_list_init(&config->listen);
+	od_list_init(&config->priorities);
+	config->priorities_count = 0;
 }
 
 static void
 od_config_listen_free(od_config_listen_t*);
 
+static void
+od_config_priority_free(od_config_priority_t*);
+
 void
 od_config_free(od_config_t *config)
 {
@@ -64,11 +76,17 @@ od_config_free(od_config_t *config)
 		route = od_container_of(i, od_config_route_t, link);
 		od_config_route_free(route);
 	}
+	free(config->routes_index.buckets);
 	od_list_foreach_safe(&config->listen, i, n) {
 		od_config_listen_t *listen;
 		listen = od_container_of(i, od_config_listen_t, link);
 		od_config_listen_free(listen);
 	}
+	od_list_foreach_safe(&config->priorities, i, n) {
+		od_config_priority_t *priority;
+		priority = od_container_of(i, od_config_priority_t, link);
+		od_config_priority_free(priority);
+	}
 	if (config->log_file)
 		free(config->log_file);
 	if (config->log_format)
@@ -93,6 +111,10 @@ od_config_listen_add(od_config_t *config)
 	memset(listen, 0, sizeof(*listen));
 	listen->port = 6432;
 	listen->backlog = 128;
+	listen->write_queue_high = 1048576;
+	listen->write_queue_low = 262144;
+	listen->tls_tickets = 1;
+	listen->tls_tickets_rotate = 3600;
 	od_list_init(&listen->link);
 	od_list_append(&config->listen, &listen->link);
 	return listen;
@@ -113,9 +135,80 @@ od_config_listen_free(od_config_listen_t *config)
 		free(config->tls_cert_file);
 	if (config->tls_protocols)
 		free(config->tls_protocols);
+	if (config->priority)
+		free(config->priority);
 	free(config);
 }
 
+od_config_priority_t*
+od_config_priority_add(od_config_t *config)
+{
+	od_config_priority_t *priority;
+	priority = (od_config_priority_t*)malloc(sizeof(*priority));
+	if (priority == NULL)
+		return NULL;
+	memset(priority, 0, sizeof(*priority));
+	priority->weight = 1;
+	od_list_init(&priority->link);
+	od_list_append(&config->priorities, &priority->link);
+	config->priorities_count++;
+	return priority;
+}
+
+static void
+od_config_priority_free(od_config_priority_t *priority)
+{
+	if (priority->name)
+		free(priority->name);
+	if (priority->application_name)
+		free(priority->application_name);
+	free(priority);
+}
+
+od_config_priority_t*
+od_config_priority_match(od_config_t *config, char *name)
+{
+	od_list_t *i;
+	od_list_foreach(&config->priorities, i) {
+		od_config_priority_t *priority;
+		priority = od_container_of(i, od_config_priority_t, link);
+		if (strcmp(priority->name, name) == 0)
+			return priority;
+	}
+	return NULL;
+}
+
+od_config_priority_t*
+od_config_priority_select(od_config_t *config, od_config_listen_t *listen,
+                          od_config_route_t *route, char *application_name)
+{
+	/* application_name class has precedence over the
+	 * listen and route ones */
+	od_config_priority_t *priority;
+	od_list_t *i;
+	if (application_name) {
+		od_list_foreach(&config->priorities, i) {
+			priority = od_container_of(i, od_config_priority_t, link);
+			if (priority->application_name == NULL)
+				continue;
+			if (strcmp(priority->application_name, application_name) == 0)
+				return priority;
+		}
+	}
+	if (listen && listen->priority) {
+		priority = od_config_priority_match(config, listen->priority);
+		if (priority)
+			return priority;
+	}
+	if (route->priority) {
+		priority = od_config_priority_match(config, route->priority);
+		if (priority)
+			return priority;
+	}
+	/* can be NULL, which means implicit default class */
+	return od_config_priority_match(config, "default");
+}
+
 static inline od_config_storage_t*
 od_config_storage_allocate(void)
 {
@@ -124,10 +217,22 @@ od_config_storage_allocate(void)
 	if (storage == NULL)
 		return NULL;
 	memset(storage, 0, sizeof(*storage));
+	storage->host_backoff = 10;
 	od_list_init(&storage->link);
 	return storage;
 }
 
+static inline void
+od_config_storage_endpoints_free(od_config_storage_t *storage)
+{
+	int i = 0;
+	for (; i < storage->endpoints_count; i++)
+		free(storage->endpoints[i].host);
+	free(storage->endpoints);
+	storage->endpoints = NULL;
+	storage->endpoints_count = 0;
+}
+
 void
 od_config_storage_free(od_config_storage_t *storage)
 {
@@ -137,6 +242,9 @@ od_config_storage_free(od_config_storage_t *storage)
 		free(storage->type);
 	if (storage->host)
 		free(storage->host);
+	od_config_storage_endpoints_free(storage);
+	if (storage->balance)
+		free(storage->balance);
 	if (storage->tls)
 		free(storage->tls);
 	if (storage->tls_ca_file)
@@ -195,6 +303,29 @@ od_config_storage_copy(od_config_storage_t *storage)
 			goto error;
 	}
 	copy->port = storage->port;
+	if (storage->endpoints_count > 0) {
+		copy->endpoints = malloc(sizeof(od_config_endpoint_t) *
+		                         storage->endpoints_count);
+		if (copy->endpoints == NULL)
+			goto error;
+		int i = 0;
+		for (; i < storage->endpoints_count; i++) {
+			od_config_endpoint_t *endpoint = &copy->endpoints[i];
+			endpoint->host = strdup(storage->endpoints[i].host);
+			if (endpoint->host == NULL)
+				goto error;
+			endpoint->port = storage->endpoints[i].port;
+			copy->endpoints_count++;
+		}
+	}
+	if (storage->balance) {
+		copy->balance = strdup(storage->balance);
+		if (copy->balance == NULL)
+			goto error;
+	}
+	copy->balance_policy = storage->balance_policy;
+	copy->host_backoff = storage->host_backoff;
+	copy->max_connections = storage->max_connections;
 	copy->tls_mode = storage->tls_mode;
 	if (storage->tls) {
 		copy->tls = strdup(storage->tls);
@@ -272,14 +403,18 @@ od_config_route_add(od_config_t *config)
 	memset(route, 0, sizeof(*route));
 	route->pool_size = 0;
 	route->pool_timeout = 0;
+	route->pool_preconnect_rate = 8;
+	route->pool_size_min = 1;
 	route->pool_cancel = 1;
 	route->pool_rollback = 1;
+	route->prepared_statements_max = 1024;
 	route->obsolete = 0;
 	route->mark = 0;
 	route->refs = 0;
 	route->auth_common_name_default = 0;
 	route->auth_common_names_count = 0;
 	od_list_init(&route->auth_common_names);
+	od_list_init(&route->link_index);
 	od_list_init(&route->link);
 	od_list_append(&config->routes, &route->link);
 	return route;
@@ -310,6 +445,10 @@ od_config_route_free(od_config_route_t *route)
 		od_config_storage_free(route->storage);
 	if (route->storage_name)
 		free(route->storage_name);
+	if (route->storage_replica)
+		od_config_storage_free(route->storage_replica);
+	if (route->storage_replica_name)
+		free(route->storage_replica_name);
 	if (route->storage_db)
 		free(route->storage_db);
 	if (route->storage_user)
@@ -318,6 +457,10 @@ od_config_route_free(od_config_route_t *route)
 		free(route->storage_password);
 	if (route->pool_sz)
 		free(route->pool_sz);
+	if (route->pool_policy_sz)
+		free(route->pool_policy_sz);
+	if (route->priority)
+		free(route->priority);
 	od_list_t *i, *n;
 	od_list_foreach_safe(&route->auth_common_names, i, n) {
 		od_config_auth_t *auth;
@@ -345,55 +488,93 @@ od_config_route_unref(od_config_route_t *route)
 		od_config_route_free(route);
 }
 
-od_config_route_t*
-od_config_route_forward(od_config_t *config, char *db_name, char *user_name)
+static inline uint64_t
+od_config_route_hash(char *db_name, char *user_name)
 {
-	od_config_route_t *route_db_user = NULL;
-	od_config_route_t *route_db_default = NULL;
-	od_config_route_t *route_default_user = NULL;
-	od_config_route_t *route_default_default = NULL;
+	uint64_t hash;
+	hash  = od_hash(db_name, strlen(db_name));
+	hash ^= od_hash(user_name, strlen(user_name)) * 1099511628211ULL;
+	return hash;
+}
 
-	od_list_t *i;
-	od_list_foreach(&config->routes, i) {
-		od_config_route_t *route;
-		route = od_container_of(i, od_config_route_t, link);
-		if (route->obsolete)
-			continue;
-		if (route->db_is_default) {
-			if (route->user_is_default)
-				route_default_default = route;
-			else
-			if (strcmp(route->user_name, user_name) == 0)
-				route_default_user = route;
-		} else
-		if (strcmp(route->db_name, db_name) == 0) {
-			if (route->user_is_default)
-				route_db_default = route;
-			else
-			if (strcmp(route->user_name, user_name) == 0)
-				route_db_user = route;
+static inline int
+od_config_route_index_resize(od_config_index_t *index, int buckets_count)
+{
+	od_list_t *buckets;
+	buckets = malloc(sizeof(od_list_t) * buckets_count);
+	if (buckets == NULL)
+		return -1;
+	int i = 0;
+	for (; i < buckets_count; i++)
+		od_list_init(&buckets[i]);
+
+	/* move routes to the new buckets */
+	for (i = 0; i < index->buckets_count; i++) {
+		od_list_t *j, *n;
+		od_list_foreach_safe(&index->buckets[i], j, n) {
+			od_config_route_t *route;
+			route = od_container_of(j, od_config_route_t, link_index);
+			od_list_append(&buckets[route->index_hash & (buckets_count - 1)],
+			               &route->link_index);
 		}
 	}
+	free(index->buckets);
+	index->buckets = buckets;
+	index->buckets_count = buckets_count;
+	return 0;
+}
 
-	if (route_db_user)
-		return route_db_user;
-
-	if (route_db_default)
-		return route_db_default;
-
-	if (route_default_user)
-		return route_default_user;
+int
+od_config_route_index(od_config_t *config, od_config_route_t *route)
+{
+	/* add active route to the index, route names must be set */
+	od_config_index_t *index = &config->routes_index;
+	if (index->count >= index->buckets_count) {
+		int buckets_count = index->buckets_count * 2;
+		if (buckets_count == 0)
+			buckets_count = 16;
+		int rc;
+		rc = od_config_route_index_resize(index, buckets_count);
+		if (rc == -1 && index->buckets_count == 0)
+			return -1;
+	}
+	route->index_hash = od_config_route_hash(route->db_name, route->user_name);
+	od_list_unlink(&route->link_index);
+	od_list_init(&route->link_index);
+	od_list_append(&index->buckets[route->index_hash & (index->buckets_count - 1)],
+	               &route->link_index);
+	index->count++;
+	return 0;
+}
 
-	return route_default_default;
+static inline void
+od_config_route_unindex(od_config_t *config, od_config_route_t *route)
+{
+	if (od_list_empty(&route->link_index))
+		return;
+	od_list_unlink(&route->link_index);
+	od_list_init(&route->link_index);
+	assert(config->routes_index.count > 0);
+	config->routes_index.count--;
 }
 
 od_config_route_t*
 od_config_route_match(od_config_t *config, char *db_name, char *user_name)
 {
+	/* match active route */
+	od_config_index_t *index = &config->routes_index;
+	if (index->count == 0)
+		return NULL;
+	uint64_t hash;
+	hash = od_config_route_hash(db_name, user_name);
+	od_list_t *bucket;
+	bucket = &index->buckets[hash & (index->buckets_count - 1)];
 	od_list_t *i;
-	od_list_foreach(&config->routes, i) {
+	od_list_foreach(bucket, i) {
 		od_config_route_t *route;
-		route = od_container_of(i, od_config_route_t, link);
+		route = od_container_of(i, od_config_route_t, link_index);
+		if (route->index_hash != hash)
+			continue;
 		if (strcmp(route->db_name, db_name) == 0 &&
 		    strcmp(route->user_name, user_name) == 0)
 			return route;
@@ -401,19 +582,33 @@ od_config_route_match(od_config_t *config, char *db_name, char *user_name)
 	return NULL;
 }
 
-static inline od_config_route_t*
-od_config_route_match_active(od_config_t *config, char *db_name, char *user_name)
+od_config_route_t*
+od_config_route_forward(od_config_t *config, char *db_name, char *user_name)
 {
-	od_list_t *i;
-	od_list_foreach(&config->routes, i) {
-		od_config_route_t *route;
-		route = od_container_of(i, od_config_route_t, link);
-		if (route->obsolete)
-			continue;
-		if (strcmp(route->db_name, db_name) == 0 &&
-		    strcmp(route->user_name, user_name) == 0)
-			return route;
-	}
+	/* default routes are indexed by the 'default' name, so
+	 * each route tier is a single index lookup */
+	od_config_route_t *route;
+
+	/* database.user */
+	route = od_config_route_match(config, db_name, user_name);
+	if (route && !route->db_is_default && !route->user_is_default)
+		return route;
+
+	/* database.default */
+	route = od_config_route_match(config, db_name, "default");
+	if (route && !route->db_is_default && route->user_is_default)
+		return route;
+
+	/* default.user */
+	route = od_config_route_match(config, "default", user_name);
+	if (route && route->db_is_default && !route->user_is_default)
+		return route;
+
+	/* default.default */
+	route = od_config_route_match(config, "default", "default");
+	if (route && route->db_is_default && route->user_is_default)
+		return route;
+
 	return NULL;
 }
 
@@ -437,6 +632,22 @@ od_config_storage_compare(od_config_storage_t *a, od_config_storage_t *b)
 	if (a->port != b->port)
 		return 0;
 
+	/* name */
+	if (strcmp(a->name, b->name) != 0)
+		return 0;
+
+	/* balance */
+	if (a->balance_policy != b->balance_policy)
+		return 0;
+
+	/* host_backoff */
+	if (a->host_backoff != b->host_backoff)
+		return 0;
+
+	/* max_connections */
+	if (a->max_connections != b->max_connections)
+		return 0;
+
 	/* tls_mode */
 	if (a->tls_mode != b->tls_mode)
 		return 0;
@@ -555,6 +766,17 @@ od_config_route_compare(od_config_route_t *a, od_config_route_t *b)
 	if (! od_config_storage_compare(a->storage, b->storage))
 		return 0;
 
+	/* storage_replica */
+	if (a->storage_replica && b->storage_replica) {
+		if (strcmp(a->storage_replica_name, b->storage_replica_name) != 0)
+			return 0;
+		if (! od_config_storage_compare(a->storage_replica, b->storage_replica))
+			return 0;
+	} else
+	if (a->storage_replica || b->storage_replica) {
+		return 0;
+	}
+
 	/* storage_db */
 	if (a->storage_db && b->storage_db) {
 		if (strcmp(a->storage_db, b->storage_db) != 0)
@@ -598,6 +820,26 @@ od_config_route_compare(od_config_route_t *a, od_config_route_t *b)
 	if (a->pool_ttl != b->pool_ttl)
 		return 0;
 
+	/* pool_min_idle */
+	if (a->pool_min_idle != b->pool_min_idle)
+		return 0;
+
+	/* pool_min_size */
+	if (a->pool_min_size != b->pool_min_size)
+		return 0;
+
+	/* pool_preconnect_rate */
+	if (a->pool_preconnect_rate != b->pool_preconnect_rate)
+		return 0;
+
+	/* pool_adaptive */
+	if (a->pool_adaptive != b->pool_adaptive)
+		return 0;
+
+	/* pool_size_min */
+	if (a->pool_size_min != b->pool_size_min)
+		return 0;
+
 	/* pool_cancel */
 	if (a->pool_cancel != b->pool_cancel)
 		return 0;
@@ -606,6 +848,27 @@ od_config_route_compare(od_config_route_t *a, od_config_route_t *b)
 	if (a->pool_rollback != b->pool_rollback)
 		return 0;
 
+	/* pool_policy */
+	if (a->pool_policy != b->pool_policy)
+		return 0;
+
+	/* prepared_statements */
+	if (a->prepared_statements != b->prepared_statements)
+		return 0;
+
+	/* prepared_statements_max */
+	if (a->prepared_statements_max != b->prepared_statements_max)
+		return 0;
+
+	/* priority */
+	if (a->priority && b->priority) {
+		if (strcmp(a->priority, b->priority) != 0)
+			return 0;
+	} else
+	if (a->priority || b->priority) {
+		return 0;
+	}
+
 	/* client_fwd_error */
 	if (a->client_fwd_error != b->client_fwd_error)
 		return 0;
@@ -614,6 +877,14 @@ od_config_route_compare(od_config_route_t *a, od_config_route_t *b)
 	if (a->client_max != b->client_max)
 		return 0;
 
+	/* write_queue_high */
+	if (a->write_queue_high != b->write_queue_high)
+		return 0;
+
+	/* write_queue_low */
+	if (a->write_queue_low != b->write_queue_low)
+		return 0;
+
 	return 1;
 }
 
@@ -633,7 +904,8 @@ od_config_merge(od_config_t *config, od_logger_t *logger, od_config_t *src)
 		count_mark++;
 	}
 
-	/* select new routes */
+	/* select new routes, routes are compared only
+	 * with the active route of the same name */
 	od_list_t *n;
 	od_list_foreach_safe(&src->routes, i, n)
 	{
@@ -642,7 +914,7 @@ od_config_merge(od_config_t *config, od_logger_t *logger, od_config_t *src)
 
 		/* find and compare origin route */
 		od_config_route_t *origin;
-		origin = od_config_route_match_active(config, route->db_name, route->user_name);
+		origin = od_config_route_match(config, route->db_name, route->user_name);
 		if (origin) {
 			if (od_config_route_compare(origin, route)) {
 				origin->mark = 0;
@@ -653,15 +925,23 @@ od_config_merge(od_config_t *config, od_logger_t *logger, od_config_t *src)
 			/* add new version, origin version still exists */
 			od_log(logger, "config", NULL, NULL,
 			       "route updated %s.%s", origin->db_name, origin->user_name);
+			od_config_route_unindex(config, origin);
 		} else {
 			/* add new version */
 			od_log(logger, "config", NULL, NULL,
 			       "route added %s.%s", route->db_name, route->user_name);
 		}
 
+		od_config_route_unindex(src, route);
 		od_list_unlink(&route->link);
 		od_list_init(&route->link);
 		od_list_append(&config->routes, &route->link);
+		int rc;
+		rc = od_config_route_index(config, route);
+		if (rc == -1)
+			od_error(logger, "config", NULL, NULL,
+			         "failed to index route %s.%s", route->db_name,
+			         route->user_name);
 		count_new++;
 	}
 
@@ -675,8 +955,11 @@ od_config_merge(od_config_t *config, od_logger_t *logger, od_config_t *src)
 			int is_obsolete = route->obsolete || route->mark;
 			route->mark = 0;
 			route->obsolete = is_obsolete;
+			if (! is_obsolete)
+				continue;
+			od_config_route_unindex(config, route);
 
-			if (is_obsolete && route->refs == 0) {
+			if (route->refs == 0) {
 				od_config_route_free(route);
 				count_deleted++;
 				count_mark--;
@@ -692,6 +975,86 @@ od_config_merge(od_config_t *config, od_logger_t *logger, od_config_t *src)
 	return count_new + count_mark + count_deleted;
 }
 
+static inline int
+od_config_storage_endpoints(od_config_storage_t *storage)
+{
+	/* parse comma separated host list, each host can
+	 * set its own port: host, host:port or [ipv6]:port */
+	od_config_storage_endpoints_free(storage);
+	int count = 1;
+	char *pos = storage->host;
+	for (; *pos; pos++)
+		if (*pos == ',')
+			count++;
+	storage->endpoints = malloc(sizeof(od_config_endpoint_t) * count);
+	if (storage->endpoints == NULL)
+		return -1;
+
+	char *start = storage->host;
+	for (;;)
+	{
+		char *next = strchr(start, ',');
+		char *end = next ? next : start + strlen(start);
+		while (start < end && isspace(*start))
+			start++;
+		while (end > start && isspace(end[-1]))
+			end--;
+
+		/* empty host segment */
+		if (end <= start)
+			return -1;
+		char  *host = start;
+		size_t host_len = (size_t)(end - start);
+		char  *port = NULL;
+		if (*host == '[') {
+			char *bracket = memchr(host, ']', host_len);
+			if (bracket == NULL)
+				return -1;
+			if (bracket + 1 < end) {
+				if (bracket[1] != ':')
+					return -1;
+				port = bracket + 2;
+			}
+			host++;
+			host_len = (size_t)(bracket - host);
+		} else {
+			/* more than one colon is an ipv6 address without port */
+			char *colon = memchr(host, ':', host_len);
+			if (colon && memchr(colon + 1, ':', (size_t)(end - colon - 1)) == NULL) {
+				port = colon + 1;
+				host_len = (size_t)(colon - host);
+			}
+		}
+		if (host_len == 0)
+			return -1;
+
+		od_config_endpoint_t *endpoint;
+		endpoint = &storage->endpoints[storage->endpoints_count];
+		endpoint->port = storage->port;
+		if (port) {
+			if (port == end)
+				return -1;
+			endpoint->port = 0;
+			for (; port < end; port++) {
+				if (! isdigit(*port))
+					return -1;
+				endpoint->port = endpoint->port * 10 + (*port - '0');
+				if (endpoint->port > 65535)
+					return -1;
+			}
+		}
+		endpoint->host = strndup(host, host_len);
+		if (endpoint->host == NULL)
+			return -1;
+		storage->endpoints_count++;
+
+		if (next == NULL)
+			break;
+		start = next + 1;
+	}
+	return 0;
+}
+
 int
 od_config_validate(od_config_t *config, od_logger_t *logger)
 {
@@ -707,6 +1070,12 @@ od_config_validate(od_config_t *config, od_logger_t *logger)
 		return -1;
 	}
 
+	/* dns_ttl */
+	if (config->dns_ttl < 0 || config->dns_negative_ttl < 0) {
+		od_error(logger, "config", NULL, NULL, "bad dns ttl value");
+		return -1;
+	}
+
 	/* coroutine_stack_size */
 	if (config->coroutine_stack_size < 4) {
 		od_error(logger, "config", NULL, NULL, "bad coroutine_stack_size number");
@@ -727,17 +1096,61 @@ od_config_validate(od_config_t *config, od_logger_t *logger)
 		}
 	}
 
+	/* stream_threshold */
+	if (config->stream_threshold < 0) {
+		od_error(logger, "config", NULL, NULL,
+		         "stream_threshold must not be negative");
+		return -1;
+	}
+
+	/* priorities, the default class always has id zero */
+	int priority_id = 1;
+	od_list_t *i;
+	od_list_foreach(&config->priorities, i)
+	{
+		od_config_priority_t *priority;
+		priority = od_container_of(i, od_config_priority_t, link);
+		if (priority->weight <= 0) {
+			od_error(logger, "config", NULL, NULL,
+			         "priority '%s': weight must be positive",
+			         priority->name);
+			return -1;
+		}
+		if (od_config_priority_match(config, priority->name) != priority) {
+			od_error(logger, "config", NULL, NULL,
+			         "priority '%s': is redefined", priority->name);
+			return -1;
+		}
+		if (strcmp(priority->name, "default") == 0) {
+			priority->id = 0;
+			continue;
+		}
+		if (priority_id == OD_CONFIG_PRIORITY_MAX) {
+			od_error(logger, "config", NULL, NULL,
+			         "too many priority classes defined, maximum is %d",
+			         OD_CONFIG_PRIORITY_MAX);
+			return -1;
+		}
+		priority->id = priority_id++;
+	}
+
 	/* listen */
 	if (od_list_empty(&config->listen)) {
 		od_error(logger, "config", NULL, NULL, "no listen servers defined");
 		return -1;
 	}
 
-	od_list_t *i;
 	od_list_foreach(&config->listen, i)
 	{
 		od_config_listen_t *listen;
 		listen = od_container_of(i, od_config_listen_t, link);
+		if (listen->priority &&
+		    od_config_priority_match(config, listen->priority) == NULL) {
+			od_error(logger, "config", NULL, NULL,
+			         "listen: priority '%s' is not defined",
+			         listen->priority);
+			return -1;
+		}
 		if (listen->host == NULL) {
 			if (config->unix_socket_dir == NULL) {
 				od_error(logger, "config", NULL, NULL,
@@ -767,6 +1180,21 @@ od_config_validate(od_config_t *config, od_logger_t *logger)
 				return -1;
 			}
 		}
+
+		/* tls session tickets */
+		if (listen->tls_tickets && listen->tls_tickets_rotate <= 0) {
+			od_error(logger, "config", NULL, NULL,
+			         "listen: tls_tickets_rotate must be positive");
+			return -1;
+		}
+
+		/* write queue watermarks */
+		if (listen->write_queue_high > 0 &&
+		    listen->write_queue_low >= listen->write_queue_high) {
+			od_error(logger, "config", NULL, NULL,
+			         "listen: write_queue_low must be less than write_queue_high");
+			return -1;
+		}
 	}
 
 	/* storages */
@@ -789,6 +1217,12 @@ od_config_validate(od_config_t *config, od_logger_t *logger)
 			od_error(logger, "config", NULL, NULL, "unknown storage type");
 			return -1;
 		}
+		if (storage->max_connections < 0) {
+			od_error(logger, "config", NULL, NULL,
+			         "storage '%s': bad max_connections number",
+			         storage->name);
+			return -1;
+		}
 		if (storage->storage_type == OD_STORAGE_TYPE_REMOTE) {
 			if (storage->host == NULL) {
 				if (config->unix_socket_dir == NULL) {
@@ -797,8 +1231,39 @@ od_config_validate(od_config_t *config, od_logger_t *logger)
 					         storage->name);
 					return -1;
 				}
+			} else {
+				int rc;
+				rc = od_config_storage_endpoints(storage);
+				if (rc == -1) {
+					od_error(logger, "config", NULL, NULL,
+					         "storage '%s': bad host list",
+					         storage->name);
+					return -1;
+				}
 			}
 		}
+		if (storage->balance) {
+			if (strcmp(storage->balance, "round_robin") == 0) {
+				storage->balance_policy = OD_BALANCE_ROUND_ROBIN;
+			} else
+			if (strcmp(storage->balance, "least_connections") == 0) {
+				storage->balance_policy = OD_BALANCE_LEAST_CONNECTIONS;
+			} else
+			if (strcmp(storage->balance, "least_latency") == 0) {
+				storage->balance_policy = OD_BALANCE_LEAST_LATENCY;
+			} else {
+				od_error(logger, "config", NULL, NULL,
+				         "storage '%s': unknown balance policy",
+				         storage->name);
+				return -1;
+			}
+		}
+		if (storage->host_backoff < 0) {
+			od_error(logger, "config", NULL, NULL,
+			         "storage '%s': bad host_backoff value",
+			         storage->name);
+			return -1;
+		}
 		if (storage->tls) {
 			if (strcmp(storage->tls, "disable") == 0) {
 				storage->tls_mode = OD_TLS_DISABLE;
@@ -846,6 +1311,28 @@ od_config_validate(od_config_t *config, od_logger_t *logger)
 		if (route->storage == NULL)
 			return -1;
 
+		/* read-only transactions storage */
+		if (route->storage_replica_name) {
+			storage = od_config_storage_match(config, route->storage_replica_name);
+			if (storage == NULL) {
+				od_error(logger, "config", NULL, NULL,
+				         "route '%s.%s': no route storage '%s' found",
+				         route->db_name, route->user_name,
+				         route->storage_replica_name);
+				return -1;
+			}
+			if (storage->storage_type != OD_STORAGE_TYPE_REMOTE ||
+			    route->storage->storage_type != OD_STORAGE_TYPE_REMOTE) {
+				od_error(logger, "config", NULL, NULL,
+				         "route '%s.%s': storage_replica requires remote storages",
+				         route->db_name, route->user_name);
+				return -1;
+			}
+			route->storage_replica = od_config_storage_copy(storage);
+			if (route->storage_replica == NULL)
+				return -1;
+		}
+
 		/* pooling mode */
 		if (! route->pool_sz) {
 			od_error(logger, "config", NULL, NULL,
@@ -858,6 +1345,9 @@ od_config_validate(od_config_t *config, od_logger_t *logger)
 		} else
 		if (strcmp(route->pool_sz, "transaction") == 0) {
 			route->pool = OD_POOL_TYPE_TRANSACTION;
+		} else
+		if (strcmp(route->pool_sz, "statement") == 0) {
+			route->pool = OD_POOL_TYPE_STATEMENT;
 		} else {
 			od_error(logger, "config", NULL, NULL,
 			         "route '%s.%s': unknown pooling mode",
@@ -865,6 +1355,81 @@ od_config_validate(od_config_t *config, od_logger_t *logger)
 			return -1;
 		}
 
+		/* idle server selection policy */
+		if (route->pool_policy_sz) {
+			if (strcmp(route->pool_policy_sz, "lifo") == 0) {
+				route->pool_policy = OD_POOL_POLICY_LIFO;
+			} else
+			if (strcmp(route->pool_policy_sz, "client") == 0) {
+				route->pool_policy = OD_POOL_POLICY_CLIENT;
+			} else
+			if (strcmp(route->pool_policy_sz, "worker") == 0) {
+				route->pool_policy = OD_POOL_POLICY_WORKER;
+			} else {
+				od_error(logger, "config", NULL, NULL,
+				         "route '%s.%s': unknown pool policy",
+				         route->db_name, route->user_name);
+				return -1;
+			}
+		}
+
+		/* minimum pool size */
+		if (route->pool_size > 0 &&
+		    (route->pool_min_idle > route->pool_size ||
+		     route->pool_min_size > route->pool_size)) {
+			od_error(logger, "config", NULL, NULL,
+			         "route '%s.%s': pool_min_idle and pool_min_size must not exceed pool_size",
+			         route->db_name, route->user_name);
+			return -1;
+		}
+		/* adaptive pool size */
+		if (route->pool_adaptive) {
+			if (route->pool_size <= 0) {
+				od_error(logger, "config", NULL, NULL,
+				         "route '%s.%s': pool_adaptive requires pool_size",
+				         route->db_name, route->user_name);
+				return -1;
+			}
+			if (route->pool_size_min <= 0 ||
+			    route->pool_size_min > route->pool_size) {
+				od_error(logger, "config", NULL, NULL,
+				         "route '%s.%s': pool_size_min must be positive and not exceed pool_size",
+				         route->db_name, route->user_name);
+				return -1;
+			}
+		}
+		if (route->prepared_statements_max < 0) {
+			od_error(logger, "config", NULL, NULL,
+			         "route '%s.%s': prepared_statements_max must not be negative",
+			         route->db_name, route->user_name);
+			return -1;
+		}
+		if ((route->pool_min_idle || route->pool_min_size) &&
+		    route->pool_preconnect_rate <= 0) {
+			od_error(logger, "config", NULL, NULL,
+			         "route '%s.%s': pool_preconnect_rate must be positive",
+			         route->db_name, route->user_name);
+			return -1;
+		}
+
+		/* priority class */
+		if (route->priority &&
+		    od_config_priority_match(config, route->priority) == NULL) {
+			od_error(logger, "config", NULL, NULL,
+			         "route '%s.%s': priority '%s' is not defined",
+			         route->db_name, route->user_name, route->priority);
+			return -1;
+		}
+
+		/* write queue watermarks */
+		if (route->write_queue_high > 0 &&
+		    route->write_queue_low >= route->write_queue_high) {
+			od_error(logger, "config", NULL, NULL,
+			         "route '%s.%s': write_queue_low must be less than write_queue_high",
+			         route->db_name, route->user_name);
+			return -1;
+		}
+
 		/* auth */
 		if (! route->auth) {
 			od_error(logger, "config", NULL, NULL,
@@ -992,6 +1557,11 @@ od_config_print(od_config_t *config, od_logger_t *logger, int routes_only)
 	       "stats_interval       %d", config->stats_interval);
 	od_log(logger, "config", NULL, NULL,
 	       "readahead            %d", config->readahead);
+	od_log(logger, "config", NULL, NULL,
+	       "stream_threshold     %d", config->stream_threshold);
+	od_log(logger, "config", NULL, NULL,
+	       "copy_splice          %s",
+	       od_config_yes_no(config->copy_splice));
 	od_log(logger, "config", NULL, NULL,
 	       "nodelay              %s",
 	       od_config_yes_no(config->nodelay));
@@ -1010,6 +1580,10 @@ od_config_print(od_config_t *config, od_logger_t *logger, int routes_only)
 	       "workers              %d", config->workers);
 	od_log(logger, "config", NULL, NULL,
 	       "resolvers            %d", config->resolvers);
+	od_log(logger, "config", NULL, NULL,
+	       "dns_ttl              %d", config->dns_ttl);
+	od_log(logger, "config", NULL, NULL,
+	       "dns_negative_ttl     %d", config->dns_negative_ttl);
 	od_log(logger, "config", NULL, NULL, "");
 	od_list_t *i;
 	od_list_foreach(&config->listen, i)
@@ -1023,6 +1597,10 @@ od_config_print(od_config_t *config, od_logger_t *logger, int routes_only)
 		       "  port             %d", listen->port);
 		od_log(logger, "config", NULL, NULL,
 		       "  backlog          %d", listen->backlog);
+		od_log(logger, "config", NULL, NULL,
+		       "  write_queue_high %d", listen->write_queue_high);
+		od_log(logger, "config", NULL, NULL,
+		       "  write_queue_low  %d", listen->write_queue_low);
 		if (listen->tls)
 			od_log(logger, "config", NULL, NULL,
 			       "  tls              %s", listen->tls);
@@ -1038,6 +1616,34 @@ od_config_print(od_config_t *config, od_logger_t *logger, int routes_only)
 		if (listen->tls_protocols)
 			od_log(logger, "config", NULL, NULL,
 			       "  tls_protocols    %s", listen->tls_protocols);
+		if (listen->tls_mode != OD_TLS_DISABLE) {
+			od_log(logger, "config", NULL, NULL,
+			       "  tls_tickets      %s",
+			       listen->tls_tickets ? "yes" : "no");
+			od_log(logger, "config", NULL, NULL,
+			       "  tls_tickets_rotate %d", listen->tls_tickets_rotate);
+		}
+		if (listen->priority)
+			od_log(logger, "config", NULL, NULL,
+			       "  priority         %s", listen->priority);
+		if (listen->read_only)
+			od_log(logger, "config", NULL, NULL,
+			       "  read_only        yes");
+		od_log(logger, "config", NULL, NULL, "");
+	}
+	od_list_foreach(&config->priorities, i)
+	{
+		od_config_priority_t *priority;
+		priority = od_container_of(i, od_config_priority_t, link);
+		od_log(logger, "config", NULL, NULL, "priority %s", priority->name);
+		od_log(logger, "config", NULL, NULL,
+		       "  weight           %d", priority->weight);
+		if (priority->pool_timeout_set)
+			od_log(logger, "config", NULL, NULL,
+			       "  pool_timeout     %d", priority->pool_timeout);
+		if (priority->application_name)
+			od_log(logger, "config", NULL, NULL,
+			       "  application_name %s", priority->application_name);
 		od_log(logger, "config", NULL, NULL, "");
 	}
 log_routes:;
@@ -1085,15 +1691,47 @@ log_routes:;
 		       "  pool_timeout     %d", route->pool_timeout);
 		od_log(logger, "config", NULL, NULL,
 		       "  pool_ttl         %d", route->pool_ttl);
+		if (route->pool_min_idle || route->pool_min_size) {
+			od_log(logger, "config", NULL, NULL,
+			       "  pool_min_idle    %d", route->pool_min_idle);
+			od_log(logger, "config", NULL, NULL,
+			       "  pool_min_size    %d", route->pool_min_size);
+			od_log(logger, "config", NULL, NULL,
+			       "  pool_preconnect_rate %d", route->pool_preconnect_rate);
+		}
+		if (route->pool_adaptive) {
+			od_log(logger, "config", NULL, NULL,
+			       "  pool_adaptive    yes");
+			od_log(logger, "config", NULL, NULL,
+			       "  pool_size_min    %d", route->pool_size_min);
+		}
 		od_log(logger, "config", NULL, NULL,
 		       "  pool_cancel      %s",
 			   route->pool_cancel ? "yes" : "no");
 		od_log(logger, "config", NULL, NULL,
 		       "  pool_rollback    %s",
 			   route->pool_rollback ? "yes" : "no");
+		if (route->pool_policy_sz)
+			od_log(logger, "config", NULL, NULL,
+			       "  pool_policy      %s", route->pool_policy_sz);
+		od_log(logger, "config", NULL, NULL,
+		       "  prepared_statements %s",
+			   route->prepared_statements ? "yes" : "no");
+		if (route->prepared_statements)
+			od_log(logger, "config", NULL, NULL,
+			       "  prepared_statements_max %d", route->prepared_statements_max);
+		if (route->priority)
+			od_log(logger, "config", NULL, NULL,
+			       "  priority         %s", route->priority);
 		if (route->client_max_set)
 			od_log(logger, "config", NULL, NULL,
 			       "  client_max       %d", route->client_max);
+		if (route->write_queue_high > 0) {
+			od_log(logger, "config", NULL, NULL,
+			       "  write_queue_high %d", route->write_queue_high);
+			od_log(logger, "config", NULL, NULL,
+			       "  write_queue_low  %d", route->write_queue_low);
+		}
 		od_log(logger, "config", NULL, NULL,
 		       "  client_fwd_error %s",
 		       od_config_yes_no(route->client_fwd_error));
@@ -1106,6 +1744,16 @@ log_routes:;
 		       route->storage->host ? route->storage->host : "<unix socket>");
 		od_log(logger, "config", NULL, NULL,
 		       "  port             %d", route->storage->port);
+		if (route->storage->endpoints_count > 1) {
+			od_log(logger, "config", NULL, NULL,
+			       "  balance          %s",
+			       route->storage->balance ? route->storage->balance : "round_robin");
+			od_log(logger, "config", NULL, NULL,
+			       "  host_backoff     %d", route->storage->host_backoff);
+		}
+		if (route->storage->max_connections)
+			od_log(logger, "config", NULL, NULL,
+			       "  max_connections  %d", route->storage->max_connections);
 		if (route->storage->tls)
 			od_log(logger, "config", NULL, NULL,
 			       "  tls              %s", route->storage->tls);
@@ -1121,6 +1769,9 @@ log_routes:;
 		if (route->storage->tls_protocols)
 			od_log(logger, "config", NULL, NULL,
 			       "  tls_protocols    %s", route->storage->tls_protocols);
+		if (route->storage_replica_name)
+			od_log(logger, "config", NULL, NULL,
+			       "  storage_replica  %s", route->storage_replica_name);
 		if (route->storage_db)
 			od_log(logger, "config", NULL, NULL,
 			       "  storage_db       %s", route->storage_db);
@@ -7,11 +7,18 @@
  * Scalable PostgreSQL connection pooler.
 */
 
-typedef struct od_config_storage od_config_storage_t;
-typedef struct od_config_route   od_config_route_t;
-typedef struct od_config_listen  od_config_listen_t;
-typedef struct od_config_auth    od_config_auth_t;
-typedef struct od_config         od_config_t;
+typedef struct od_config_endpoint od_config_endpoint_t;
+typedef struct od_config_storage  od_config_storage_t;
+typedef struct od_config_route    od_config_route_t;
+typedef struct od_config_listen   od_config_listen_t;
+typedef struct od_config_priority od_config_priority_t;
+typedef struct od_config_auth     od_config_auth_t;
+typedef struct od_config_index    od_config_index_t;
+typedef struct od_config          od_config_t;
+
+/* maximum number of client priority classes,
+ * including the default one */
+#define OD_CONFIG_PRIORITY_MAX 8
 
 typedef enum
 {
@@ -35,29 +42,75 @@ typedef enum
 typedef enum
 {
 	OD_POOL_TYPE_SESSION,
-	OD_POOL_TYPE_TRANSACTION
+	OD_POOL_TYPE_TRANSACTION,
+	OD_POOL_TYPE_STATEMENT
 } od_pool_type_t;
 
+typedef enum
+{
+	OD_POOL_POLICY_LIFO,
+	OD_POOL_POLICY_CLIENT,
+	OD_POOL_POLICY_WORKER
+} od_pool_policy_t;
+
 typedef enum
 {
 	OD_STORAGE_TYPE_REMOTE,
 	OD_STORAGE_TYPE_LOCAL
 } od_storage_type_t;
 
+typedef enum
+{
+	OD_BALANCE_ROUND_ROBIN,
+	OD_BALANCE_LEAST_CONNECTIONS,
+	OD_BALANCE_LEAST_LATENCY
+} od_balance_t;
+
+struct od_config_endpoint
+{
+	char *host;
+	int   port;
+};
+
 struct od_config_storage
 {
-	char              *name;
-	char              *type;
-	od_storage_type_t  storage_type;
-	char              *host;
-	int                port;
-	od_tls_t           tls_mode;
-	char              *tls;
-	char              *tls_ca_file;
-	char              *tls_key_file;
-	char              *tls_cert_file;
-	char              *tls_protocols;
-	od_list_t          link;
+	char                 *name;
+	char                 *type;
+	od_storage_type_t     storage_type;
+	char                 *host;
+	int                   port;
+	od_config_endpoint_t *endpoints;
+	int                   endpoints_count;
+	char                 *balance;
+	od_balance_t          balance_policy;
+	int                   host_backoff;
+	od_tls_t              tls_mode;
+	char                 *tls;
+	char                 *tls_ca_file;
+	char                 *tls_key_file;
+	char                 *tls_cert_file;
+	char                 *tls_protocols;
+	int                   max_connections;
+	od_list_t             link;
+};
+
+/* active routes by database and user names */
+struct od_config_index
+{
+	od_list_t *buckets;
+	int        buckets_count;
+	int        count;
+};
+
+struct od_config_priority
+{
+	char      *name;
+	int        id;
+	int        weight;
+	int        pool_timeout;
+	int        pool_timeout_set;
+	char      *application_name;
+	od_list_t  link;
 };
 
 struct od_config_auth
@@ -96,6 +149,8 @@ struct od_config_route
 	/* storage */
 	od_config_storage_t *storage;
 	char                *storage_name;
+	od_config_storage_t *storage_replica;
+	char                *storage_replica_name;
 	char                *storage_db;
 	char                *storage_user;
 	int                  storage_user_len;
@@ -107,13 +162,27 @@ struct od_config_route
 	int                  pool_size;
 	int                  pool_timeout;
 	int                  pool_ttl;
+	int                  pool_min_idle;
+	int                  pool_min_size;
+	int                  pool_preconnect_rate;
+	int                  pool_adaptive;
+	int                  pool_size_min;
 	int                  pool_cancel;
 	int                  pool_rollback;
+	od_pool_policy_t     pool_policy;
+	char                *pool_policy_sz;
+	int                  prepared_statements;
+	int                  prepared_statements_max;
+	char                *priority;
 	/* misc */
 	int                  client_fwd_error;
 	int                  client_max_set;
 	int                  client_max;
+	int                  write_queue_high;
+	int                  write_queue_low;
 	int                  log_debug;
+	uint64_t             index_hash;
+	od_list_t            link_index;
 	od_list_t            link;
 };
 
@@ -122,12 +191,18 @@ struct od_config_listen
 	char      *host;
 	int        port;
 	int        backlog;
+	int        write_queue_high;
+	int        write_queue_low;
 	od_tls_t   tls_mode;
 	char      *tls;
 	char      *tls_ca_file;
 	char      *tls_key_file;
 	char      *tls_cert_file;
 	char      *tls_protocols;
+	int        tls_tickets;
+	int        tls_tickets_rotate;
+	char      *priority;
+	int        read_only;
 	od_list_t  link;
 };
 
@@ -151,10 +226,14 @@ struct od_config
 	char      *unix_socket_dir;
 	char      *unix_socket_mode;
 	int        readahead;
+	int        stream_threshold;
+	int        copy_splice;
 	int        nodelay;
 	int        keepalive;
 	int        workers;
 	int        resolvers;
+	int        dns_ttl;
+	int        dns_negative_ttl;
 	int        client_max_set;
 	int        client_max;
 	int        cache_coroutine;
@@ -164,8 +243,12 @@ struct od_config
 	od_list_t  storages;
 	/* routes */
 	od_list_t  routes;
+	od_config_index_t routes_index;
 	/* listen servers */
 	od_list_t  listen;
+	/* client priority classes */
+	od_list_t  priorities;
+	int        priorities_count;
 };
 
 void od_config_init(od_config_t*);
@@ -178,6 +261,17 @@ int  od_config_merge(od_config_t*, od_logger_t*, od_config_t*);
 od_config_listen_t*
 od_config_listen_add(od_config_t*);
 
+/* priority */
+od_config_priority_t*
+od_config_priority_add(od_config_t*);
+
+od_config_priority_t*
+od_config_priority_match(od_config_t*, char*);
+
+od_config_priority_t*
+od_config_priority_select(od_config_t*, od_config_listen_t*,
+                          od_config_route_t*, char*);
+
 /* storage */
 od_config_storage_t*
 od_config_storage_add(od_config_t*);
@@ -196,6 +290,8 @@ od_config_route_add(od_config_t*);
 
 void od_config_route_free(od_config_route_t*);
 
+int  od_config_route_index(od_config_t*, od_config_route_t*);
+
 void od_config_route_ref(od_config_route_t*);
 void od_config_route_unref(od_config_route_t*);
 
@@ -49,9 +49,13 @@ enum
 	OD_LHOST,
 	OD_LPORT,
 	OD_LBACKLOG,
+	OD_LWRITE_QUEUE_HIGH,
+	OD_LWRITE_QUEUE_LOW,
 	OD_LNODELAY,
 	OD_LKEEPALIVE,
 	OD_LREADAHEAD,
+	OD_LSTREAM_THRESHOLD,
+	OD_LCOPY_SPLICE,
 	OD_LWORKERS,
 	OD_LRESOLVERS,
 	OD_LPIPELINE,
@@ -77,8 +81,14 @@ enum
 	OD_LPOOL_SIZE,
 	OD_LPOOL_TIMEOUT,
 	OD_LPOOL_TTL,
+	OD_LPOOL_MIN_IDLE,
+	OD_LPOOL_MIN_SIZE,
+	OD_LPOOL_PRECONNECT_RATE,
 	OD_LPOOL_CANCEL,
 	OD_LPOOL_ROLLBACK,
+	OD_LPOOL_POLICY,
+	OD_LPREPARED_STATEMENTS,
+	OD_LPREPARED_STATEMENTS_MAX,
 	OD_LSTORAGE_DB,
 	OD_LSTORAGE_USER,
 	OD_LSTORAGE_PASSWORD,
@@ -89,6 +99,20 @@ enum
 	OD_LAUTH_QUERY_DB,
 	OD_LAUTH_QUERY_USER,
 	OD_LAUTH_QUERY_PASS,
+	OD_LPRIORITY,
+	OD_LWEIGHT,
+	OD_LAPPLICATION_NAME,
+	OD_LMAX_CONNECTIONS,
+	OD_LPOOL_ADAPTIVE,
+	OD_LPOOL_SIZE_MIN,
+	OD_LDNS_TTL,
+	OD_LDNS_NEGATIVE_TTL,
+	OD_LBALANCE,
+	OD_LHOST_BACKOFF,
+	OD_LSTORAGE_REPLICA,
+	OD_LREAD_ONLY,
+	OD_LTLS_TICKETS,
+	OD_LTLS_TICKETS_ROTATE,
 };
 
 typedef struct
@@ -129,9 +153,13 @@ od_config_keywords[] =
 	od_keyword("host",                 OD_LHOST),
 	od_keyword("port",                 OD_LPORT),
 	od_keyword("backlog",              OD_LBACKLOG),
+	od_keyword("write_queue_high",     OD_LWRITE_QUEUE_HIGH),
+	od_keyword("write_queue_low",      OD_LWRITE_QUEUE_LOW),
 	od_keyword("nodelay",              OD_LNODELAY),
 	od_keyword("keepalive",            OD_LKEEPALIVE),
 	od_keyword("readahead",            OD_LREADAHEAD),
+	od_keyword("stream_threshold",     OD_LSTREAM_THRESHOLD),
+	od_keyword("copy_splice",          OD_LCOPY_SPLICE),
 	od_keyword("workers",              OD_LWORKERS),
 	od_keyword("resolvers",            OD_LRESOLVERS),
 	od_keyword("pipeline",             OD_LPIPELINE),
@@ -159,8 +187,14 @@ od_config_keywords[] =
 	od_keyword("pool_size",            OD_LPOOL_SIZE),
 	od_keyword("pool_timeout",         OD_LPOOL_TIMEOUT),
 	od_keyword("pool_ttl",             OD_LPOOL_TTL),
+	od_keyword("pool_min_idle",        OD_LPOOL_MIN_IDLE),
+	od_keyword("pool_min_size",        OD_LPOOL_MIN_SIZE),
+	od_keyword("pool_preconnect_rate", OD_LPOOL_PRECONNECT_RATE),
 	od_keyword("pool_cancel",          OD_LPOOL_CANCEL),
 	od_keyword("pool_rollback",        OD_LPOOL_ROLLBACK),
+	od_keyword("pool_policy",          OD_LPOOL_POLICY),
+	od_keyword("prepared_statements",  OD_LPREPARED_STATEMENTS),
+	od_keyword("prepared_statements_max", OD_LPREPARED_STATEMENTS_MAX),
 	od_keyword("storage_db",           OD_LSTORAGE_DB),
 	od_keyword("storage_user",         OD_LSTORAGE_USER),
 	od_keyword("storage_password",     OD_LSTORAGE_PASSWORD),
@@ -171,6 +205,21 @@ od_config_keywords[] =
 	od_keyword("auth_query_db",        OD_LAUTH_QUERY_DB),
 	od_keyword("auth_query_user",      OD_LAUTH_QUERY_USER),
 	od_keyword("auth_query_pass",      OD_LAUTH_QUERY_PASS),
+	/* priority */
+	od_keyword("priority",             OD_LPRIORITY),
+	od_keyword("weight",               OD_LWEIGHT),
+	od_keyword("application_name",     OD_LAPPLICATION_NAME),
+	od_keyword("max_connections",      OD_LMAX_CONNECTIONS),
+	od_keyword("pool_adaptive",        OD_LPOOL_ADAPTIVE),
+	od_keyword("pool_size_min",        OD_LPOOL_SIZE_MIN),
+	od_keyword("dns_ttl",              OD_LDNS_TTL),
+	od_keyword("dns_negative_ttl",     OD_LDNS_NEGATIVE_TTL),
+	od_keyword("balance",              OD_LBALANCE),
+	od_keyword("host_backoff",         OD_LHOST_BACKOFF),
+	od_keyword("storage_replica",      OD_LSTORAGE_REPLICA),
+	od_keyword("read_only",            OD_LREAD_ONLY),
+	od_keyword("tls_tickets",          OD_LTLS_TICKETS),
+	od_keyword("tls_tickets_rotate",   OD_LTLS_TICKETS_ROTATE),
 	{ 0, 0, 0 }
 };
 
@@ -410,6 +459,16 @@ od_config_reader_listen(od_config_reader_t *reader)
 			if (! od_config_reader_number(reader, &listen->backlog))
 				return -1;
 			continue;
+		/* write_queue_high */
+		case OD_LWRITE_QUEUE_HIGH:
+			if (! od_config_reader_number(reader, &listen->write_queue_high))
+				return -1;
+			continue;
+		/* write_queue_low */
+		case OD_LWRITE_QUEUE_LOW:
+			if (! od_config_reader_number(reader, &listen->write_queue_low))
+				return -1;
+			continue;
 		/* tls */
 		case OD_LTLS:
 			if (! od_config_reader_string(reader, &listen->tls))
@@ -435,6 +494,92 @@ od_config_reader_listen(od_config_reader_t *reader)
 			if (! od_config_reader_string(reader, &listen->tls_protocols))
 				return -1;
 			continue;
+		/* tls_tickets */
+		case OD_LTLS_TICKETS:
+			if (! od_config_reader_yes_no(reader, &listen->tls_tickets))
+				return -1;
+			continue;
+		/* tls_tickets_rotate */
+		case OD_LTLS_TICKETS_ROTATE:
+			if (! od_config_reader_number(reader, &listen->tls_tickets_rotate))
+				return -1;
+			continue;
+		/* priority */
+		case OD_LPRIORITY:
+			if (! od_config_reader_string(reader, &listen->priority))
+				return -1;
+			continue;
+		/* read_only */
+		case OD_LREAD_ONLY:
+			if (! od_config_reader_yes_no(reader, &listen->read_only))
+				return -1;
+			continue;
+		default:
+			od_config_reader_error(reader, &token, "unexpected parameter");
+			return -1;
+		}
+	}
+	/* unreach */
+	return -1;
+}
+
+static int
+od_config_reader_priority(od_config_reader_t *reader)
+{
+	od_config_priority_t *priority;
+	priority = od_config_priority_add(reader->config);
+	if (priority == NULL)
+		return -1;
+	/* name */
+	if (! od_config_reader_string(reader, &priority->name))
+		return -1;
+	/* { */
+	if (! od_config_reader_symbol(reader, '{'))
+		return -1;
+
+	for (;;)
+	{
+		od_token_t token;
+		int rc;
+		rc = od_parser_next(&reader->parser, &token);
+		switch (rc) {
+		case OD_PARSER_KEYWORD:
+			break;
+		case OD_PARSER_EOF:
+			od_config_reader_error(reader, &token, "unexpected end of config file");
+			return -1;
+		case OD_PARSER_SYMBOL:
+			/* } */
+			if (token.value.num == '}')
+				return 0;
+			/* fall through */
+		default:
+			od_config_reader_error(reader, &token, "incorrect or unexpected parameter");
+			return -1;
+		}
+		od_keyword_t *keyword;
+		keyword = od_keyword_match(od_config_keywords, &token);
+		if (keyword == NULL) {
+			od_config_reader_error(reader, &token, "unknown parameter");
+			return -1;
+		}
+		switch (keyword->id) {
+		/* weight */
+		case OD_LWEIGHT:
+			if (! od_config_reader_number(reader, &priority->weight))
+				return -1;
+			continue;
+		/* pool_timeout */
+		case OD_LPOOL_TIMEOUT:
+			if (! od_config_reader_number(reader, &priority->pool_timeout))
+				return -1;
+			priority->pool_timeout_set = 1;
+			continue;
+		/* application_name */
+		case OD_LAPPLICATION_NAME:
+			if (! od_config_reader_string(reader, &priority->application_name))
+				return -1;
+			continue;
 		default:
 			od_config_reader_error(reader, &token, "unexpected parameter");
 			return -1;
@@ -500,6 +645,21 @@ od_config_reader_storage(od_config_reader_t *reader)
 			if (! od_config_reader_number(reader, &storage->port))
 				return -1;
 			continue;
+		/* balance */
+		case OD_LBALANCE:
+			if (! od_config_reader_string(reader, &storage->balance))
+				return -1;
+			continue;
+		/* host_backoff */
+		case OD_LHOST_BACKOFF:
+			if (! od_config_reader_number(reader, &storage->host_backoff))
+				return -1;
+			continue;
+		/* max_connections */
+		case OD_LMAX_CONNECTIONS:
+			if (! od_config_reader_number(reader, &storage->max_connections))
+				return -1;
+			continue;
 		/* tls */
 		case OD_LTLS:
 			if (! od_config_reader_string(reader, &storage->tls))
@@ -581,6 +741,10 @@ od_config_reader_route(od_config_reader_t *reader, char *db_name, int db_name_le
 	route->db_name = strdup(db_name);
 	if (route->db_name == NULL)
 		return -1;
+	int rc;
+	rc = od_config_route_index(reader->config, route);
+	if (rc == -1)
+		return -1;
 
 	/* { */
 	if (! od_config_reader_symbol(reader, '{'))
@@ -589,7 +753,6 @@ od_config_reader_route(od_config_reader_t *reader, char *db_name, int db_name_le
 	for (;;)
 	{
 		od_token_t token;
-		int rc;
 		rc = od_parser_next(&reader->parser, &token);
 		switch (rc) {
 		case OD_PARSER_KEYWORD:
@@ -673,12 +836,27 @@ od_config_reader_route(od_config_reader_t *reader, char *db_name, int db_name_le
 			if (! od_config_reader_string(reader, &route->storage_name))
 				return -1;
 			continue;
+		/* storage_replica */
+		case OD_LSTORAGE_REPLICA:
+			if (! od_config_reader_string(reader, &route->storage_replica_name))
+				return -1;
+			continue;
 		/* client_max */
 		case OD_LCLIENT_MAX:
 			if (! od_config_reader_number(reader, &route->client_max))
 				return -1;
 			route->client_max_set = 1;
 			continue;
+		/* write_queue_high */
+		case OD_LWRITE_QUEUE_HIGH:
+			if (! od_config_reader_number(reader, &route->write_queue_high))
+				return -1;
+			continue;
+		/* write_queue_low */
+		case OD_LWRITE_QUEUE_LOW:
+			if (! od_config_reader_number(reader, &route->write_queue_low))
+				return -1;
+			continue;
 		/* client_fwd_error */
 		case OD_LCLIENT_FWD_ERROR:
 			if (! od_config_reader_yes_no(reader, &route->client_fwd_error))
@@ -704,6 +882,31 @@ od_config_reader_route(od_config_reader_t *reader, char *db_name, int db_name_le
 			if (! od_config_reader_number(reader, &route->pool_ttl))
 				return -1;
 			continue;
+		/* pool_min_idle */
+		case OD_LPOOL_MIN_IDLE:
+			if (! od_config_reader_number(reader, &route->pool_min_idle))
+				return -1;
+			continue;
+		/* pool_min_size */
+		case OD_LPOOL_MIN_SIZE:
+			if (! od_config_reader_number(reader, &route->pool_min_size))
+				return -1;
+			continue;
+		/* pool_preconnect_rate */
+		case OD_LPOOL_PRECONNECT_RATE:
+			if (! od_config_reader_number(reader, &route->pool_preconnect_rate))
+				return -1;
+			continue;
+		/* pool_adaptive */
+		case OD_LPOOL_ADAPTIVE:
+			if (! od_config_reader_yes_no(reader, &route->pool_adaptive))
+				return -1;
+			continue;
+		/* pool_size_min */
+		case OD_LPOOL_SIZE_MIN:
+			if (! od_config_reader_number(reader, &route->pool_size_min))
+				return -1;
+			continue;
 		/* storage_database */
 		case OD_LSTORAGE_DB:
 			if (! od_config_reader_string(reader, &route->storage_db))
@@ -731,6 +934,26 @@ od_config_reader_route(od_config_reader_t *reader, char *db_name, int db_name_le
 			if (! od_config_reader_yes_no(reader, &route->pool_rollback))
 				return -1;
 			continue;
+		/* pool_policy */
+		case OD_LPOOL_POLICY:
+			if (! od_config_reader_string(reader, &route->pool_policy_sz))
+				return -1;
+			continue;
+		/* prepared_statements */
+		case OD_LPREPARED_STATEMENTS:
+			if (! od_config_reader_yes_no(reader, &route->prepared_statements))
+				return -1;
+			continue;
+		/* prepared_statements_max */
+		case OD_LPREPARED_STATEMENTS_MAX:
+			if (! od_config_reader_number(reader, &route->prepared_statements_max))
+				return -1;
+			continue;
+		/* priority */
+		case OD_LPRIORITY:
+			if (! od_config_reader_string(reader, &route->priority))
+				return -1;
+			continue;
 		/* log_debug */
 		case OD_LLOG_DEBUG:
 			if (! od_config_reader_yes_no(reader, &route->log_debug))
@@ -946,6 +1169,16 @@ od_config_reader_parse(od_config_reader_t *reader)
 			if (! od_config_reader_number(reader, &config->readahead))
 				return -1;
 			continue;
+		/* stream_threshold */
+		case OD_LSTREAM_THRESHOLD:
+			if (! od_config_reader_number(reader, &config->stream_threshold))
+				return -1;
+			continue;
+		/* copy_splice */
+		case OD_LCOPY_SPLICE:
+			if (! od_config_reader_yes_no(reader, &config->copy_splice))
+				return -1;
+			continue;
 		/* nodelay */
 		case OD_LNODELAY:
 			if (! od_config_reader_yes_no(reader, &config->nodelay))
@@ -966,6 +1199,16 @@ od_config_reader_parse(od_config_reader_t *reader)
 			if (! od_config_reader_number(reader, &config->resolvers))
 				return -1;
 			continue;
+		/* dns_ttl */
+		case OD_LDNS_TTL:
+			if (! od_config_reader_number(reader, &config->dns_ttl))
+				return -1;
+			continue;
+		/* dns_negative_ttl */
+		case OD_LDNS_NEGATIVE_TTL:
+			if (! od_config_reader_number(reader, &config->dns_negative_ttl))
+				return -1;
+			continue;
 		/* pipeline */
 		/* cache */
 		/* cache_chunk */
@@ -1006,6 +1249,12 @@ od_config_reader_parse(od_config_reader_t *reader)
 			if (rc == -1)
 				return -1;
 			continue;
+		/* priority */
+		case OD_LPRIORITY:
+			rc = od_config_reader_priority(reader);
+			if (rc == -1)
+				return -1;
+			continue;
 		/* database */
 		case OD_LDATABASE:
 			rc = od_config_reader_database(reader);
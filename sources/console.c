@@ -34,6 +34,11 @@ enum
 	OD_LSERVERS,
 	OD_LCLIENTS,
 	OD_LLISTS,
+	OD_LPOOLS,
+	OD_LWAITS,
+	OD_LPRIORITIES,
+	OD_LHOSTS,
+	OD_LLISTEN,
 	OD_LSET
 };
 
@@ -46,6 +51,11 @@ od_console_keywords[] =
 	od_keyword("servers",     OD_LSERVERS),
 	od_keyword("clients",     OD_LCLIENTS),
 	od_keyword("lists",       OD_LLISTS),
+	od_keyword("pools",       OD_LPOOLS),
+	od_keyword("waits",       OD_LWAITS),
+	od_keyword("priorities",  OD_LPRIORITIES),
+	od_keyword("hosts",       OD_LHOSTS),
+	od_keyword("listen",      OD_LLISTEN),
 	od_keyword("set",         OD_LSET),
 	{ 0, 0, 0 }
 };
@@ -99,7 +109,7 @@ od_console_show_stats_add(machine_channel_t *reply,
 	if (rc == -1)
 		goto error;
 	/* total_wait_time */
-	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, 0);
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, total->wait_time);
 	rc = kiwi_be_write_data_row_add(msg, data, data_len);
 	if (rc == -1)
 		goto error;
@@ -134,7 +144,42 @@ od_console_show_stats_add(machine_channel_t *reply,
 	if (rc == -1)
 		goto error;
 	/* avg_wait_time */
-	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, 0);
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, avg->wait_time);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* total_deploy_count */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, total->count_deploy);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* total_deploy_skipped */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, total->count_deploy_skip);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* total_deploy_shortened */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, total->count_deploy_short);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* total_affinity_hit */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, total->count_affinity_hit);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* total_affinity_miss */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, total->count_affinity_miss);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* total_preconnect_count */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, total->count_preconnect);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* total_preconnect_hit */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, total->count_preconnect_hit);
 	rc = kiwi_be_write_data_row_add(msg, data, data_len);
 	if (rc == -1)
 		goto error;
@@ -164,7 +209,7 @@ od_console_show_stats(od_client_t *client, machine_channel_t *reply)
 	od_cron_t *cron = client->global->cron;
 
 	machine_msg_t *msg;
-	msg = kiwi_be_write_row_descriptionf("sllllllllllllll",
+	msg = kiwi_be_write_row_descriptionf("slllllllllllllllllllll",
 	                                     "database",
 	                                     "total_xact_count",
 	                                     "total_query_count",
@@ -179,7 +224,14 @@ od_console_show_stats(od_client_t *client, machine_channel_t *reply)
 	                                     "avg_sent",
 	                                     "avg_xact_time",
 	                                     "avg_query_time",
-	                                     "avg_wait_time");
+	                                     "avg_wait_time",
+	                                     "total_deploy_count",
+	                                     "total_deploy_skipped",
+	                                     "total_deploy_shortened",
+	                                     "total_affinity_hit",
+	                                     "total_affinity_miss",
+	                                     "total_preconnect_count",
+	                                     "total_preconnect_hit");
 	if (msg == NULL)
 		return -1;
 	machine_channel_write(reply, msg);
@@ -450,6 +502,26 @@ od_console_show_clients_callback(od_client_t *client, void *arg)
 	if (rc == -1)
 		goto error;
 
+	/* write_queue */
+	data_len = od_snprintf(data, sizeof(data), "%d",
+	                       machine_write_queue_size(client->io));
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* write_queue_high */
+	int write_high;
+	int write_low;
+	od_client_write_watermark(client, &write_high, &write_low);
+	data_len = od_snprintf(data, sizeof(data), "%d", write_high);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* write_queue_low */
+	data_len = od_snprintf(data, sizeof(data), "%d", write_low);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+
 	machine_channel_t *reply = arg;
 	machine_channel_write(reply, msg);
 	return 0;
@@ -464,7 +536,7 @@ od_console_show_clients(od_client_t *client, machine_channel_t *reply)
 	od_router_t *router = client->global->router;
 
 	machine_msg_t *msg;
-	msg = kiwi_be_write_row_descriptionf("sssssdsdssssds",
+	msg = kiwi_be_write_row_descriptionf("sssssdsdssssdsddd",
 	                                     "type",
 	                                     "user",
 	                                     "database",
@@ -478,7 +550,10 @@ od_console_show_clients(od_client_t *client, machine_channel_t *reply)
 	                                     "ptr",
 	                                     "link",
 	                                     "remote_pid",
-	                                     "tls");
+	                                     "tls",
+	                                     "write_queue",
+	                                     "write_queue_high",
+	                                     "write_queue_low");
 	if (msg == NULL)
 		return -1;
 	machine_channel_write(reply, msg);
@@ -510,6 +585,227 @@ od_console_show_clients(od_client_t *client, machine_channel_t *reply)
 	return 0;
 }
 
+static inline int
+od_console_show_pools_callback(od_route_t *route, void *arg)
+{
+	machine_channel_t *reply = arg;
+
+	machine_msg_t *msg;
+	msg = kiwi_be_write_data_row();
+	if (msg == NULL)
+		return -1;
+
+	char data[64];
+	int  data_len;
+
+	/* database */
+	int rc;
+	rc = kiwi_be_write_data_row_add(msg, route->id.database,
+	                                route->id.database_len - 1);
+	if (rc == -1)
+		goto error;
+	/* user */
+	rc = kiwi_be_write_data_row_add(msg, route->id.user,
+	                                route->id.user_len - 1);
+	if (rc == -1)
+		goto error;
+	/* cl_active */
+	data_len = od_snprintf(data, sizeof(data), "%d",
+	                       route->client_pool.count_active);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* cl_waiting */
+	data_len = od_snprintf(data, sizeof(data), "%d",
+	                       route->client_pool.count_queue);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* sv_active */
+	data_len = od_snprintf(data, sizeof(data), "%d",
+	                       route->server_pool.count_active);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* sv_idle */
+	data_len = od_snprintf(data, sizeof(data), "%d",
+	                       route->server_pool.count_idle);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* pool_mode */
+	rc = kiwi_be_write_data_row_add(msg, route->config->pool_sz,
+	                                strlen(route->config->pool_sz));
+	if (rc == -1)
+		goto error;
+	/* pool_size */
+	data_len = od_snprintf(data, sizeof(data), "%d",
+	                       route->config->pool_size);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* pool_limit */
+	data_len = od_snprintf(data, sizeof(data), "%d",
+	                       od_route_pool_size(route));
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* storage */
+	char *storage = od_route_storage(route)->name;
+	rc = kiwi_be_write_data_row_add(msg, storage, strlen(storage));
+	if (rc == -1)
+		goto error;
+
+	machine_channel_write(reply, msg);
+	return 0;
+error:
+	machine_msg_free(msg);
+	return -1;
+}
+
+static inline int
+od_console_show_pools(od_client_t *client, machine_channel_t *reply)
+{
+	od_router_t *router = client->global->router;
+
+	machine_msg_t *msg;
+	msg = kiwi_be_write_row_descriptionf("ssddddsdds",
+	                                     "database",
+	                                     "user",
+	                                     "cl_active",
+	                                     "cl_waiting",
+	                                     "sv_active",
+	                                     "sv_idle",
+	                                     "pool_mode",
+	                                     "pool_size",
+	                                     "pool_limit",
+	                                     "storage");
+	if (msg == NULL)
+		return -1;
+	machine_channel_write(reply, msg);
+
+	int rc;
+	rc = od_route_pool_foreach(&router->route_pool,
+	                           od_console_show_pools_callback,
+	                           reply);
+	if (rc == -1)
+		return -1;
+
+	msg = kiwi_be_write_complete("SHOW", 5);
+	if (msg == NULL)
+		return -1;
+	machine_channel_write(reply, msg);
+
+	msg = kiwi_be_write_ready('I');
+	if (msg == NULL)
+		return -1;
+	machine_channel_write(reply, msg);
+	return 0;
+}
+
+static inline int
+od_console_show_waits_callback(od_route_t *route, void *arg)
+{
+	machine_channel_t *reply = arg;
+
+	machine_msg_t *msg;
+	msg = kiwi_be_write_data_row();
+	if (msg == NULL)
+		return -1;
+
+	od_stat_t stat;
+	od_stat_copy(&stat, &route->stats);
+
+	char data[64];
+	int  data_len;
+
+	/* database */
+	int rc;
+	rc = kiwi_be_write_data_row_add(msg, route->id.database,
+	                                route->id.database_len - 1);
+	if (rc == -1)
+		goto error;
+	/* user */
+	rc = kiwi_be_write_data_row_add(msg, route->id.user,
+	                                route->id.user_len - 1);
+	if (rc == -1)
+		goto error;
+	/* wait_count */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, stat.count_wait);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* wait_time */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, stat.wait_time);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* wait_max */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, stat.wait_max);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* histogram buckets */
+	int i = 0;
+	for (; i < OD_STAT_WAIT_BUCKETS; i++) {
+		data_len = od_snprintf(data, sizeof(data), "%" PRIu64, stat.wait[i]);
+		rc = kiwi_be_write_data_row_add(msg, data, data_len);
+		if (rc == -1)
+			goto error;
+	}
+
+	machine_channel_write(reply, msg);
+	return 0;
+error:
+	machine_msg_free(msg);
+	return -1;
+}
+
+static inline int
+od_console_show_waits(od_client_t *client, machine_channel_t *reply)
+{
+	od_router_t *router = client->global->router;
+
+	/* server pool queue wait time and its histogram
+	 * per route, in microseconds */
+	machine_msg_t *msg;
+	msg = kiwi_be_write_row_descriptionf("sslllllllllll",
+	                                     "database",
+	                                     "user",
+	                                     "wait_count",
+	                                     "wait_time",
+	                                     "wait_max",
+	                                     "wait_1ms",
+	                                     "wait_5ms",
+	                                     "wait_10ms",
+	                                     "wait_50ms",
+	                                     "wait_100ms",
+	                                     "wait_500ms",
+	                                     "wait_1s",
+	                                     "wait_inf");
+	if (msg == NULL)
+		return -1;
+	machine_channel_write(reply, msg);
+
+	int rc;
+	rc = od_route_pool_foreach(&router->route_pool,
+	                           od_console_show_waits_callback,
+	                           reply);
+	if (rc == -1)
+		return -1;
+
+	msg = kiwi_be_write_complete("SHOW", 5);
+	if (msg == NULL)
+		return -1;
+	machine_channel_write(reply, msg);
+
+	msg = kiwi_be_write_ready('I');
+	if (msg == NULL)
+		return -1;
+	machine_channel_write(reply, msg);
+	return 0;
+}
+
 static inline int
 od_console_show_lists_add(machine_channel_t *reply, char *list, int items)
 {
@@ -586,7 +882,8 @@ od_console_show_lists(od_client_t *client, machine_channel_t *reply)
 	if (rc == -1)
 		return -1;
 	/* used_clients */
-	rc = od_console_show_lists_add(reply, "used_clients", router->clients);
+	rc = od_console_show_lists_add(reply, "used_clients",
+	                               od_atomic_u32_of(&router->clients));
 	if (rc == -1)
 		return -1;
 	/* login_clients */
@@ -602,7 +899,10 @@ od_console_show_lists(od_client_t *client, machine_channel_t *reply)
 	if (rc == -1)
 		return -1;
 	/* dns_names */
-	rc = od_console_show_lists_add(reply, "dns_names", 0);
+	pthread_mutex_lock(&router->dns.lock);
+	int dns_names = router->dns.count;
+	pthread_mutex_unlock(&router->dns.lock);
+	rc = od_console_show_lists_add(reply, "dns_names", dns_names);
 	if (rc == -1)
 		return -1;
 	/* dns_zones */
@@ -610,13 +910,40 @@ od_console_show_lists(od_client_t *client, machine_channel_t *reply)
 	if (rc == -1)
 		return -1;
 	/* dns_queries */
-	rc = od_console_show_lists_add(reply, "dns_queries", 0);
+	rc = od_console_show_lists_add(reply, "dns_queries",
+	                               od_atomic_u64_of(&router->dns.count_queries));
 	if (rc == -1)
 		return -1;
 	/* dns_pending */
-	rc = od_console_show_lists_add(reply, "dns_pending", 0);
+	rc = od_console_show_lists_add(reply, "dns_pending",
+	                               od_atomic_u32_of(&router->dns.count_pending));
 	if (rc == -1)
 		return -1;
+	/* storage server connections and clients waiting
+	 * for the storage max_connections limit */
+	od_list_t *i;
+	od_list_foreach(&router->storages, i) {
+		od_storage_t *storage;
+		storage = od_container_of(i, od_storage_t, link);
+		char list[128];
+		od_snprintf(list, sizeof(list), "storage.%s.servers", storage->name);
+		rc = od_console_show_lists_add(reply, list, storage->count);
+		if (rc == -1)
+			return -1;
+		od_snprintf(list, sizeof(list), "storage.%s.max_connections", storage->name);
+		rc = od_console_show_lists_add(reply, list, storage->max_connections);
+		if (rc == -1)
+			return -1;
+		od_snprintf(list, sizeof(list), "storage.%s.waiting", storage->name);
+		rc = od_console_show_lists_add(reply, list,
+		                               od_atomic_u32_of(&storage->count_queue));
+		if (rc == -1)
+			return -1;
+		od_snprintf(list, sizeof(list), "storage.%s.evicted", storage->name);
+		rc = od_console_show_lists_add(reply, list, storage->count_evict);
+		if (rc == -1)
+			return -1;
+	}
 
 	msg = kiwi_be_write_complete("SHOW", 5);
 	if (msg == NULL)
@@ -629,6 +956,428 @@ od_console_show_lists(od_client_t *client, machine_channel_t *reply)
 	return 0;
 }
 
+typedef struct
+{
+	int                count_queue[OD_CONFIG_PRIORITY_MAX];
+	od_stat_priority_t stats[OD_CONFIG_PRIORITY_MAX];
+} od_console_priorities_t;
+
+static inline int
+od_console_show_priorities_callback(od_route_t *route, void *arg)
+{
+	od_console_priorities_t *sum = arg;
+	od_stat_t stat;
+	od_stat_copy(&stat, &route->stats);
+	int i = 0;
+	for (; i < OD_CONFIG_PRIORITY_MAX; i++) {
+		od_stat_priority_t *a = &sum->stats[i];
+		od_stat_priority_t *b = &stat.priority[i];
+		sum->count_queue[i] += route->client_pool.count_queue_priority[i];
+		a->count_wait    += b->count_wait;
+		a->count_timeout += b->count_timeout;
+		a->wait_time     += b->wait_time;
+		if (b->wait_max > a->wait_max)
+			a->wait_max = b->wait_max;
+	}
+	return 0;
+}
+
+static inline int
+od_console_show_priorities_add(machine_channel_t *reply,
+                               od_config_priority_t *priority,
+                               od_console_priorities_t *sum)
+{
+	machine_msg_t *msg;
+	msg = kiwi_be_write_data_row();
+	if (msg == NULL)
+		return -1;
+
+	/* implicit default class */
+	char *name = "default";
+	int   id = 0;
+	int   weight = 1;
+	if (priority) {
+		name   = priority->name;
+		id     = priority->id;
+		weight = priority->weight;
+	}
+	od_stat_priority_t *stat = &sum->stats[id];
+
+	char data[64];
+	int  data_len;
+
+	/* priority */
+	int rc;
+	rc = kiwi_be_write_data_row_add(msg, name, strlen(name));
+	if (rc == -1)
+		goto error;
+	/* weight */
+	data_len = od_snprintf(data, sizeof(data), "%d", weight);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* pool_timeout, NULL if route one is used */
+	if (priority && priority->pool_timeout_set) {
+		data_len = od_snprintf(data, sizeof(data), "%d", priority->pool_timeout);
+		rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	} else {
+		rc = kiwi_be_write_data_row_add(msg, NULL, -1);
+	}
+	if (rc == -1)
+		goto error;
+	/* cl_waiting */
+	data_len = od_snprintf(data, sizeof(data), "%d", sum->count_queue[id]);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* wait_count */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, stat->count_wait);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* wait_time */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, stat->wait_time);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* wait_max */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, stat->wait_max);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* timeouts */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, stat->count_timeout);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+
+	machine_channel_write(reply, msg);
+	return 0;
+error:
+	machine_msg_free(msg);
+	return -1;
+}
+
+static inline int
+od_console_show_priorities(od_client_t *client, machine_channel_t *reply)
+{
+	od_router_t *router = client->global->router;
+	od_instance_t *instance = client->global->instance;
+
+	/* server pool queue wait time per client priority
+	 * class summed over all routes, in microseconds */
+	machine_msg_t *msg;
+	msg = kiwi_be_write_row_descriptionf("slllllll",
+	                                     "priority",
+	                                     "weight",
+	                                     "pool_timeout",
+	                                     "cl_waiting",
+	                                     "wait_count",
+	                                     "wait_time",
+	                                     "wait_max",
+	                                     "timeouts");
+	if (msg == NULL)
+		return -1;
+	machine_channel_write(reply, msg);
+
+	od_console_priorities_t sum;
+	memset(&sum, 0, sizeof(sum));
+	int rc;
+	rc = od_route_pool_foreach(&router->route_pool,
+	                           od_console_show_priorities_callback,
+	                           &sum);
+	if (rc == -1)
+		return -1;
+
+	if (od_config_priority_match(&instance->config, "default") == NULL) {
+		rc = od_console_show_priorities_add(reply, NULL, &sum);
+		if (rc == -1)
+			return -1;
+	}
+	od_list_t *i;
+	od_list_foreach(&instance->config.priorities, i) {
+		od_config_priority_t *priority;
+		priority = od_container_of(i, od_config_priority_t, link);
+		rc = od_console_show_priorities_add(reply, priority, &sum);
+		if (rc == -1)
+			return -1;
+	}
+
+	msg = kiwi_be_write_complete("SHOW", 5);
+	if (msg == NULL)
+		return -1;
+	machine_channel_write(reply, msg);
+
+	msg = kiwi_be_write_ready('I');
+	if (msg == NULL)
+		return -1;
+	machine_channel_write(reply, msg);
+	return 0;
+}
+
+static inline int
+od_console_show_hosts_add(machine_channel_t *reply, od_storage_t *storage,
+                          od_storage_endpoint_t *endpoint, uint64_t now)
+{
+	machine_msg_t *msg;
+	msg = kiwi_be_write_data_row();
+	if (msg == NULL)
+		return -1;
+
+	char data[64];
+	int  data_len;
+
+	/* storage */
+	int rc;
+	rc = kiwi_be_write_data_row_add(msg, storage->name, strlen(storage->name));
+	if (rc == -1)
+		goto error;
+	/* host */
+	rc = kiwi_be_write_data_row_add(msg, endpoint->host, strlen(endpoint->host));
+	if (rc == -1)
+		goto error;
+	/* port */
+	data_len = od_snprintf(data, sizeof(data), "%d", endpoint->port);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* servers */
+	data_len = od_snprintf(data, sizeof(data), "%d",
+	                       od_atomic_u32_of(&endpoint->count));
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* connects */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, endpoint->count_connect);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* errors */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, endpoint->count_error);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* connect_time */
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, endpoint->latency);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* tls_full */
+	uint64_t count_tls_full = od_atomic_u64_of(&endpoint->count_tls_full);
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, count_tls_full);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* tls_resumed */
+	uint64_t count_tls_resumed = od_atomic_u64_of(&endpoint->count_tls_resumed);
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, count_tls_resumed);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* tls_full_time */
+	uint64_t tls_time = 0;
+	if (count_tls_full > 0)
+		tls_time = od_atomic_u64_of(&endpoint->tls_time_full) / count_tls_full;
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, tls_time);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* tls_resumed_time */
+	tls_time = 0;
+	if (count_tls_resumed > 0)
+		tls_time = od_atomic_u64_of(&endpoint->tls_time_resumed) / count_tls_resumed;
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, tls_time);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* status */
+	char *status = "up";
+	if (endpoint->backoff > now)
+		status = "down";
+	rc = kiwi_be_write_data_row_add(msg, status, strlen(status));
+	if (rc == -1)
+		goto error;
+
+	machine_channel_write(reply, msg);
+	return 0;
+error:
+	machine_msg_free(msg);
+	return -1;
+}
+
+static inline int
+od_console_show_hosts(od_client_t *client, machine_channel_t *reply)
+{
+	od_router_t *router = client->global->router;
+
+	/* storage hosts used by server connections, connect
+	 * time is a moving average in microseconds, tls handshake
+	 * times are averages in microseconds */
+	machine_msg_t *msg;
+	msg = kiwi_be_write_row_descriptionf("ssddllllllls",
+	                                     "storage",
+	                                     "host",
+	                                     "port",
+	                                     "servers",
+	                                     "connects",
+	                                     "errors",
+	                                     "connect_time",
+	                                     "tls_full",
+	                                     "tls_resumed",
+	                                     "tls_full_time",
+	                                     "tls_resumed_time",
+	                                     "status");
+	if (msg == NULL)
+		return -1;
+	machine_channel_write(reply, msg);
+
+	uint64_t now = machine_time();
+	od_list_t *i;
+	od_list_foreach(&router->storages, i) {
+		od_storage_t *storage;
+		storage = od_container_of(i, od_storage_t, link);
+		pthread_mutex_lock(&storage->lock);
+		od_list_t *j;
+		od_list_foreach(&storage->endpoints, j) {
+			od_storage_endpoint_t *endpoint;
+			endpoint = od_container_of(j, od_storage_endpoint_t, link);
+			int rc;
+			rc = od_console_show_hosts_add(reply, storage, endpoint, now);
+			if (rc == -1) {
+				pthread_mutex_unlock(&storage->lock);
+				return -1;
+			}
+		}
+		pthread_mutex_unlock(&storage->lock);
+	}
+
+	msg = kiwi_be_write_complete("SHOW", 5);
+	if (msg == NULL)
+		return -1;
+	machine_channel_write(reply, msg);
+
+	msg = kiwi_be_write_ready('I');
+	if (msg == NULL)
+		return -1;
+	machine_channel_write(reply, msg);
+	return 0;
+}
+
+static inline int
+od_console_show_listen_add(machine_channel_t *reply, od_system_server_t *server)
+{
+	machine_msg_t *msg;
+	msg = kiwi_be_write_data_row();
+	if (msg == NULL)
+		return -1;
+
+	char data[64];
+	int  data_len;
+
+	/* host */
+	if (server->addr)
+		od_getaddrname(server->addr, data, sizeof(data), 1, 0);
+	else
+		od_snprintf(data, sizeof(data), "unix_socket");
+	int rc;
+	rc = kiwi_be_write_data_row_add(msg, data, strlen(data));
+	if (rc == -1)
+		goto error;
+	/* port */
+	data_len = od_snprintf(data, sizeof(data), "%d", server->config->port);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* tls */
+	char *tls = server->config->tls ? server->config->tls : "disable";
+	rc = kiwi_be_write_data_row_add(msg, tls, strlen(tls));
+	if (rc == -1)
+		goto error;
+	/* tls_tickets */
+	char *tls_tickets = server->tls_tickets ? "yes" : "no";
+	rc = kiwi_be_write_data_row_add(msg, tls_tickets, strlen(tls_tickets));
+	if (rc == -1)
+		goto error;
+	/* tls_full */
+	uint64_t count_tls_full = od_atomic_u64_of(&server->count_tls_full);
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, count_tls_full);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* tls_resumed */
+	uint64_t count_tls_resumed = od_atomic_u64_of(&server->count_tls_resumed);
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, count_tls_resumed);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* tls_full_time */
+	uint64_t tls_time = 0;
+	if (count_tls_full > 0)
+		tls_time = od_atomic_u64_of(&server->tls_time_full) / count_tls_full;
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, tls_time);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+	/* tls_resumed_time */
+	tls_time = 0;
+	if (count_tls_resumed > 0)
+		tls_time = od_atomic_u64_of(&server->tls_time_resumed) / count_tls_resumed;
+	data_len = od_snprintf(data, sizeof(data), "%" PRIu64, tls_time);
+	rc = kiwi_be_write_data_row_add(msg, data, data_len);
+	if (rc == -1)
+		goto error;
+
+	machine_channel_write(reply, msg);
+	return 0;
+error:
+	machine_msg_free(msg);
+	return -1;
+}
+
+static inline int
+od_console_show_listen(od_client_t *client, machine_channel_t *reply)
+{
+	od_system_t *system = client->global->system;
+
+	/* listen servers and their client tls handshakes,
+	 * handshake times are averages in microseconds */
+	machine_msg_t *msg;
+	msg = kiwi_be_write_row_descriptionf("sdssllll",
+	                                     "host",
+	                                     "port",
+	                                     "tls",
+	                                     "tls_tickets",
+	                                     "tls_full",
+	                                     "tls_resumed",
+	                                     "tls_full_time",
+	                                     "tls_resumed_time");
+	if (msg == NULL)
+		return -1;
+	machine_channel_write(reply, msg);
+
+	/* servers list is not changed after startup */
+	od_list_t *i;
+	od_list_foreach(&system->servers, i) {
+		od_system_server_t *server;
+		server = od_container_of(i, od_system_server_t, link);
+		int rc;
+		rc = od_console_show_listen_add(reply, server);
+		if (rc == -1)
+			return -1;
+	}
+
+	msg = kiwi_be_write_complete("SHOW", 5);
+	if (msg == NULL)
+		return -1;
+	machine_channel_write(reply, msg);
+
+	msg = kiwi_be_write_ready('I');
+	if (msg == NULL)
+		return -1;
+	machine_channel_write(reply, msg);
+	return 0;
+}
+
 static inline int
 od_console_query_show(od_client_t *client, machine_channel_t *reply,
                       od_parser_t *parser)
@@ -656,6 +1405,16 @@ od_console_query_show(od_client_t *client, machine_channel_t *reply,
 		return od_console_show_clients(client, reply);
 	case OD_LLISTS:
 		return od_console_show_lists(client, reply);
+	case OD_LPOOLS:
+		return od_console_show_pools(client, reply);
+	case OD_LWAITS:
+		return od_console_show_waits(client, reply);
+	case OD_LPRIORITIES:
+		return od_console_show_priorities(client, reply);
+	case OD_LHOSTS:
+		return od_console_show_hosts(client, reply);
+	case OD_LLISTEN:
+		return od_console_show_listen(client, reply);
 	}
 	return -1;
 }
@@ -752,7 +1511,9 @@ od_console_query(od_console_t *console, od_msg_console_t *msg_console)
 	char *query;
 	machine_msg_t *msg;
 	int rc;
-	rc = kiwi_be_read_query(msg_console->request, &query, &query_len);
+	rc = kiwi_be_read_query(machine_msg_get_data(msg_console->request),
+	                        machine_msg_get_size(msg_console->request),
+	                        &query, &query_len);
 	if (rc == -1) {
 		od_error(&instance->logger, "console", client, NULL,
 		         "bad console command");
@@ -18,6 +18,8 @@
 #include <kiwi.h>
 #include <odyssey.h>
 
+#define OD_CRON_ADAPTIVE_TOLERANCE 2
+
 static int
 od_cron_stat_cb(od_route_t *route, od_stat_t *current, od_stat_t *avg,
                 void *arg)
@@ -88,7 +90,7 @@ od_cron_stat(od_cron_t *cron, od_router_t *router)
 		       count_coroutine_cache);
 
 		od_log(&instance->logger, "stats", NULL, NULL,
-		       "clients %d", router->clients);
+		       "clients %d", od_atomic_u32_of(&router->clients));
 	}
 
 	if (router->route_pool.count == 0)
@@ -120,10 +122,27 @@ od_cron_expire_mark(od_server_t *server, void *arg)
 		return 0;
 	}
 
+	/* shrink pool to the adaptive pool size limit */
+	if (route->config->pool_adaptive) {
+		od_server_pool_t *pool = &route->server_pool;
+		if (od_server_pool_total(pool) - pool->count_expire > route->pool_limit) {
+			od_debug(&instance->logger, "expire", NULL, server,
+			         "pool size limit %d exceeded, schedule closing",
+			         route->pool_limit);
+			od_server_pool_set(pool, server, OD_SERVER_EXPIRE);
+			return 0;
+		}
+	}
+
 	/* expire by time-to-live */
 	if (! route->config->pool_ttl)
 		return 0;
 
+	/* keep minimum pool filled */
+	if (route->server_pool.count_idle <= route->config->pool_min_idle ||
+	    od_server_pool_total(&route->server_pool) <= route->config->pool_min_size)
+		return 0;
+
 	od_debug(&instance->logger, "expire", NULL, server,
 	         "idle time: %d",
 	         server->idle_time);
@@ -183,19 +202,244 @@ od_cron_expire(od_cron_t *cron)
 
 		od_route_t *route = server->route;
 		server->route = NULL;
+		od_route_lock(route);
 		od_server_pool_set(&route->server_pool, server, OD_SERVER_UNDEF);
+		od_storage_server_remove(route->storage);
+		od_router_wakeup(router, route);
+		od_route_unlock(route);
 
 		if (instance->is_shared)
 			machine_io_attach(server->io);
 
 		od_backend_close_connection(server);
 		od_backend_close(server);
+		od_router_storage_wakeup(router, route->storage);
 	}
 
 	/* cleanup unused dynamic routes */
 	od_route_pool_gc(&router->route_pool);
 }
 
+static void
+od_cron_preconnect_server(void *arg)
+{
+	od_server_t *server = arg;
+	od_route_t *route = server->route;
+	od_instance_t *instance = server->global->instance;
+
+	int rc;
+	rc = od_backend_connect(server, "preconnect");
+	if (rc == -1) {
+		/* let waiting clients start their own connection */
+		od_route_lock(route);
+		od_server_pool_set(&route->server_pool, server, OD_SERVER_UNDEF);
+		od_storage_server_remove(route->storage);
+		od_router_wakeup(server->global->router, route);
+		od_route_unlock(route);
+		od_router_storage_wakeup(server->global->router, route->storage);
+		server->route = NULL;
+		od_backend_close_connection(server);
+		od_backend_close(server);
+		return;
+	}
+
+	/* idle server io is not attached to any machine */
+	if (instance->is_shared)
+		machine_io_detach(server->io);
+	server->is_preconnected = 1;
+	od_atomic_u64_inc(&route->stats.count_preconnect);
+
+	od_route_lock(route);
+	od_server_pool_set(&route->server_pool, server, OD_SERVER_IDLE);
+	od_router_wakeup(server->global->router, route);
+	od_route_unlock(route);
+	od_router_storage_wakeup(server->global->router, route->storage);
+}
+
+static inline int
+od_cron_preconnect_route(od_route_t *route, void *arg)
+{
+	od_cron_t *cron = arg;
+	od_instance_t *instance = cron->global->instance;
+	od_config_route_t *config = route->config;
+	if (config->obsolete)
+		return 0;
+	if (! config->pool_min_idle && ! config->pool_min_size)
+		return 0;
+
+	/* count servers to connect, including ones being connected */
+	od_route_lock(route);
+	od_server_pool_t *pool = &route->server_pool;
+	int total = od_server_pool_total(pool);
+	int count;
+	count = config->pool_min_idle - (pool->count_idle + pool->count_connect);
+	if (config->pool_min_size - total > count)
+		count = config->pool_min_size - total;
+	int pool_size = od_route_pool_size(route);
+	if (pool_size > 0 && total + count > pool_size)
+		count = pool_size - total;
+	if (count > config->pool_preconnect_rate)
+		count = config->pool_preconnect_rate;
+
+	int i = 0;
+	for (; i < count; i++) {
+		/* also stops on storage max_connections limit */
+		od_server_t *server;
+		server = od_router_server_new(cron->global->router, route);
+		if (server == NULL)
+			break;
+		od_server_pool_set(pool, server, OD_SERVER_CONNECT);
+
+		int64_t coroutine_id;
+		coroutine_id = machine_coroutine_create(od_cron_preconnect_server, server);
+		if (coroutine_id == -1) {
+			od_server_pool_set(pool, server, OD_SERVER_UNDEF);
+			od_storage_server_remove(route->storage);
+			server->route = NULL;
+			od_backend_close(server);
+			od_error(&instance->logger, "preconnect", NULL, NULL,
+			         "failed to start preconnect coroutine");
+			break;
+		}
+	}
+	od_route_unlock(route);
+	return 0;
+}
+
+static inline void
+od_cron_preconnect(od_cron_t *cron)
+{
+	od_router_t *router = cron->global->router;
+	od_instance_t *instance = cron->global->instance;
+
+	/* Keep minimum of idle or total server connections.
+	 *
+	 * Routes of configs with explicit database and user names
+	 * are created in advance, so their pools are filled before
+	 * the first client. Dynamic routes are filled once they are
+	 * created by a client.
+	 *
+	 * Connections are started in background coroutines, at most
+	 * pool_preconnect_rate per route each second. Connecting
+	 * servers are counted against pool_size.
+	*/
+	od_list_t *i;
+	od_list_foreach(&instance->config.routes, i) {
+		od_config_route_t *config;
+		config = od_container_of(i, od_config_route_t, link);
+		if (config->obsolete)
+			continue;
+		if (! config->pool_min_idle && ! config->pool_min_size)
+			continue;
+		if (config->db_is_default || config->user_is_default)
+			continue;
+		od_route_t *route;
+		route = od_router_route_config(router, config);
+		if (route == NULL)
+			return;
+	}
+
+	od_route_pool_foreach(&router->route_pool, od_cron_preconnect_route, cron);
+}
+
+static inline int
+od_cron_adaptive_route(od_route_t *route, void *arg)
+{
+	od_router_t *router = arg;
+	od_instance_t *instance = router->global->instance;
+	od_config_route_t *config = route->config;
+	if (! config->pool_adaptive || config->obsolete)
+		return 0;
+
+	/* query time and pool wait since the previous tick */
+	od_stat_t current;
+	od_stat_copy(&current, &route->stats);
+	od_stat_t *prev = &route->pool_limit_stats;
+	uint64_t count_query = current.count_query - prev->count_query;
+	uint64_t count_wait  = current.count_wait - prev->count_wait;
+	uint64_t query_time  = 0;
+	uint64_t wait_time   = 0;
+	if (count_query > 0)
+		query_time = (current.query_time - prev->query_time) / count_query;
+	if (count_wait > 0)
+		wait_time = (current.wait_time - prev->wait_time) / count_wait;
+	*prev = current;
+
+	od_route_lock(route);
+	int count_queue = route->client_pool.count_queue;
+	od_route_unlock(route);
+
+	int limit = route->pool_limit;
+	uint64_t latency = route->pool_limit_latency;
+	if (count_query > 0) {
+		/* Additive increase, multiplicative decrease.
+		 *
+		 * Query time is compared against its moving average,
+		 * which approximates the unloaded latency. A query time
+		 * growing above the tolerance means the server is
+		 * saturated and the limit is cut down. Otherwise the
+		 * limit grows by one while clients have to wait for a
+		 * server connection.
+		*/
+		if (latency == 0)
+			latency = query_time;
+		if (query_time > latency * OD_CRON_ADAPTIVE_TOLERANCE)
+			limit = (limit * 3) / 4;
+		else
+		if (count_wait > 0 || count_queue > 0)
+			limit++;
+		latency = (latency * 7 + query_time) / 8;
+	} else
+	if (count_queue > 0) {
+		/* clients wait without any query being finished */
+		limit++;
+	}
+	if (limit < config->pool_size_min)
+		limit = config->pool_size_min;
+	if (limit > config->pool_size)
+		limit = config->pool_size;
+	route->pool_limit_latency = latency;
+	if (limit == route->pool_limit)
+		return 0;
+
+	od_log(&instance->logger, "adaptive", NULL, NULL,
+	       "[%.*s.%.*s] pool size %d -> %d "
+	       "(query %" PRIu64 " usec, average %" PRIu64 " usec, "
+	       "%" PRIu64 " waits %" PRIu64 " usec, %d queued)",
+	       route->id.database_len - 1,
+	       route->id.database,
+	       route->id.user_len - 1,
+	       route->id.user,
+	       route->pool_limit, limit,
+	       query_time, latency,
+	       count_wait, wait_time,
+	       count_queue);
+
+	od_route_lock(route);
+	int count = limit - route->pool_limit;
+	route->pool_limit = limit;
+	/* let queued clients use added server slots */
+	while (count-- > 0)
+		od_router_wakeup(router, route);
+	od_route_unlock(route);
+	od_router_storage_wakeup(router, route->storage);
+	return 0;
+}
+
+static inline void
+od_cron_adaptive(od_cron_t *cron)
+{
+	od_router_t *router = cron->global->router;
+
+	/* Adjust pool size limit of adaptive routes.
+	 *
+	 * Surplus idle servers are closed by the expire mark,
+	 * active servers are closed once they became idle.
+	*/
+	od_route_pool_foreach(&router->route_pool, od_cron_adaptive_route,
+	                      router);
+}
+
 static void
 od_cron(void *arg)
 {
@@ -211,6 +455,15 @@ od_cron(void *arg)
 		/* mark and sweep expired idle server connections */
 		od_cron_expire(cron);
 
+		/* adjust adaptive pool size limits */
+		od_cron_adaptive(cron);
+
+		/* start server connections to keep minimum pool size */
+		od_cron_preconnect(cron);
+
+		/* refresh or expire cached storage host addresses */
+		od_dns_refresh(cron->global);
+
 		/* update statistics */
 		if (++stats_tick >= instance->config.stats_interval) {
 			od_cron_stat(cron, router);
@@ -19,35 +19,80 @@
 #include <odyssey.h>
 
 static inline int
-od_deploy_add(kiwi_params_t *params, char *query, int size,
+od_deploy_add(od_server_t *server, kiwi_params_t *params, int discard,
+              char *query, int size,
               char *name, int name_len)
 {
 	kiwi_param_t *client_param;
 	client_param = kiwi_params_find(params, name, name_len);
-	if (client_param == NULL)
+	kiwi_param_t *deploy_param;
+	deploy_param = kiwi_params_find(&server->deploy_params, name, name_len);
+
+	/* restore server default, if parameter was previously
+	 * set for a different client */
+	if (client_param == NULL) {
+		if (deploy_param == NULL)
+			return 0;
+		kiwi_params_remove(&server->deploy_params, deploy_param);
+		return od_snprintf(query, size, "RESET %s;", name);
+	}
+
+	/* compare with the last reported or deployed value */
+	kiwi_param_t *server_param = NULL;
+	if (! discard) {
+		server_param = kiwi_params_find(&server->params, name, name_len);
+		if (server_param == NULL)
+			server_param = deploy_param;
+	}
+	if (server_param &&
+	    server_param->value_len == client_param->value_len &&
+	    memcmp(kiwi_param_value(server_param),
+	           kiwi_param_value(client_param),
+	           client_param->value_len) == 0)
 		return 0;
+
 	char quote_value[256];
 	int rc;
 	rc = kiwi_enquote(kiwi_param_value(client_param), quote_value,
 	                  sizeof(quote_value));
 	if (rc == -1)
 		return 0;
-	return od_snprintf(query, size, "SET %s=%s;",
-	                   kiwi_param_name(client_param),
-	                   quote_value);
+	rc = od_snprintf(query, size, "SET %s=%s;",
+	                 kiwi_param_name(client_param),
+	                 quote_value);
+
+	/* track deployed value, parameter might not be reported
+	 * by server */
+	kiwi_param_t *param;
+	param = kiwi_param_allocate(kiwi_param_name(client_param),
+	                            client_param->name_len,
+	                            kiwi_param_value(client_param),
+	                            client_param->value_len);
+	if (param == NULL)
+		return -1;
+	kiwi_params_replace(&server->deploy_params, param);
+	return rc;
 }
 
-int
-od_deploy_write(od_server_t *server, char *context, kiwi_params_t *params)
+static inline int
+od_deploy_discard(od_server_t *server)
 {
-	od_instance_t *instance = server->global->instance;
+	od_route_t *route = server->route;
 
-	/* discard */
-	int  query_count = 1;
+	/* discard, keep prepared statements shared by clients
+	 * (same as DISCARD ALL without DEALLOCATE ALL) */
 	char query_discard[] = "DISCARD ALL";
+	char query_discard_prepared[] =
+		"CLOSE ALL; SET SESSION AUTHORIZATION DEFAULT; RESET ALL; "
+		"UNLISTEN *; SELECT pg_advisory_unlock_all(); "
+		"DISCARD PLANS; DISCARD SEQUENCES; DISCARD TEMP";
 
 	machine_msg_t *msg;
-	msg = kiwi_fe_write_query(query_discard, sizeof(query_discard));
+	if (route->config->prepared_statements)
+		msg = kiwi_fe_write_query(query_discard_prepared,
+		                          sizeof(query_discard_prepared));
+	else
+		msg = kiwi_fe_write_query(query_discard, sizeof(query_discard));
 	if (msg == NULL)
 		return -1;
 	int rc;
@@ -55,25 +100,56 @@ od_deploy_write(od_server_t *server, char *context, kiwi_params_t *params)
 	if (rc == -1)
 		return -1;
 
-	/* parameters */
+	/* parameters are reset to server defaults, last reported
+	 * values are updated by the following replies */
+	kiwi_params_free(&server->deploy_params);
+	kiwi_params_init(&server->deploy_params);
+	server->is_dirty = 0;
+	return 0;
+}
+
+int
+od_deploy_write(od_server_t *server, char *context, kiwi_params_t *params)
+{
+	od_instance_t *instance = server->global->instance;
+	od_route_t *route = server->route;
+
+	/* discard only if previous client might have left
+	 * session state */
+	int query_count = 0;
+	int discard = server->is_dirty;
+	int rc;
+	if (discard) {
+		rc = od_deploy_discard(server);
+		if (rc == -1)
+			return -1;
+		query_count++;
+	}
+
+	/* parameters, send only those which differ from the current
+	 * server state (all of them after discard) */
+	char *names[] = {
+		"TimeZone",
+		"DateStyle",
+		"client_encoding",
+		"application_name",
+		"extra_float_digits",
+		"standard_conforming_strings",
+		"statement_timeout",
+		"search_path"
+	};
 	char query[512];
 	int  size = 0;
-	size += od_deploy_add(params, query + size, sizeof(query) - size,
-	                      "TimeZone", 9);
-	size += od_deploy_add(params, query + size, sizeof(query) - size,
-	                      "DateStyle", 10);
-	size += od_deploy_add(params, query + size, sizeof(query) - size,
-	                      "client_encoding", 16);
-	size += od_deploy_add(params, query + size, sizeof(query) - size,
-	                      "application_name", 17);
-	size += od_deploy_add(params, query + size, sizeof(query) - size,
-	                      "extra_float_digits", 19);
-	size += od_deploy_add(params, query + size, sizeof(query) - size,
-	                      "standard_conforming_strings", 28);
-	size += od_deploy_add(params, query + size, sizeof(query) - size,
-	                      "statement_timeout", 18);
-	size += od_deploy_add(params, query + size, sizeof(query) - size,
-	                      "search_path", 12);
+	int  i = 0;
+	for (; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+		rc = od_deploy_add(server, params, discard,
+		                   query + size, sizeof(query) - size,
+		                   names[i], strlen(names[i]) + 1);
+		if (rc == -1)
+			return -1;
+		size += rc;
+	}
+
 	if (size == 0) {
 		od_debug(&instance->logger, context, server->client, server,
 		         "%s", "no need to configure");
@@ -82,6 +158,7 @@ od_deploy_write(od_server_t *server, char *context, kiwi_params_t *params)
 		         "%s", query);
 		size++;
 		query_count++;
+		machine_msg_t *msg;
 		msg = kiwi_fe_write_query(query, size);
 		if (msg == NULL)
 			return -1;
@@ -90,5 +167,127 @@ od_deploy_write(od_server_t *server, char *context, kiwi_params_t *params)
 			return -1;
 	}
 
+	/* update deploy stats */
+	od_atomic_u64_inc(&route->stats.count_deploy);
+	if (! discard) {
+		if (query_count == 0)
+			od_atomic_u64_inc(&route->stats.count_deploy_skip);
+		else
+			od_atomic_u64_inc(&route->stats.count_deploy_short);
+	}
+
 	return query_count;
 }
+
+static inline int
+od_deploy_keyword(char *pos, char *end)
+{
+	/* statements which might leave session state behind,
+	 * matched at the word start, false positives only
+	 * force discard */
+	static struct {
+		char *name;
+		int   name_len;
+	} keywords[] = {
+		{ "set",         3 },
+		{ "reset",       5 },
+		{ "prepare",     7 },
+		{ "deallocate", 10 },
+		{ "declare",     7 },
+		{ "listen",      6 },
+		{ "unlisten",    8 },
+		{ "temp",        4 },
+		{ "pg_advisory", 11 },
+		{ "load",        4 },
+		{ "discard",     7 },
+		{ NULL,          0 }
+	};
+	int i = 0;
+	for (; keywords[i].name; i++) {
+		if (keywords[i].name[0] != (*pos | 0x20))
+			continue;
+		if (end - pos < keywords[i].name_len)
+			continue;
+		if (strncasecmp(pos, keywords[i].name, keywords[i].name_len) == 0)
+			return 1;
+	}
+	return 0;
+}
+
+static inline int
+od_deploy_word(char **pos, char *end, char *word, int word_len)
+{
+	/* match whole word and skip the following spaces */
+	char *p = *pos;
+	if (end - p < word_len || strncasecmp(p, word, word_len) != 0)
+		return 0;
+	p += word_len;
+	if (p < end && (isalnum((unsigned char)*p) || *p == '_'))
+		return 0;
+	while (p < end && isspace((unsigned char)*p))
+		p++;
+	*pos = p;
+	return 1;
+}
+
+static inline int
+od_deploy_deallocate(char *pos, char *end)
+{
+	/* DEALLOCATE [PREPARE] ALL and DISCARD ALL statements drop
+	 * statements prepared by the pooler */
+	if (od_deploy_word(&pos, end, "deallocate", 10)) {
+		od_deploy_word(&pos, end, "prepare", 7);
+		return od_deploy_word(&pos, end, "all", 3);
+	}
+	if (od_deploy_word(&pos, end, "discard", 7))
+		return od_deploy_word(&pos, end, "all", 3);
+	return 0;
+}
+
+static inline int
+od_deploy_prepared(od_client_t *client)
+{
+	od_server_t *server = client->server;
+	return server->prepare_map.count > 0 ||
+	       client->prepare_map.count > 0;
+}
+
+void
+od_deploy_track(od_client_t *client, char *query, int query_len)
+{
+	od_server_t *server = client->server;
+
+	/* dirty server is still tracked, while it or client
+	 * keeps statements prepared by the pooler */
+	if (server->is_dirty && ! od_deploy_prepared(client))
+		return;
+	char *pos = query;
+	char *end = query + query_len;
+	int word = 0;
+	int statement = 1;
+	for (; pos < end; pos++) {
+		int is_word = isalnum((unsigned char)*pos) || *pos == '_';
+		if (is_word && !word) {
+			if (statement && od_deploy_deallocate(pos, end)) {
+				/* server statements are prepared again on use,
+				 * client ones are gone */
+				od_prepare_map_free(&server->prepare_map);
+				od_prepare_queue_forget(&server->prepare_queue, NULL);
+				od_prepare_map_free(&client->prepare_map);
+				server->is_dirty = 1;
+				return;
+			}
+			if (od_deploy_keyword(pos, end)) {
+				server->is_dirty = 1;
+				if (! od_deploy_prepared(client))
+					return;
+			}
+		}
+		if (*pos == ';')
+			statement = 1;
+		else
+		if (! isspace((unsigned char)*pos))
+			statement = 0;
+		word = is_word;
+	}
+}
@@ -7,6 +7,7 @@
  * Scalable PostgreSQL connection pooler.
 */
 
-int od_deploy_write(od_server_t*, char*, kiwi_params_t*);
+int  od_deploy_write(od_server_t*, char*, kiwi_params_t*);
+void od_deploy_track(od_client_t*, char*, int);
 
 #endif /* ODYSSEY_DEPLOY_H */
@@ -0,0 +1,267 @@
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+*/
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#include <machinarium.h>
+#include <kiwi.h>
+#include <odyssey.h>
+
+/* refresh used names ahead of ttl expiration, so
+ * connections never wait for a resolve of a known name */
+#define OD_DNS_REFRESH_AHEAD 2
+
+void
+od_dns_init(od_dns_t *dns)
+{
+	pthread_mutex_init(&dns->lock, NULL);
+	od_list_init(&dns->entries);
+	dns->count = 0;
+	dns->count_queries = 0;
+	dns->count_pending = 0;
+}
+
+static inline void
+od_dns_entry_free(od_dns_entry_t *entry)
+{
+	free(entry->host);
+	free(entry);
+}
+
+void
+od_dns_free(od_dns_t *dns)
+{
+	od_list_t *i, *n;
+	od_list_foreach_safe(&dns->entries, i, n) {
+		od_dns_entry_t *entry;
+		entry = od_container_of(i, od_dns_entry_t, link);
+		od_dns_entry_free(entry);
+	}
+	pthread_mutex_destroy(&dns->lock);
+}
+
+static inline od_dns_entry_t*
+od_dns_match(od_dns_t *dns, char *host, int port)
+{
+	od_list_t *i;
+	od_list_foreach(&dns->entries, i) {
+		od_dns_entry_t *entry;
+		entry = od_container_of(i, od_dns_entry_t, link);
+		if (entry->port == port && strcmp(entry->host, host) == 0)
+			return entry;
+	}
+	return NULL;
+}
+
+static inline int
+od_dns_ttl(od_config_t *config, od_dns_entry_t *entry)
+{
+	if (entry->status == -1)
+		return config->dns_negative_ttl;
+	return config->dns_ttl;
+}
+
+static inline int
+od_dns_is_expired(od_config_t *config, od_dns_entry_t *entry, uint64_t now)
+{
+	uint64_t ttl = (uint64_t)od_dns_ttl(config, entry) * 1000000;
+	return now - entry->time_resolve >= ttl;
+}
+
+static inline int
+od_dns_query(od_dns_t *dns, char *host, int port,
+             struct sockaddr_storage *addr, int addr_max)
+{
+	char service[16];
+	od_snprintf(service, sizeof(service), "%d", port);
+
+	/* schedule getaddrinfo() execution */
+	od_atomic_u64_inc(&dns->count_queries);
+	od_atomic_u32_inc(&dns->count_pending);
+	struct addrinfo *ai = NULL;
+	int rc;
+	rc = machine_getaddrinfo(host, service, NULL, &ai, 0);
+	od_atomic_u32_dec(&dns->count_pending);
+	if (rc != 0)
+		return -1;
+	assert(ai != NULL);
+
+	/* keep the whole address list in the order returned,
+	 * skip duplicates of different socket types */
+	int count = 0;
+	struct addrinfo *next = ai;
+	for (; next && count < addr_max; next = next->ai_next) {
+		if (next->ai_addrlen > sizeof(*addr))
+			continue;
+		struct sockaddr_storage current;
+		memset(&current, 0, sizeof(current));
+		memcpy(&current, next->ai_addr, next->ai_addrlen);
+		int j = 0;
+		for (; j < count; j++)
+			if (memcmp(&addr[j], &current, sizeof(current)) == 0)
+				break;
+		if (j < count)
+			continue;
+		addr[count++] = current;
+	}
+	freeaddrinfo(ai);
+	if (count == 0)
+		return -1;
+	return count;
+}
+
+static inline void
+od_dns_update(od_dns_t *dns, od_config_t *config, char *host, int port,
+              int count, struct sockaddr_storage *addr)
+{
+	int status = count == -1 ? -1 : 0;
+	uint64_t now = machine_time();
+	pthread_mutex_lock(&dns->lock);
+	od_dns_entry_t *entry;
+	entry = od_dns_match(dns, host, port);
+	if (entry == NULL) {
+		entry = malloc(sizeof(*entry));
+		if (entry == NULL)
+			goto done;
+		entry->host = strdup(host);
+		if (entry->host == NULL) {
+			free(entry);
+			goto done;
+		}
+		entry->port = port;
+		entry->addr_count = 0;
+		od_list_init(&entry->link);
+		od_list_append(&dns->entries, &entry->link);
+		dns->count++;
+	} else
+	if (status == -1 && entry->status == 0 &&
+	    !od_dns_is_expired(config, entry, now)) {
+		/* failed refresh, keep addresses until expired */
+		goto done;
+	}
+	entry->status = status;
+	if (status == 0) {
+		memcpy(entry->addr, addr, sizeof(*addr) * count);
+		entry->addr_count = count;
+	}
+	entry->time_resolve = now;
+	entry->is_used = 0;
+done:
+	pthread_mutex_unlock(&dns->lock);
+}
+
+int
+od_dns_resolve(od_global_t *global, char *host, int port,
+               struct sockaddr_storage *addr, int addr_max)
+{
+	od_instance_t *instance = global->instance;
+	od_router_t *router = global->router;
+	od_dns_t *dns = &router->dns;
+	od_config_t *config = &instance->config;
+
+	/* caching disabled */
+	if (config->dns_ttl == 0)
+		return od_dns_query(dns, host, port, addr, addr_max);
+
+	/* use cached addresses or cached resolve failure */
+	pthread_mutex_lock(&dns->lock);
+	od_dns_entry_t *entry;
+	entry = od_dns_match(dns, host, port);
+	if (entry && !od_dns_is_expired(config, entry, machine_time())) {
+		int count = -1;
+		if (entry->status == 0) {
+			count = entry->addr_count;
+			if (count > addr_max)
+				count = addr_max;
+			memcpy(addr, entry->addr, sizeof(*addr) * count);
+		}
+		entry->is_used = 1;
+		pthread_mutex_unlock(&dns->lock);
+		return count;
+	}
+	pthread_mutex_unlock(&dns->lock);
+
+	/* resolve and cache the result, concurrent misses
+	 * of the same name are resolved independently */
+	struct sockaddr_storage resolved[OD_DNS_ADDR_MAX];
+	int count;
+	count = od_dns_query(dns, host, port, resolved, OD_DNS_ADDR_MAX);
+	od_dns_update(dns, config, host, port, count, resolved);
+	if (count == -1)
+		return -1;
+	if (count > addr_max)
+		count = addr_max;
+	memcpy(addr, resolved, sizeof(*addr) * count);
+	return count;
+}
+
+void
+od_dns_refresh(od_global_t *global)
+{
+	od_instance_t *instance = global->instance;
+	od_router_t *router = global->router;
+	od_dns_t *dns = &router->dns;
+	od_config_t *config = &instance->config;
+
+	/* Background refresh.
+	 *
+	 * Names used since the last resolve are resolved again
+	 * ahead of ttl expiration, unused and expired names are
+	 * removed from the cache.
+	 *
+	 * Entries are freed only here, so they can be resolved
+	 * without the lock held.
+	*/
+	uint64_t now = machine_time();
+	od_dns_entry_t **refresh = NULL;
+	int refresh_count = 0;
+
+	pthread_mutex_lock(&dns->lock);
+	if (dns->count > 0)
+		refresh = malloc(sizeof(od_dns_entry_t*) * dns->count);
+	od_list_t *i, *n;
+	od_list_foreach_safe(&dns->entries, i, n) {
+		od_dns_entry_t *entry;
+		entry = od_container_of(i, od_dns_entry_t, link);
+		uint64_t age = (now - entry->time_resolve) / 1000000;
+		if (entry->status == 0 && entry->is_used &&
+		    age + OD_DNS_REFRESH_AHEAD >= (uint64_t)config->dns_ttl) {
+			if (refresh)
+				refresh[refresh_count++] = entry;
+			continue;
+		}
+		if (! od_dns_is_expired(config, entry, now))
+			continue;
+		od_list_unlink(&entry->link);
+		dns->count--;
+		od_dns_entry_free(entry);
+	}
+	pthread_mutex_unlock(&dns->lock);
+
+	int j = 0;
+	for (; j < refresh_count; j++) {
+		od_dns_entry_t *entry = refresh[j];
+		struct sockaddr_storage addr[OD_DNS_ADDR_MAX];
+		int count;
+		count = od_dns_query(dns, entry->host, entry->port, addr,
+		                     OD_DNS_ADDR_MAX);
+		if (count == -1) {
+			od_error(&instance->logger, "dns", NULL, NULL,
+			         "failed to refresh %s:%d",
+			         entry->host, entry->port);
+		}
+		od_dns_update(dns, config, entry->host, entry->port, count, addr);
+	}
+	free(refresh);
+}
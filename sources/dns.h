@@ -0,0 +1,42 @@
+#ifndef ODYSSEY_DNS_H
+#define ODYSSEY_DNS_H
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+*/
+
+typedef struct od_dns_entry od_dns_entry_t;
+typedef struct od_dns       od_dns_t;
+
+/* addresses cached for a name, connect tries them in turn */
+#define OD_DNS_ADDR_MAX 8
+
+struct od_dns_entry
+{
+	char                    *host;
+	int                      port;
+	int                      status;
+	struct sockaddr_storage  addr[OD_DNS_ADDR_MAX];
+	int                      addr_count;
+	uint64_t                 time_resolve;
+	int                      is_used;
+	od_list_t                link;
+};
+
+struct od_dns
+{
+	pthread_mutex_t lock;
+	od_list_t       entries;
+	int             count;
+	od_atomic_u64_t count_queries;
+	od_atomic_u32_t count_pending;
+};
+
+void od_dns_init(od_dns_t*);
+void od_dns_free(od_dns_t*);
+int  od_dns_resolve(od_global_t*, char*, int, struct sockaddr_storage*, int);
+void od_dns_refresh(od_global_t*);
+
+#endif /* ODYSSEY_DNS_H */
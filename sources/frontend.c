@@ -13,6 +13,7 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <errno.h>
 
 #include <machinarium.h>
 #include <kiwi.h>
@@ -30,7 +31,8 @@ typedef enum {
 	OD_FE_ESERVER_WRITE,
 	OD_FE_ECLIENT_READ,
 	OD_FE_ECLIENT_WRITE,
-	OD_FE_ECLIENT_CONFIGURE
+	OD_FE_ECLIENT_CONFIGURE,
+	OD_FE_ETRANSACTION_BLOCK
 } od_frontend_rc_t;
 
 void
@@ -77,7 +79,9 @@ od_frontend_error_fwd(od_client_t *client)
 	assert(server->error_connect != NULL);
 	kiwi_fe_error_t error;
 	int rc;
-	rc = kiwi_fe_read_error(server->error_connect, &error);
+	rc = kiwi_fe_read_error(machine_msg_get_data(server->error_connect),
+	                        machine_msg_get_size(server->error_connect),
+	                        &error);
 	if (rc == -1)
 		return -1;
 	char text[512];
@@ -330,12 +334,38 @@ od_frontend_setup_params(od_client_t *client, kiwi_params_t *params)
 	return OD_FE_OK;
 }
 
+static inline int
+od_frontend_startup_read_only(od_client_t *client)
+{
+	/* session started with default_transaction_read_only */
+	char name[] = "default_transaction_read_only";
+	kiwi_param_t *param;
+	param = kiwi_params_find(&client->startup.params, name, sizeof(name));
+	if (param == NULL)
+		return 0;
+	char *value = kiwi_param_value(param);
+	return strcasecmp(value, "on")   == 0 ||
+	       strcasecmp(value, "true") == 0 ||
+	       strcasecmp(value, "yes")  == 0 ||
+	       strcmp(value, "1") == 0;
+}
+
 static inline od_frontend_rc_t
 od_frontend_setup(od_client_t *client)
 {
 	od_instance_t *instance = client->global->instance;
 	od_route_t *route = client->route;
 
+	/* read-only clients are served by the replica route */
+	client->is_read_only = client->config_listen->read_only ||
+	                       od_frontend_startup_read_only(client);
+
+	/* set client write queue watermarks */
+	int write_high;
+	int write_low;
+	od_client_write_watermark(client, &write_high, &write_low);
+	machine_set_write_watermark(client->io, write_high, write_low);
+
 	/* copy route cached params to reduce possible lock contention */
 	kiwi_params_t route_params;
 	kiwi_params_init(&route_params);
@@ -353,186 +383,1424 @@ retry:;
 	od_frontend_rc_t fe_rc;
 	if (! route_params.count)
 	{
-		fe_rc = od_frontend_attach(client, "setup");
-		if (fe_rc != OD_FE_OK)
-			return fe_rc;
-		od_router_close(client);
-
-		/* update params once again */
-		goto retry;
+		fe_rc = od_frontend_attach(client, "setup");
+		if (fe_rc != OD_FE_OK)
+			return fe_rc;
+		od_router_close(client);
+
+		/* update params once again */
+		goto retry;
+	}
+
+	/* write paremeter status messages */
+	fe_rc = od_frontend_setup_params(client, &route_params);
+	kiwi_params_free(&route_params);
+	if (fe_rc != OD_FE_OK)
+		return fe_rc;
+	fe_rc = od_frontend_setup_params(client, &client->startup.params);
+	if (fe_rc != OD_FE_OK)
+		return fe_rc;
+
+	/* copy client startup parameters */
+	rc = kiwi_params_copy(&client->params, &client->startup.params);
+	if (rc == -1)
+		return OD_FE_ECLIENT_CONFIGURE;
+
+	/* write key data message */
+	machine_msg_t *msg;
+	msg = kiwi_be_write_backend_key_data(client->key.key_pid, client->key.key);
+	if (msg == NULL)
+		return OD_FE_ECLIENT_CONFIGURE;
+	rc = machine_write(client->io, msg);
+	if (rc == -1)
+		return OD_FE_ECLIENT_WRITE;
+
+	/* write ready message */
+	msg = kiwi_be_write_ready('I');
+	if (msg == NULL)
+		return OD_FE_ECLIENT_CONFIGURE;
+	rc = machine_write(client->io, msg);
+	if (rc == -1)
+		return OD_FE_ECLIENT_WRITE;
+
+	/* done */
+	rc = machine_flush(client->io, UINT32_MAX);
+	if (rc == -1)
+		return OD_FE_ECLIENT_WRITE;
+
+	client->time_setup = machine_time();
+
+	if (instance->config.log_session) {
+		od_log(&instance->logger, "setup", client, NULL,
+		       "login time: %d microseconds",
+		       (client->time_setup - client->time_accept));
+	}
+
+	return OD_FE_OK;
+}
+
+static inline int
+od_frontend_drain(od_client_t *client, machine_io_t *io)
+{
+	/* wait until write queue drops to the low watermark,
+	 * periodically check for kill request */
+	for (;;)
+	{
+		int rc;
+		rc = machine_write_wait(io, 1000);
+		if (rc == 0)
+			return 0;
+		if (! machine_timedout())
+			return -1;
+		if (client->ctl.op == OD_CLIENT_OP_KILL)
+			return -1;
+	}
+}
+
+typedef enum {
+	OD_FE_RELAY_FORWARD,
+	OD_FE_RELAY_SKIP,
+	OD_FE_RELAY_DETACH,
+	OD_FE_RELAY_REJECT
+} od_frontend_relay_t;
+
+typedef od_frontend_rc_t
+(*od_frontend_handle_t)(od_client_t*, char*, uint32_t, od_frontend_relay_t*);
+
+typedef int
+(*od_frontend_streamable_t)(od_client_t*, int);
+
+static inline od_frontend_rc_t
+od_frontend_relay(od_client_t *client,
+                  machine_io_t *src,
+                  machine_io_t *dst,
+                  od_frontend_handle_t handle,
+                  od_frontend_rc_t write_error,
+                  od_frontend_relay_t *relay,
+                  int *relayed)
+{
+	*relay = OD_FE_RELAY_FORWARD;
+	*relayed = 0;
+
+	/* forward complete messages directly from the source
+	 * readahead buffer, only handlers are allowed to look
+	 * into the messages */
+	char *data;
+	int data_size;
+	data_size = machine_read_peek(src, &data);
+	if (data_size <= 0)
+		return OD_FE_OK;
+
+	od_frontend_rc_t fe_rc = OD_FE_OK;
+	int pos = 0;
+	int run = 0;
+	while ((uint32_t)(data_size - pos) >= sizeof(kiwi_header_t))
+	{
+		uint32_t size;
+		size = kiwi_read_size(data + pos, sizeof(kiwi_header_t));
+		if (size > (uint32_t)(data_size - pos) - sizeof(kiwi_header_t))
+			break;
+		size += sizeof(kiwi_header_t);
+
+		fe_rc = handle(client, data + pos, size, relay);
+		if (fe_rc != OD_FE_OK)
+			break;
+
+		if (*relay == OD_FE_RELAY_SKIP ||
+		    *relay == OD_FE_RELAY_REJECT ||
+		    client->relay_msg) {
+			/* forward messages before the skipped one */
+			int rc;
+			if (pos > run) {
+				rc = machine_write_direct(dst, data + run, pos - run);
+				if (rc == -1)
+					return write_error;
+			}
+			/* message replaced by the handler */
+			if (client->relay_msg) {
+				rc = machine_write(dst, client->relay_msg);
+				client->relay_msg = NULL;
+				if (rc == -1)
+					return write_error;
+			}
+			pos += size;
+			run  = pos;
+			if (*relay == OD_FE_RELAY_REJECT ||
+			    *relay == OD_FE_RELAY_DETACH)
+				break;
+			*relay = OD_FE_RELAY_FORWARD;
+			continue;
+		}
+		pos += size;
+
+		/* stop before any data after the message which
+		 * requires the server to be detached */
+		if (*relay == OD_FE_RELAY_DETACH)
+			break;
+	}
+
+	if (pos > run) {
+		int rc;
+		rc = machine_write_direct(dst, data + run, pos - run);
+		if (rc == -1)
+			return write_error;
+	}
+	machine_read_advance(src, pos);
+	*relayed = pos;
+	return fe_rc;
+}
+
+static inline int
+od_frontend_relay_wait(od_client_t *client, machine_io_t *src)
+{
+	od_instance_t *instance = client->global->instance;
+
+	/* wait for the rest of a partially buffered message which
+	 * fits into readahead, so it can be relayed in place instead
+	 * of being copied */
+	for (;;)
+	{
+		char *data;
+		int data_size;
+		data_size = machine_read_peek(src, &data);
+		if (data_size <= 0)
+			return 0;
+		uint32_t size = sizeof(kiwi_header_t);
+		if ((uint32_t)data_size >= size)
+			size += kiwi_read_size(data, sizeof(kiwi_header_t));
+		if (size <= (uint32_t)data_size)
+			return 1;
+		if (size > (uint32_t)instance->config.readahead)
+			return 0;
+		int rc;
+		rc = machine_read_wait(src, size, UINT32_MAX);
+		if (rc == -1)
+			return -1;
+	}
+}
+
+static inline od_frontend_rc_t
+od_frontend_stream(od_client_t *client,
+                   machine_io_t *src,
+                   machine_io_t *dst,
+                   machine_msg_t *msg,
+                   uint32_t size,
+                   od_frontend_handle_t handle,
+                   od_frontend_rc_t read_error,
+                   od_frontend_rc_t write_error,
+                   int splice,
+                   od_frontend_relay_t *relay,
+                   int *relayed)
+{
+	od_instance_t *instance = client->global->instance;
+
+	/* handler can look only at the message header */
+	od_frontend_rc_t fe_rc;
+	fe_rc = handle(client, machine_msg_get_data(msg),
+	               machine_msg_get_size(msg), relay);
+	if (fe_rc != OD_FE_OK) {
+		machine_msg_free(msg);
+		return fe_rc;
+	}
+	assert(*relay == OD_FE_RELAY_FORWARD);
+	assert(client->relay_msg == NULL);
+
+	*relayed = machine_msg_get_size(msg);
+	int rc;
+	rc = machine_write_direct(dst, machine_msg_get_data(msg),
+	                          machine_msg_get_size(msg));
+	machine_msg_free(msg);
+	if (rc == -1)
+		return write_error;
+
+	/* move message body from socket to socket inside the kernel,
+	 * not possible with TLS */
+	if (splice) {
+		rc = machine_splice(src, dst, size, UINT32_MAX);
+		if (rc == 0) {
+			*relayed += size;
+			return OD_FE_OK;
+		}
+		if (machine_errno() != ENOTSUP) {
+			if (! machine_connected(src))
+				return read_error;
+			return write_error;
+		}
+	}
+
+	/* forward message body in readahead-sized chunks */
+	uint32_t chunk = instance->config.readahead;
+	while (size > 0)
+	{
+		uint32_t to_read = size;
+		if (to_read > chunk)
+			to_read = chunk;
+		msg = machine_read(src, to_read, UINT32_MAX);
+		if (msg == NULL)
+			return read_error;
+		rc = machine_write(dst, msg);
+		if (rc == -1)
+			return write_error;
+		size -= to_read;
+		*relayed += to_read;
+
+		/* do not outrun a slow receiver */
+		if (machine_write_overflow(dst)) {
+			rc = od_frontend_drain(client, dst);
+			if (rc == -1)
+				return write_error;
+		}
+	}
+	return OD_FE_OK;
+}
+
+static inline od_frontend_rc_t
+od_frontend_relay_msg(od_client_t *client,
+                      machine_io_t *src,
+                      machine_io_t *dst,
+                      od_frontend_handle_t handle,
+                      od_frontend_streamable_t streamable,
+                      od_frontend_rc_t read_error,
+                      od_frontend_rc_t write_error,
+                      od_frontend_relay_t *relay,
+                      int *relayed)
+{
+	od_instance_t *instance = client->global->instance;
+
+	*relay = OD_FE_RELAY_FORWARD;
+	*relayed = 0;
+
+	/* read message header */
+	machine_msg_t *msg;
+	msg = machine_read(src, sizeof(kiwi_header_t), UINT32_MAX);
+	if (msg == NULL)
+		return read_error;
+	uint32_t size;
+	size = kiwi_read_size(machine_msg_get_data(msg), sizeof(kiwi_header_t));
+
+	/* splice CopyData payload which does not fit into readahead */
+	int type = *(char*)machine_msg_get_data(msg);
+	if (instance->config.copy_splice && type == KIWI_FE_COPY_DATA &&
+	    client->server->is_copy &&
+	    size > (uint32_t)instance->config.readahead) {
+		return od_frontend_stream(client, src, dst, msg, size, handle,
+		                          read_error, write_error, 1,
+		                          relay, relayed);
+	}
+
+	/* stream oversized messages without buffering them */
+	int stream_threshold = instance->config.stream_threshold;
+	if (stream_threshold > 0 && size > (uint32_t)stream_threshold) {
+		if (streamable(client, type))
+			return od_frontend_stream(client, src, dst, msg, size, handle,
+			                          read_error, write_error, 0,
+			                          relay, relayed);
+	}
+
+	int rc;
+	rc = machine_read_to(src, msg, size, UINT32_MAX);
+	if (rc == -1) {
+		machine_msg_free(msg);
+		return read_error;
+	}
+	*relayed = machine_msg_get_size(msg);
+
+	od_frontend_rc_t fe_rc;
+	fe_rc = handle(client, machine_msg_get_data(msg),
+	               machine_msg_get_size(msg), relay);
+	if (fe_rc != OD_FE_OK || *relay == OD_FE_RELAY_SKIP ||
+	    *relay == OD_FE_RELAY_REJECT) {
+		machine_msg_free(msg);
+		if (client->relay_msg) {
+			machine_msg_free(client->relay_msg);
+			client->relay_msg = NULL;
+		}
+		return fe_rc;
+	}
+
+	/* message replaced by the handler */
+	if (client->relay_msg) {
+		machine_msg_free(msg);
+		msg = client->relay_msg;
+		client->relay_msg = NULL;
+	}
+
+	/* forward message */
+	rc = machine_write(dst, msg);
+	if (rc == -1)
+		return write_error;
+	return OD_FE_OK;
+}
+
+static inline int
+od_frontend_prepared(od_client_t *client)
+{
+	od_route_t *route = client->route;
+	return route->config->prepared_statements &&
+	       route->config->pool != OD_POOL_TYPE_SESSION;
+}
+
+static inline int
+od_frontend_prepare_write(machine_msg_t *msg, char type,
+                          char *prefix, int prefix_size,
+                          char *name, int name_len,
+                          char *suffix, int suffix_size)
+{
+	/* append message with the statement name replaced */
+	char header[sizeof(kiwi_header_t)];
+	char *pos = header;
+	kiwi_write8(&pos, type);
+	kiwi_write32(&pos, sizeof(uint32_t) + prefix_size + name_len +
+	                   suffix_size);
+	int rc;
+	rc = machine_msg_write(msg, header, sizeof(header));
+	if (rc == -1)
+		return -1;
+	rc = machine_msg_write(msg, prefix, prefix_size);
+	if (rc == -1)
+		return -1;
+	rc = machine_msg_write(msg, name, name_len);
+	if (rc == -1)
+		return -1;
+	return machine_msg_write(msg, suffix, suffix_size);
+}
+
+static inline void
+od_frontend_prepare_complete(char *reply, char type)
+{
+	/* ParseComplete or CloseComplete */
+	char *pos = reply;
+	if (type == KIWI_FE_PARSE)
+		kiwi_write8(&pos, KIWI_BE_PARSE_COMPLETE);
+	else
+		kiwi_write8(&pos, KIWI_BE_CLOSE_COMPLETE);
+	kiwi_write32(&pos, sizeof(uint32_t));
+}
+
+static inline od_frontend_rc_t
+od_frontend_prepare_push(od_client_t *client, char type, char action,
+                         od_prepare_t *server_stmt, od_prepare_t *stmt)
+{
+	od_server_t *server = client->server;
+	od_prepare_req_t *req;
+	req = od_prepare_queue_push(&server->prepare_queue, type, action);
+	if (req == NULL)
+		return OD_FE_ESERVER_CONFIGURE;
+	if (server_stmt) {
+		req->hash = server_stmt->hash;
+		req->probe = server_stmt->probe;
+	}
+	req->stmt = stmt;
+	return OD_FE_OK;
+}
+
+static inline od_frontend_rc_t
+od_frontend_prepare_fake(od_client_t *client, char type, od_prepare_t *stmt,
+                         machine_msg_t *reply)
+{
+	od_server_t *server = client->server;
+
+	/* reply is generated by odyssey, it is written to client
+	 * right after replies to all preceding requests */
+	int rc;
+	if (! od_prepare_queue_empty(&server->prepare_queue)) {
+		od_prepare_req_t *req;
+		req = od_prepare_queue_push(&server->prepare_queue, type,
+		                            OD_PREPARE_FAKE);
+		if (req == NULL) {
+			if (reply)
+				machine_msg_free(reply);
+			return OD_FE_ESERVER_CONFIGURE;
+		}
+		req->stmt = stmt;
+		req->reply = reply;
+		return OD_FE_OK;
+	}
+
+	if (reply) {
+		rc = machine_write_direct(client->io, machine_msg_get_data(reply),
+		                          machine_msg_get_size(reply));
+		machine_msg_free(reply);
+		if (rc == -1)
+			return OD_FE_ECLIENT_WRITE;
+		return OD_FE_OK;
+	}
+	char complete[sizeof(kiwi_header_t)];
+	od_frontend_prepare_complete(complete, type);
+	rc = machine_write_direct(client->io, complete, sizeof(complete));
+	if (rc == -1)
+		return OD_FE_ECLIENT_WRITE;
+	return OD_FE_OK;
+}
+
+static inline od_prepare_t*
+od_frontend_prepare_add(od_server_t *server, uint64_t hash,
+                        char *body, int body_size)
+{
+	/* statements with the same hash get distinct server names */
+	int probe;
+	probe = od_prepare_map_probe_next(&server->prepare_map, hash);
+	od_prepare_t *stmt;
+	stmt = od_prepare_map_add(&server->prepare_map, hash, hash, NULL, 0,
+	                          body, body_size);
+	if (stmt == NULL)
+		return NULL;
+	stmt->probe = probe;
+	return stmt;
+}
+
+static inline int
+od_frontend_prepare_evict(od_client_t *client, machine_msg_t *msg)
+{
+	od_instance_t *instance = client->global->instance;
+	od_route_t *route = client->route;
+	od_server_t *server = client->server;
+
+	/* close least recently used statements on server, only
+	 * between transactions and without pending requests, so
+	 * no portal depends on them */
+	int max = route->config->prepared_statements_max;
+	if (max == 0 || server->prepare_map.count < max)
+		return 0;
+	if (server->is_transaction ||
+	    ! od_prepare_queue_empty(&server->prepare_queue))
+		return 0;
+	char target = 'S';
+	while (server->prepare_map.count >= max) {
+		od_prepare_t *stmt;
+		stmt = od_prepare_map_lru(&server->prepare_map);
+		char server_name[OD_PREPARE_NAME_LEN];
+		int server_name_len;
+		server_name_len = od_prepare_name(stmt, server_name);
+		int rc;
+		rc = od_frontend_prepare_write(msg, KIWI_FE_CLOSE, &target, 1,
+		                               server_name, server_name_len,
+		                               NULL, 0);
+		if (rc == -1)
+			return -1;
+		if (! od_prepare_queue_push(&server->prepare_queue, KIWI_FE_CLOSE,
+		                            OD_PREPARE_SKIP))
+			return -1;
+		od_debug(&instance->logger, "main", client, server,
+		         "prepare %s: evict", server_name);
+		od_prepare_map_delete(&server->prepare_map, stmt);
+	}
+	return 0;
+}
+
+static inline od_frontend_rc_t
+od_frontend_prepare_parse(od_client_t *client, char *data, uint32_t size,
+                          od_frontend_relay_t *relay)
+{
+	od_instance_t *instance = client->global->instance;
+	od_server_t *server = client->server;
+
+	char *name;
+	uint32_t name_len;
+	char *query;
+	uint32_t query_len;
+	int rc;
+	rc = kiwi_be_read_parse(data, size, &name, &name_len, &query, &query_len);
+	if (rc == -1) {
+		od_error(&instance->logger, "main", client, server,
+		         "failed to parse %s",
+		         kiwi_fe_type_to_string(KIWI_FE_PARSE));
+		return OD_FE_ECLIENT_READ;
+	}
+
+	/* unnamed statement is not shared */
+	if (name_len == 1)
+		return od_frontend_prepare_push(client, KIWI_FE_PARSE,
+		                                OD_PREPARE_FORWARD, NULL, NULL);
+
+	/* statement is identified by query and parameter types */
+	char *body = name + name_len;
+	int body_size = (data + size) - body;
+	uint64_t hash;
+	hash = od_hash(body, body_size);
+
+	/* client statement name is taken, report error as server
+	 * does and keep the existing statement */
+	uint64_t key;
+	key = od_hash(name, name_len);
+	od_prepare_t *stmt;
+	stmt = od_prepare_map_find(&client->prepare_map, key, name, name_len);
+	if (stmt) {
+		od_debug(&instance->logger, "main", client, server,
+		         "prepare %.*s: already exists", name_len, name);
+		machine_msg_t *msg;
+		msg = od_frontend_errorf(client, KIWI_DUPLICATE_PSTATEMENT,
+		                         "prepared statement \"%.*s\" already exists",
+		                         name_len - 1, name);
+		if (msg == NULL)
+			return OD_FE_ESERVER_CONFIGURE;
+		client->prepare_skip = 1;
+		*relay = OD_FE_RELAY_SKIP;
+		return od_frontend_prepare_fake(client, KIWI_FE_PARSE, NULL, msg);
+	}
+
+	/* remember client statement to prepare it on any
+	 * server attached later, it is dropped if server
+	 * fails or skips the Parse */
+	stmt = od_prepare_map_add(&client->prepare_map, key, hash, name, name_len,
+	                          body, body_size);
+	if (stmt == NULL)
+		return OD_FE_ESERVER_CONFIGURE;
+
+	/* already prepared on server */
+	od_prepare_t *server_stmt;
+	server_stmt = od_prepare_map_match(&server->prepare_map, hash,
+	                                   body, body_size);
+	if (server_stmt) {
+		od_debug(&instance->logger, "main", client, server,
+		         "prepare %.*s: cached", name_len, name);
+		od_prepare_map_touch(&server->prepare_map, server_stmt);
+		*relay = OD_FE_RELAY_SKIP;
+		return od_frontend_prepare_fake(client, KIWI_FE_PARSE, stmt, NULL);
+	}
+
+	machine_msg_t *msg;
+	msg = machine_msg_create(0);
+	if (msg == NULL)
+		return OD_FE_ESERVER_CONFIGURE;
+	rc = od_frontend_prepare_evict(client, msg);
+	if (rc == -1)
+		goto error;
+
+	/* prepare statement using server name */
+	server_stmt = od_frontend_prepare_add(server, hash, body, body_size);
+	if (server_stmt == NULL)
+		goto error;
+	char server_name[OD_PREPARE_NAME_LEN];
+	int server_name_len;
+	server_name_len = od_prepare_name(server_stmt, server_name);
+	rc = od_frontend_prepare_write(msg, KIWI_FE_PARSE, NULL, 0,
+	                               server_name, server_name_len,
+	                               body, body_size);
+	if (rc == -1)
+		goto error;
+	client->relay_msg = msg;
+	return od_frontend_prepare_push(client, KIWI_FE_PARSE,
+	                                OD_PREPARE_FORWARD, server_stmt, stmt);
+error:
+	machine_msg_free(msg);
+	return OD_FE_ESERVER_CONFIGURE;
+}
+
+static inline od_frontend_rc_t
+od_frontend_prepare_use(od_client_t *client, char *data, uint32_t size,
+                        char *name, uint32_t name_len)
+{
+	od_instance_t *instance = client->global->instance;
+	od_server_t *server = client->server;
+	char type = *data;
+
+	/* unknown statement is reported by server */
+	od_prepare_t *stmt = NULL;
+	if (name_len > 1)
+		stmt = od_prepare_map_find(&client->prepare_map,
+		                           od_hash(name, name_len),
+		                           name, name_len);
+	if (stmt == NULL)
+		return od_frontend_prepare_push(client, type, OD_PREPARE_FORWARD,
+		                                NULL, NULL);
+
+	machine_msg_t *msg;
+	msg = machine_msg_create(0);
+	if (msg == NULL)
+		return OD_FE_ESERVER_CONFIGURE;
+
+	/* statement was prepared by client on other server,
+	 * prepare it on the attached one and skip the reply */
+	od_frontend_rc_t fe_rc;
+	int rc;
+	od_prepare_t *server_stmt;
+	char server_name[OD_PREPARE_NAME_LEN];
+	int server_name_len;
+	server_stmt = od_prepare_map_match(&server->prepare_map, stmt->hash,
+	                                   stmt->body, stmt->body_size);
+	if (server_stmt) {
+		od_prepare_map_touch(&server->prepare_map, server_stmt);
+		server_name_len = od_prepare_name(server_stmt, server_name);
+	} else {
+		od_debug(&instance->logger, "main", client, server,
+		         "prepare %.*s: deploy", name_len, name);
+		rc = od_frontend_prepare_evict(client, msg);
+		if (rc == -1)
+			goto error;
+		server_stmt = od_frontend_prepare_add(server, stmt->hash,
+		                                      stmt->body, stmt->body_size);
+		if (server_stmt == NULL)
+			goto error;
+		server_name_len = od_prepare_name(server_stmt, server_name);
+		rc = od_frontend_prepare_write(msg, KIWI_FE_PARSE, NULL, 0,
+		                               server_name, server_name_len,
+		                               stmt->body, stmt->body_size);
+		if (rc == -1)
+			goto error;
+		fe_rc = od_frontend_prepare_push(client, KIWI_FE_PARSE,
+		                                 OD_PREPARE_SKIP, server_stmt, NULL);
+		if (fe_rc != OD_FE_OK)
+			goto error;
+	}
+
+	char *prefix = data + sizeof(kiwi_header_t);
+	char *suffix = name + name_len;
+	rc = od_frontend_prepare_write(msg, type,
+	                               prefix, name - prefix,
+	                               server_name, server_name_len,
+	                               suffix, (data + size) - suffix);
+	if (rc == -1)
+		goto error;
+	fe_rc = od_frontend_prepare_push(client, type, OD_PREPARE_FORWARD,
+	                                 NULL, NULL);
+	if (fe_rc != OD_FE_OK)
+		goto error;
+	client->relay_msg = msg;
+	return OD_FE_OK;
+error:
+	machine_msg_free(msg);
+	return OD_FE_ESERVER_CONFIGURE;
+}
+
+static inline od_frontend_rc_t
+od_frontend_prepare_request(od_client_t *client, char *data, uint32_t size,
+                            od_frontend_relay_t *relay)
+{
+	od_instance_t *instance = client->global->instance;
+	od_server_t *server = client->server;
+
+	/* track extended protocol requests sent to server and
+	 * replace client statement names with server ones */
+	char type = *data;
+	char *name;
+	uint32_t name_len;
+	char *portal;
+	uint32_t portal_len;
+	char target;
+	od_prepare_t *stmt;
+	int rc;
+	switch (type) {
+	case KIWI_FE_PARSE:
+		return od_frontend_prepare_parse(client, data, size, relay);
+
+	case KIWI_FE_BIND:
+		rc = kiwi_be_read_bind(data, size, &portal, &portal_len,
+		                       &name, &name_len);
+		if (rc == -1)
+			break;
+		return od_frontend_prepare_use(client, data, size, name, name_len);
+
+	case KIWI_FE_DESCRIBE:
+		rc = kiwi_be_read_describe(data, size, &target, &name, &name_len);
+		if (rc == -1)
+			break;
+		if (target != 'S')
+			return od_frontend_prepare_push(client, type,
+			                                OD_PREPARE_FORWARD, NULL, NULL);
+		return od_frontend_prepare_use(client, data, size, name, name_len);
+
+	case KIWI_FE_CLOSE:
+		rc = kiwi_be_read_close(data, size, &target, &name, &name_len);
+		if (rc == -1)
+			break;
+		if (target != 'S' || name_len == 1)
+			return od_frontend_prepare_push(client, type,
+			                                OD_PREPARE_FORWARD, NULL, NULL);
+		/* server statement stays in the cache */
+		stmt = od_prepare_map_find(&client->prepare_map,
+		                           od_hash(name, name_len),
+		                           name, name_len);
+		if (stmt) {
+			od_prepare_queue_forget(&server->prepare_queue, stmt);
+			od_prepare_map_delete(&client->prepare_map, stmt);
+		}
+		*relay = OD_FE_RELAY_SKIP;
+		return od_frontend_prepare_fake(client, KIWI_FE_CLOSE, NULL, NULL);
+
+	case KIWI_FE_EXECUTE:
+	case KIWI_FE_SYNC:
+	case KIWI_FE_QUERY:
+	case KIWI_FE_FUNCTION_CALL:
+		return od_frontend_prepare_push(client, type, OD_PREPARE_FORWARD,
+		                                NULL, NULL);
+
+	default:
+		return OD_FE_OK;
+	}
+
+	od_error(&instance->logger, "main", client, server,
+	         "failed to parse %s", kiwi_fe_type_to_string(type));
+	return OD_FE_ECLIENT_READ;
+}
+
+static inline void
+od_frontend_prepare_discard(od_client_t *client)
+{
+	od_server_t *server = client->server;
+
+	/* server skips extended protocol messages after error
+	 * until Sync, statements of the failed and skipped Parse
+	 * requests are not prepared */
+	od_prepare_queue_t *queue = &server->prepare_queue;
+	od_prepare_req_t *req;
+	while ((req = od_prepare_queue_head(queue)))
+	{
+		if (req->type == KIWI_FE_SYNC)
+			break;
+		if (req->type == KIWI_FE_PARSE && req->hash) {
+			od_prepare_t *stmt;
+			stmt = od_prepare_map_probe(&server->prepare_map, req->hash,
+			                            req->probe);
+			if (stmt)
+				od_prepare_map_delete(&server->prepare_map, stmt);
+		}
+		if (req->stmt)
+			od_prepare_map_delete(&client->prepare_map, req->stmt);
+		od_prepare_queue_pop(queue);
+	}
+}
+
+static inline od_frontend_rc_t
+od_frontend_prepare_reply(od_client_t *client, char *data, uint32_t size,
+                          od_frontend_relay_t *relay)
+{
+	od_server_t *server = client->server;
+	od_prepare_queue_t *queue = &server->prepare_queue;
+	od_prepare_req_t *req;
+	req = od_prepare_queue_head(queue);
+	if (req == NULL)
+		return OD_FE_OK;
+
+	/* match reply with the request it completes */
+	int complete = 0;
+	switch (*data) {
+	case KIWI_BE_PARSE_COMPLETE:
+		complete = req->type == KIWI_FE_PARSE;
+		break;
+	case KIWI_BE_BIND_COMPLETE:
+		complete = req->type == KIWI_FE_BIND;
+		break;
+	case KIWI_BE_CLOSE_COMPLETE:
+		complete = req->type == KIWI_FE_CLOSE;
+		break;
+	case KIWI_BE_ROW_DESCRIPTION:
+	case KIWI_BE_NO_DATA:
+		complete = req->type == KIWI_FE_DESCRIBE;
+		break;
+	case KIWI_BE_COMMAND_COMPLETE:
+	case KIWI_BE_EMPTY_QUERY_RESPONSE:
+	case KIWI_BE_PORTAL_SUSPENDED:
+		complete = req->type == KIWI_FE_EXECUTE;
+		break;
+	case KIWI_BE_READY_FOR_QUERY:
+		complete = req->type == KIWI_FE_SYNC ||
+		           req->type == KIWI_FE_QUERY ||
+		           req->type == KIWI_FE_FUNCTION_CALL;
+		break;
+	case KIWI_BE_ERROR_RESPONSE:
+		if (req->type == KIWI_FE_SYNC ||
+		    req->type == KIWI_FE_QUERY ||
+		    req->type == KIWI_FE_FUNCTION_CALL)
+			break;
+		od_frontend_prepare_discard(client);
+		return OD_FE_OK;
+	}
+	if (! complete)
+		return OD_FE_OK;
+
+	int forward = req->action == OD_PREPARE_FORWARD;
+	od_prepare_queue_pop(queue);
+
+	/* write replies generated for the following requests */
+	req = od_prepare_queue_head(queue);
+	if (req == NULL || req->action != OD_PREPARE_FAKE) {
+		if (! forward)
+			*relay = OD_FE_RELAY_SKIP;
+		return OD_FE_OK;
+	}
+	machine_msg_t *msg;
+	msg = machine_msg_create(0);
+	if (msg == NULL)
+		return OD_FE_ESERVER_CONFIGURE;
+	int rc;
+	if (forward) {
+		rc = machine_msg_write(msg, data, size);
+		if (rc == -1)
+			goto error;
+	}
+	while (req && req->action == OD_PREPARE_FAKE) {
+		if (req->reply) {
+			rc = machine_msg_write(msg, machine_msg_get_data(req->reply),
+			                       machine_msg_get_size(req->reply));
+		} else {
+			char reply[sizeof(kiwi_header_t)];
+			od_frontend_prepare_complete(reply, req->type);
+			rc = machine_msg_write(msg, reply, sizeof(reply));
+		}
+		if (rc == -1)
+			goto error;
+		od_prepare_queue_pop(queue);
+		req = od_prepare_queue_head(queue);
+	}
+	client->relay_msg = msg;
+	return OD_FE_OK;
+error:
+	machine_msg_free(msg);
+	return OD_FE_ESERVER_CONFIGURE;
+}
+
+static inline int
+od_frontend_tracked(od_client_t *client)
+{
+	/* track session state left by client on the server,
+	 * session pooling always discards on detach; dirty server
+	 * is still tracked while pooler statements are kept */
+	od_route_t *route = client->route;
+	od_server_t *server = client->server;
+	return route->config->pool != OD_POOL_TYPE_SESSION &&
+	       (! server->is_dirty || server->prepare_map.count > 0 ||
+	        client->prepare_map.count > 0);
+}
+
+static inline od_frontend_rc_t
+od_frontend_remote_client_handle(od_client_t *client,
+                                 char *data, uint32_t size,
+                                 od_frontend_relay_t *relay)
+{
+	od_instance_t *instance = client->global->instance;
+	od_server_t *server = client->server;
+
+	*relay = OD_FE_RELAY_FORWARD;
+
+	kiwi_fe_type_t type;
+	type = *data;
+
+	od_debug(&instance->logger, "main", client, server, "%s",
+	         kiwi_fe_type_to_string(type));
+
+	/* messages following rejected Parse are discarded
+	 * until Sync, as server does after error */
+	if (client->prepare_skip) {
+		if (type != KIWI_FE_SYNC && type != KIWI_FE_TERMINATE) {
+			*relay = OD_FE_RELAY_SKIP;
+			return OD_FE_OK;
+		}
+		client->prepare_skip = 0;
+	}
+
+	int rc;
+	switch (type) {
+	case KIWI_FE_TERMINATE:
+		return OD_FE_TERMINATE;
+
+	case KIWI_FE_COPY_DONE:
+	case KIWI_FE_COPY_FAIL:
+		server->is_copy = 0;
+		break;
+
+	case KIWI_FE_QUERY:
+	{
+		int track = od_frontend_tracked(client);
+		if (! instance->config.log_query && ! track)
+			break;
+		uint32_t query_len;
+		char *query;
+		rc = kiwi_be_read_query(data, size, &query, &query_len);
+		if (rc == -1) {
+			/* streamed message, content is unknown */
+			if (track)
+				server->is_dirty = 1;
+			if (instance->config.log_query)
+				od_error(&instance->logger, "main", client, server,
+				         "failed to parse %s",
+				         kiwi_fe_type_to_string(type));
+			break;
+		}
+		if (instance->config.log_query)
+			od_log(&instance->logger, "main", client, server,
+			       "%.*s", query_len, query);
+		if (track)
+			od_deploy_track(client, query, query_len);
+		break;
+	}
+
+	case KIWI_FE_PARSE:
+	{
+		int track = od_frontend_tracked(client);
+		if (! instance->config.log_query && ! track)
+			break;
+		uint32_t name_len;
+		char *name;
+		uint32_t query_len;
+		char *query;
+		rc = kiwi_be_read_parse(data, size, &name, &name_len,
+		                        &query, &query_len);
+		if (rc == -1) {
+			if (track)
+				server->is_dirty = 1;
+			if (instance->config.log_query)
+				od_error(&instance->logger, "main", client, server,
+				         "failed to parse %s",
+				         kiwi_fe_type_to_string(type));
+			break;
+		}
+		if (track) {
+			/* named statements are session state, unless
+			 * shared by the pooler */
+			if (name_len > 1 && ! od_frontend_prepared(client))
+				server->is_dirty = 1;
+			else
+				od_deploy_track(client, query, query_len);
+		}
+		if (instance->config.log_query) {
+			if (! name_len) {
+				name = "<unnamed>";
+				name_len = 9;
+			}
+			od_log(&instance->logger, "main", client, server,
+			       "prepare %.*s: %.*s", name_len, name, query_len, query);
+		}
+		break;
+	}
+
+	case KIWI_FE_FUNCTION_CALL:
+		if (od_frontend_tracked(client))
+			server->is_dirty = 1;
+		break;
+
+	default:
+		break;
+	}
+
+	/* shared prepared statements in transaction pooling */
+	if (od_frontend_prepared(client)) {
+		od_frontend_rc_t fe_rc;
+		fe_rc = od_frontend_prepare_request(client, data, size, relay);
+		if (fe_rc != OD_FE_OK)
+			return fe_rc;
+	}
+
+	if (type == KIWI_FE_QUERY ||
+	    type == KIWI_FE_FUNCTION_CALL ||
+	    type == KIWI_FE_SYNC)
+	{
+		/* update server sync state */
+		od_server_sync_request(server, 1);
+	}
+
+	/* update server stats */
+	od_stat_query_start(&server->stats_state);
+
+	return OD_FE_OK;
+}
+
+static int
+od_frontend_remote_client_streamable(od_client_t *client, int type)
+{
+	od_instance_t *instance = client->global->instance;
+	/* discarded messages are not streamed */
+	if (client->prepare_skip)
+		return 0;
+	/* statement names are replaced in place */
+	if (od_frontend_prepared(client)) {
+		switch (type) {
+		case KIWI_FE_PARSE:
+		case KIWI_FE_BIND:
+		case KIWI_FE_DESCRIBE:
+		case KIWI_FE_CLOSE:
+			return 0;
+		}
+	}
+	if (type == KIWI_FE_QUERY || type == KIWI_FE_PARSE)
+		return !instance->config.log_query;
+	return 1;
+}
+
+static inline int
+od_frontend_word(char *word, int word_len, char *name)
+{
+	return word_len == (int)strlen(name) &&
+	       strncasecmp(word, name, word_len) == 0;
+}
+
+static inline int
+od_frontend_token(char **pos, char *end, char **token)
+{
+	/* next keyword after spaces and comments, zero length if
+	 * the next token is not a keyword */
+	char *p = *pos;
+	while (p < end) {
+		if (isspace((unsigned char)*p)) {
+			p++;
+			continue;
+		}
+		if (*p == '-' && p + 1 < end && p[1] == '-') {
+			while (p < end && *p != '\n')
+				p++;
+			continue;
+		}
+		if (*p == '/' && p + 1 < end && p[1] == '*') {
+			/* block comments nest */
+			int depth = 0;
+			while (p < end) {
+				if (*p == '/' && p + 1 < end && p[1] == '*') {
+					depth++;
+					p += 2;
+					continue;
+				}
+				if (*p == '*' && p + 1 < end && p[1] == '/') {
+					p += 2;
+					if (--depth == 0)
+						break;
+					continue;
+				}
+				p++;
+			}
+			continue;
+		}
+		break;
+	}
+	*token = p;
+	if (p < end && isalpha((unsigned char)*p)) {
+		while (p < end && (isalnum((unsigned char)*p) || *p == '_'))
+			p++;
+	}
+	*pos = p;
+	return p - *token;
+}
+
+static inline int
+od_frontend_begin(char **pos, char *end)
+{
+	/* BEGIN [WORK | TRANSACTION] or START TRANSACTION */
+	char *word;
+	int word_len;
+	word_len = od_frontend_token(pos, end, &word);
+	if (od_frontend_word(word, word_len, "start")) {
+		word_len = od_frontend_token(pos, end, &word);
+		return od_frontend_word(word, word_len, "transaction");
+	}
+	if (! od_frontend_word(word, word_len, "begin"))
+		return 0;
+	char *next = *pos;
+	word_len = od_frontend_token(&next, end, &word);
+	if (od_frontend_word(word, word_len, "work") ||
+	    od_frontend_word(word, word_len, "transaction"))
+		*pos = next;
+	return 1;
+}
+
+static inline int
+od_frontend_read_only_query(char *query, int query_len)
+{
+	/* match BEGIN or START TRANSACTION with READ ONLY
+	 * transaction mode, stop at any other token */
+	char *pos = query;
+	char *end = query + query_len;
+	if (! od_frontend_begin(&pos, end))
+		return 0;
+	for (;;) {
+		char *word;
+		int word_len;
+		word_len = od_frontend_token(&pos, end, &word);
+		if (word_len == 0) {
+			if (pos < end && *pos == ',') {
+				pos++;
+				continue;
+			}
+			return 0;
+		}
+		if (od_frontend_word(word, word_len, "read")) {
+			word_len = od_frontend_token(&pos, end, &word);
+			if (od_frontend_word(word, word_len, "only"))
+				return 1;
+			if (! od_frontend_word(word, word_len, "write"))
+				return 0;
+			continue;
+		}
+		if (od_frontend_word(word, word_len, "isolation")) {
+			/* ISOLATION LEVEL { SERIALIZABLE | REPEATABLE READ |
+			 * READ COMMITTED | READ UNCOMMITTED } */
+			word_len = od_frontend_token(&pos, end, &word);
+			if (! od_frontend_word(word, word_len, "level"))
+				return 0;
+			word_len = od_frontend_token(&pos, end, &word);
+			if (od_frontend_word(word, word_len, "serializable"))
+				continue;
+			if (od_frontend_word(word, word_len, "repeatable")) {
+				word_len = od_frontend_token(&pos, end, &word);
+				if (! od_frontend_word(word, word_len, "read"))
+					return 0;
+				continue;
+			}
+			if (! od_frontend_word(word, word_len, "read"))
+				return 0;
+			word_len = od_frontend_token(&pos, end, &word);
+			if (! od_frontend_word(word, word_len, "committed") &&
+			    ! od_frontend_word(word, word_len, "uncommitted"))
+				return 0;
+			continue;
+		}
+		if (od_frontend_word(word, word_len, "not"))
+			word_len = od_frontend_token(&pos, end, &word);
+		if (! od_frontend_word(word, word_len, "deferrable"))
+			return 0;
+	}
+}
+
+static inline int
+od_frontend_transaction_query(char *query, int query_len)
+{
+	/* match single BEGIN or START TRANSACTION statement,
+	 * statements following it might end the transaction */
+	char *pos = query;
+	char *end = query + query_len;
+	if (! od_frontend_begin(&pos, end))
+		return 0;
+	char *word;
+	int word_len;
+	for (;;) {
+		word_len = od_frontend_token(&pos, end, &word);
+		if (word_len > 0)
+			continue;
+		if (pos == end)
+			return 1;
+		if (*pos == ';' || *pos == '\0')
+			break;
+		if (*pos != ',')
+			return 0;
+		pos++;
+	}
+	/* only empty statements and comments may follow */
+	for (;;) {
+		word_len = od_frontend_token(&pos, end, &word);
+		if (word_len > 0)
+			return 0;
+		if (pos == end)
+			return 1;
+		if (*pos != ';' && *pos != '\0')
+			return 0;
+		pos++;
+	}
+}
+
+static inline int
+od_frontend_peek_query(od_client_t *client, int *type,
+                       char **query, uint32_t *query_len)
+{
+	/* look at the next client message without reading it,
+	 * encrypted readahead cannot be inspected */
+	if (client->tls)
+		return 0;
+	int rc;
+	rc = machine_read_wait(client->io, sizeof(kiwi_header_t), UINT32_MAX);
+	if (rc == -1)
+		return -1;
+	rc = od_frontend_relay_wait(client, client->io);
+	if (rc != 1)
+		return rc;
+	char *data;
+	machine_read_peek(client->io, &data);
+	uint32_t size;
+	size = kiwi_read_size(data, sizeof(kiwi_header_t)) + sizeof(kiwi_header_t);
+
+	*type = *data;
+	switch (*type) {
+	case KIWI_FE_QUERY:
+		rc = kiwi_be_read_query(data, size, query, query_len);
+		break;
+	case KIWI_FE_PARSE:
+	{
+		char *name;
+		uint32_t name_len;
+		rc = kiwi_be_read_parse(data, size, &name, &name_len,
+		                        query, query_len);
+		break;
 	}
+	default:
+		return 0;
+	}
+	if (rc == -1)
+		return 0;
+	return 1;
+}
 
-	/* write paremeter status messages */
-	fe_rc = od_frontend_setup_params(client, &route_params);
-	kiwi_params_free(&route_params);
-	if (fe_rc != OD_FE_OK)
-		return fe_rc;
-	fe_rc = od_frontend_setup_params(client, &client->startup.params);
-	if (fe_rc != OD_FE_OK)
-		return fe_rc;
+static inline int
+od_frontend_read_only_begin(od_client_t *client)
+{
+	int type;
+	char *query;
+	uint32_t query_len;
+	int rc;
+	rc = od_frontend_peek_query(client, &type, &query, &query_len);
+	if (rc != 1)
+		return rc;
+	return od_frontend_read_only_query(query, query_len);
+}
 
-	/* copy client startup parameters */
-	rc = kiwi_params_copy(&client->params, &client->startup.params);
+static inline od_frontend_rc_t
+od_frontend_transaction_reject(od_client_t *client, int *rejected)
+{
+	/* Reject transaction block in statement pooling before
+	 * the server is attached.
+	 *
+	 * Only a simple query received while no request is in flight
+	 * can be answered without the server, transactions started
+	 * otherwise are detected by the server transaction status
+	 * and the client is disconnected.
+	*/
+	*rejected = 0;
+	int type;
+	char *query;
+	uint32_t query_len;
+	int rc;
+	rc = od_frontend_peek_query(client, &type, &query, &query_len);
 	if (rc == -1)
-		return OD_FE_ECLIENT_CONFIGURE;
+		return OD_FE_ECLIENT_READ;
+	if (rc == 0 || type != KIWI_FE_QUERY)
+		return OD_FE_OK;
+	if (! od_frontend_transaction_query(query, query_len))
+		return OD_FE_OK;
 
-	/* write key data message */
+	/* drop the query, reply with error and keep the client */
+	od_instance_t *instance = client->global->instance;
+	od_log(&instance->logger, "main", client, NULL,
+	       "transaction block rejected in statement pooling mode");
 	machine_msg_t *msg;
-	msg = kiwi_be_write_backend_key_data(client->key.key_pid, client->key.key);
+	msg = od_read(client->io, UINT32_MAX);
 	if (msg == NULL)
-		return OD_FE_ECLIENT_CONFIGURE;
+		return OD_FE_ECLIENT_READ;
+	machine_msg_free(msg);
+	msg = od_frontend_errorf(client, KIWI_FEATURE_NOT_SUPPORTED,
+	                         "transaction blocks are not allowed in statement pooling mode");
+	if (msg == NULL)
+		return OD_FE_ECLIENT_WRITE;
 	rc = machine_write(client->io, msg);
 	if (rc == -1)
 		return OD_FE_ECLIENT_WRITE;
-
-	/* write ready message */
 	msg = kiwi_be_write_ready('I');
 	if (msg == NULL)
-		return OD_FE_ECLIENT_CONFIGURE;
+		return OD_FE_ECLIENT_WRITE;
 	rc = machine_write(client->io, msg);
 	if (rc == -1)
 		return OD_FE_ECLIENT_WRITE;
-
-	/* done */
 	rc = machine_flush(client->io, UINT32_MAX);
 	if (rc == -1)
 		return OD_FE_ECLIENT_WRITE;
+	*rejected = 1;
+	return OD_FE_OK;
+}
 
-	client->time_setup = machine_time();
-
-	if (instance->config.log_session) {
-		od_log(&instance->logger, "setup", client, NULL,
-		       "login time: %d microseconds",
-		       (client->time_setup - client->time_accept));
+static inline od_frontend_rc_t
+od_frontend_route_select(od_client_t *client)
+{
+	/* Choose primary or replica route before attach.
+	 *
+	 * Read-only sessions always use the replica route. Other
+	 * clients use it for explicit read-only transactions,
+	 * unless the server is kept for the whole session.
+	*/
+	od_route_t *route = client->route;
+	od_route_t *primary = route->is_replica ? route->primary : route;
+	if (primary->replica == NULL)
+		return OD_FE_OK;
+	int read_only = client->is_read_only;
+	if (! read_only && route->config->pool != OD_POOL_TYPE_SESSION) {
+		read_only = od_frontend_read_only_begin(client);
+		if (read_only == -1)
+			return OD_FE_ECLIENT_READ;
 	}
-
+	od_route_t *target = read_only ? primary->replica : primary;
+	if (target != route)
+		od_router_switch(client, target);
 	return OD_FE_OK;
 }
 
 static inline od_frontend_rc_t
 od_frontend_remote_client(od_client_t *client)
 {
-	od_instance_t *instance = client->global->instance;
-	od_route_t *route = client->route;
 	od_server_t *server = client->server;
 
 	/* get server connection from the route pool, write configuration
 	 * requests before client request */
 	if (server == NULL) {
 		od_frontend_rc_t fe_rc;
+		od_route_t *route = client->route;
+		if (route->config->pool == OD_POOL_TYPE_STATEMENT) {
+			int rejected;
+			fe_rc = od_frontend_transaction_reject(client, &rejected);
+			if (fe_rc != OD_FE_OK || rejected)
+				return fe_rc;
+		}
+		fe_rc = od_frontend_route_select(client);
+		if (fe_rc != OD_FE_OK)
+			return fe_rc;
 		fe_rc = od_frontend_attach_and_deploy(client, "main");
 		if (fe_rc != OD_FE_OK)
 			return fe_rc;
 		server = client->server;
 	}
+	od_route_t *route = client->route;
 
-	/* read incoming packet */
-	machine_msg_t *msg;
-	msg = od_read(client->io, UINT32_MAX);
-	if (msg == NULL)
-		return OD_FE_ECLIENT_READ;
-
-	/* update client recv stat */
-	od_stat_recv_client(&route->stats, machine_msg_get_size(msg));
-
-	kiwi_fe_type_t type;
-	type = *(char*)machine_msg_get_data(msg);
-
-	od_debug(&instance->logger, "main", client, server, "%s",
-	         kiwi_fe_type_to_string(type));
-
-	int rc;
-	switch (type) {
-	case KIWI_FE_TERMINATE:
-		machine_msg_free(msg);
-		return OD_FE_TERMINATE;
-
-	case KIWI_FE_COPY_DONE:
-	case KIWI_FE_COPY_FAIL:
-		server->is_copy = 0;
-		break;
-
-	case KIWI_FE_QUERY:
-		if (instance->config.log_query)
-		{
-			uint32_t query_len;
-			char *query;
-			rc = kiwi_be_read_query(msg, &query, &query_len);
-			if (rc == -1) {
-				od_error(&instance->logger, "main", client, server,
-				         "failed to parse %s",
-				         kiwi_fe_type_to_string(type));
-				break;
-			}
-			od_log(&instance->logger, "main", client, server,
-			       "%.*s", query_len, query);
-		}
-		break;
-
-	case KIWI_FE_PARSE:
-		if (instance->config.log_query)
-		{
-			uint32_t name_len;
-			char *name;
-			uint32_t query_len;
-			char *query;
-			rc = kiwi_be_read_parse(msg, &name, &name_len, &query, &query_len);
-			if (rc == -1) {
-				od_error(&instance->logger, "main", client, server,
-				         "failed to parse %s",
-				         kiwi_fe_type_to_string(type));
-				break;
-			}
-			if (! name_len) {
-				name = "<unnamed>";
-				name_len = 9;
-			}
-			od_log(&instance->logger, "main", client, server,
-			       "prepare %.*s: %.*s", name_len, name, query_len, query);
-		}
-		break;
-
-	default:
-		break;
+	/* relay buffered client messages */
+	od_frontend_relay_t relay;
+	od_frontend_rc_t fe_rc;
+	int relayed;
+	fe_rc = od_frontend_relay(client, client->io, server->io,
+	                          od_frontend_remote_client_handle,
+	                          OD_FE_ESERVER_WRITE,
+	                          &relay, &relayed);
+	if (relayed == 0 && fe_rc == OD_FE_OK) {
+		int rc;
+		rc = od_frontend_relay_wait(client, client->io);
+		if (rc == -1)
+			return OD_FE_ECLIENT_READ;
+		if (rc == 1)
+			fe_rc = od_frontend_relay(client, client->io, server->io,
+			                          od_frontend_remote_client_handle,
+			                          OD_FE_ESERVER_WRITE,
+			                          &relay, &relayed);
 	}
-
-	/* forward message to server */
-	rc = machine_write(server->io, msg);
-	if (rc == -1)
-		return OD_FE_ESERVER_WRITE;
-
-	if (type == KIWI_FE_QUERY ||
-	    type == KIWI_FE_FUNCTION_CALL ||
-	    type == KIWI_FE_SYNC)
-	{
-		/* update server sync state */
-		od_server_sync_request(server, 1);
+	if (relayed == 0 && fe_rc == OD_FE_OK) {
+		/* read and forward next message */
+		fe_rc = od_frontend_relay_msg(client, client->io, server->io,
+		                              od_frontend_remote_client_handle,
+		                              od_frontend_remote_client_streamable,
+		                              OD_FE_ECLIENT_READ,
+		                              OD_FE_ESERVER_WRITE,
+		                              &relay, &relayed);
 	}
 
-	/* update server stats */
-	od_stat_query_start(&server->stats_state);
+	/* update client recv stat */
+	if (relayed > 0)
+		od_stat_recv_client(&route->stats, relayed);
 
-	return OD_FE_OK;
+	return fe_rc;
+}
+
+static inline int
+od_frontend_synchronized(od_server_t *server)
+{
+	/* all requests are replied, including extended protocol
+	 * requests sent after the last Sync */
+	return od_server_synchronized(server) &&
+	       od_prepare_queue_empty(&server->prepare_queue);
 }
 
 static inline od_frontend_rc_t
-od_frontend_remote_server(od_client_t *client)
+od_frontend_remote_server_handle(od_client_t *client,
+                                 char *data, uint32_t size,
+                                 od_frontend_relay_t *relay)
 {
 	od_instance_t *instance = client->global->instance;
 	od_route_t *route = client->route;
 	od_server_t *server = client->server;
 
-	/* read incoming packet */
-	machine_msg_t *msg;
-	msg = od_read(server->io, UINT32_MAX);
-	if (msg == NULL)
-		return OD_FE_ESERVER_READ;
-
-	/* update server recv stats */
-	od_stat_recv_server(&route->stats, machine_msg_get_size(msg));
+	*relay = OD_FE_RELAY_FORWARD;
 
 	kiwi_be_type_t type;
-	type = *(char*)machine_msg_get_data(msg);
+	type = *data;
 
 	od_debug(&instance->logger, "main", client, server, "%s",
 	         kiwi_be_type_to_string(type));
@@ -540,25 +1808,33 @@ od_frontend_remote_server(od_client_t *client)
 	/* discard replies during configuration deploy */
 	int rc;
 	if (server->deploy_sync > 0) {
-		rc = od_backend_deploy(server, "main-deploy", msg);
-		machine_msg_free(msg);
+		*relay = OD_FE_RELAY_SKIP;
+		rc = od_backend_deploy(server, "main-deploy", data, size);
 		if (rc == -1)
 			return OD_FE_ESERVER_CONFIGURE;
 		return OD_FE_OK;
 	}
 
+	/* match replies with the tracked requests */
+	if (od_frontend_prepared(client)) {
+		od_frontend_rc_t fe_rc;
+		fe_rc = od_frontend_prepare_reply(client, data, size, relay);
+		if (fe_rc != OD_FE_OK)
+			return fe_rc;
+	}
+
 	switch (type) {
 	case KIWI_BE_ERROR_RESPONSE:
-		od_backend_error(server, "main", msg);
+		od_backend_error(server, "main", data, size);
 		break;
 	case KIWI_BE_PARAMETER_STATUS: {
 		char *name;
 		uint32_t name_len;
 		char *value;
 		uint32_t value_len;
-		rc = kiwi_fe_read_parameter(msg, &name, &name_len, &value, &value_len);
+		rc = kiwi_fe_read_parameter(data, size, &name, &name_len,
+		                            &value, &value_len);
 		if (rc == -1) {
-			machine_msg_free(msg);
 			od_error(&instance->logger, "main", client, server,
 			         "failed to parse ParameterStatus message");
 			return OD_FE_ESERVER_READ;
@@ -567,14 +1843,16 @@ od_frontend_remote_server(od_client_t *client)
 		         "%.*s = %.*s",
 		         name_len, name, value_len, value);
 
-		/* update current client parameter state */
+		/* update current client and server parameter state */
 		kiwi_param_t *param;
 		param = kiwi_param_allocate(name, name_len, value, value_len);
-		if (param == NULL) {
-			machine_msg_free(msg);
+		if (param == NULL)
 			return OD_FE_ESERVER_CONFIGURE;
-		}
 		kiwi_params_replace(&client->params, param);
+		param = kiwi_param_allocate(name, name_len, value, value_len);
+		if (param == NULL)
+			return OD_FE_ESERVER_CONFIGURE;
+		kiwi_params_replace(&server->params, param);
 		break;
 	}
 
@@ -588,11 +1866,9 @@ od_frontend_remote_server(od_client_t *client)
 
 	case KIWI_BE_READY_FOR_QUERY:
 	{
-		rc = od_backend_ready(server, msg);
-		if (rc == -1) {
-			machine_msg_free(msg);
+		rc = od_backend_ready(server, data, size);
+		if (rc == -1)
 			return OD_FE_ESERVER_READ;
-		}
 
 		/* update server stats */
 		int64_t query_time = 0;
@@ -605,19 +1881,24 @@ od_frontend_remote_server(od_client_t *client)
 			          query_time);
 		}
 
-		/* handle transaction pooling */
-		if (route->config->pool == OD_POOL_TYPE_TRANSACTION) {
-			if (! server->is_transaction) {
-				/* cleanup server */
-				rc = od_reset(server);
-				if (rc == -1) {
-					machine_msg_free(msg);
-					return OD_FE_ESERVER_WRITE;
-				}
-				/* push server connection back to route pool */
-				od_router_detach(client);
-				server = NULL;
-			}
+		/* handle transaction and statement pooling, server is
+		 * returned to the route pool after the message is forwarded
+		 * and replies to all pipelined requests are received */
+		switch (route->config->pool) {
+		case OD_POOL_TYPE_SESSION:
+			break;
+		case OD_POOL_TYPE_TRANSACTION:
+			if (! server->is_transaction && od_frontend_synchronized(server))
+				*relay = OD_FE_RELAY_DETACH;
+			break;
+		case OD_POOL_TYPE_STATEMENT:
+			/* multi-statement transactions are not allowed */
+			if (server->is_transaction)
+				*relay = OD_FE_RELAY_REJECT;
+			else
+			if (od_frontend_synchronized(server))
+				*relay = OD_FE_RELAY_DETACH;
+			break;
 		}
 		break;
 	}
@@ -625,11 +1906,94 @@ od_frontend_remote_server(od_client_t *client)
 		break;
 	}
 
-	/* forward message to client */
-	rc = machine_write(client->io, msg);
+	return OD_FE_OK;
+}
+
+static int
+od_frontend_remote_server_streamable(od_client_t *client, int type)
+{
+	od_server_t *server = client->server;
+	if (server->deploy_sync > 0)
+		return 0;
+	/* replies are matched with requests and may be replaced */
+	if (od_frontend_prepared(client)) {
+		if (type != KIWI_BE_DATA_ROW && type != KIWI_BE_COPY_DATA)
+			return 0;
+	}
+	switch (type) {
+	case KIWI_BE_ERROR_RESPONSE:
+	case KIWI_BE_PARAMETER_STATUS:
+	case KIWI_BE_READY_FOR_QUERY:
+		return 0;
+	}
+	return 1;
+}
+
+static inline od_frontend_rc_t
+od_frontend_remote_server_detach(od_client_t *client, machine_pollset_t *pollset)
+{
+	od_server_t *server = client->server;
+
+	/* cleanup server */
+	int rc;
+	rc = od_reset(server);
 	if (rc == -1)
-		return OD_FE_ECLIENT_WRITE;
+		return OD_FE_ESERVER_WRITE;
+
+	/* stop polling server io before it can be reused by
+	 * another client */
+	machine_pollset_delete(pollset, server->io);
+
+	/* push server connection back to route pool */
+	od_router_detach(client);
+	return OD_FE_OK;
+}
 
+static inline od_frontend_rc_t
+od_frontend_remote_server(od_client_t *client, machine_pollset_t *pollset)
+{
+	od_route_t *route = client->route;
+	od_server_t *server = client->server;
+
+	/* relay buffered server replies */
+	od_frontend_relay_t relay;
+	od_frontend_rc_t fe_rc;
+	int relayed;
+	fe_rc = od_frontend_relay(client, server->io, client->io,
+	                          od_frontend_remote_server_handle,
+	                          OD_FE_ECLIENT_WRITE,
+	                          &relay, &relayed);
+	if (relayed == 0 && fe_rc == OD_FE_OK) {
+		int rc;
+		rc = od_frontend_relay_wait(client, server->io);
+		if (rc == -1)
+			return OD_FE_ESERVER_READ;
+		if (rc == 1)
+			fe_rc = od_frontend_relay(client, server->io, client->io,
+			                          od_frontend_remote_server_handle,
+			                          OD_FE_ECLIENT_WRITE,
+			                          &relay, &relayed);
+	}
+	if (relayed == 0 && fe_rc == OD_FE_OK) {
+		/* read and forward next message */
+		fe_rc = od_frontend_relay_msg(client, server->io, client->io,
+		                              od_frontend_remote_server_handle,
+		                              od_frontend_remote_server_streamable,
+		                              OD_FE_ESERVER_READ,
+		                              OD_FE_ECLIENT_WRITE,
+		                              &relay, &relayed);
+	}
+
+	/* update server recv stats */
+	if (relayed > 0)
+		od_stat_recv_server(&route->stats, relayed);
+
+	if (fe_rc != OD_FE_OK)
+		return fe_rc;
+	if (relay == OD_FE_RELAY_DETACH)
+		return od_frontend_remote_server_detach(client, pollset);
+	if (relay == OD_FE_RELAY_REJECT)
+		return OD_FE_ETRANSACTION_BLOCK;
 	return OD_FE_OK;
 }
 
@@ -643,20 +2007,26 @@ od_frontend_ctl(od_client_t *client)
 }
 
 static od_frontend_rc_t
-od_frontend_remote(od_client_t *client)
+od_frontend_remote_main(od_client_t *client, machine_pollset_t *pollset)
 {
 	machine_io_t *io_ready[3];
-	machine_io_t *io_set[3];
-	int           io_count = 2;
 	int           io_pos;
-	io_set[0] = client->io_notify;
-	io_set[1] = client->io;
-	io_set[2] = NULL;
-
 	for (;;)
 	{
+		/* stop reading server replies while client write
+		 * queue is above the high watermark */
+		if (client->server && machine_write_overflow(client->io)) {
+			int rc;
+			rc = od_frontend_drain(client, client->io);
+			if (rc == -1) {
+				if (client->ctl.op == OD_CLIENT_OP_KILL)
+					return OD_FE_KILL;
+				return OD_FE_ECLIENT_WRITE;
+			}
+		}
+
 		int ready;
-		ready = machine_read_poll(io_set, io_ready, io_count, UINT32_MAX);
+		ready = machine_pollset_wait(pollset, io_ready, 3, UINT32_MAX);
 
 		for (io_pos = 0; io_pos < ready; io_pos++)
 		{
@@ -669,22 +2039,26 @@ od_frontend_remote(od_client_t *client)
 				continue;
 			}
 			if (io == client->io) {
+				int attached = client->server != NULL;
 				fe_rc = od_frontend_remote_client(client);
 				if (fe_rc != OD_FE_OK)
 					return fe_rc;
-				assert(client->server != NULL);
-				io_count  = 3;
-				io_set[2] = client->server->io;
+				/* request answered without the server */
+				if (client->server == NULL)
+					continue;
+				if (! attached) {
+					int rc;
+					rc = machine_pollset_add(pollset, client->server->io);
+					if (rc == -1)
+						return OD_FE_ESERVER_READ;
+				}
 				continue;
 			}
-			fe_rc = od_frontend_remote_server(client);
+			fe_rc = od_frontend_remote_server(client, pollset);
 			if (fe_rc != OD_FE_OK)
 				return fe_rc;
-			if (client->server == NULL) {
-				io_count  = 2;
-				io_set[2] = NULL;
+			if (client->server == NULL)
 				break;
-			}
 		}
 	}
 
@@ -693,6 +2067,32 @@ od_frontend_remote(od_client_t *client)
 	return OD_FE_UNDEF;
 }
 
+static od_frontend_rc_t
+od_frontend_remote(od_client_t *client)
+{
+	/* client and notify ios stay registered for the whole
+	 * session, server io is added on attach and removed
+	 * on detach */
+	machine_pollset_t *pollset;
+	pollset = machine_pollset_create();
+	if (pollset == NULL)
+		return OD_FE_ECLIENT_READ;
+
+	od_frontend_rc_t fe_rc = OD_FE_ECLIENT_READ;
+	int rc;
+	rc = machine_pollset_add(pollset, client->io_notify);
+	if (rc == -1)
+		goto done;
+	rc = machine_pollset_add(pollset, client->io);
+	if (rc == -1)
+		goto done;
+
+	fe_rc = od_frontend_remote_main(client, pollset);
+done:
+	machine_pollset_free(pollset);
+	return fe_rc;
+}
+
 static od_frontend_rc_t
 od_frontend_local(od_client_t *client)
 {
@@ -877,6 +2277,23 @@ od_frontend_cleanup(od_client_t *client, char *context,
 		od_router_close_and_unroute(client);
 		break;
 
+	case OD_FE_ETRANSACTION_BLOCK:
+		/* transaction started in statement pooling mode,
+		 * close client connection and rollback server */
+		od_log(&instance->logger, context, client, server,
+		       "client disconnected (transaction block in statement pooling mode)");
+		od_frontend_error(client, KIWI_FEATURE_NOT_SUPPORTED,
+		                  "transaction blocks are not allowed in statement pooling mode");
+		rc = od_reset(server);
+		if (rc != 1) {
+			/* close backend connection */
+			od_router_close_and_unroute(client);
+			break;
+		}
+		/* push server to router server pool */
+		od_router_detach_and_unroute(client);
+		break;
+
 	case OD_FE_ESERVER_READ:
 	case OD_FE_ESERVER_WRITE:
 		/* close client connection and close server
@@ -914,6 +2331,7 @@ od_frontend(void *arg)
 	}
 
 	/* attach client io to worker machine event loop */
+	client->machine = machine_self();
 	int rc;
 	rc = machine_io_attach(client->io);
 	if (rc == -1) {
@@ -949,8 +2367,8 @@ od_frontend(void *arg)
 		od_router_cancel_init(&cancel);
 		rc = od_router_cancel(client, &cancel);
 		if (rc == 0) {
-			od_cancel(client->global, cancel.config, &cancel.key,
-			          &cancel.id);
+			od_cancel(client->global, cancel.config, cancel.endpoint,
+			          &cancel.key, &cancel.id);
 			od_router_cancel_free(&cancel);
 		}
 		od_frontend_close(client);
@@ -0,0 +1,23 @@
+#ifndef ODYSSEY_HASH_H
+#define ODYSSEY_HASH_H
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+*/
+
+static inline uint64_t
+od_hash(char *data, int size)
+{
+	/* FNV-1a */
+	uint64_t hash = 14695981039346656037ULL;
+	int i = 0;
+	for (; i < size; i++) {
+		hash ^= (uint8_t)data[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+#endif /* ODYSSEY_HASH_H */
@@ -11,6 +11,7 @@
 #include "sources/version.h"
 #include "sources/atomic.h"
 #include "sources/util.h"
+#include "sources/hash.h"
 #include "sources/error.h"
 #include "sources/list.h"
 #include "sources/pid.h"
@@ -24,14 +25,17 @@
 #include "sources/global.h"
 #include "sources/stat.h"
 #include "sources/io.h"
+#include "sources/prepare.h"
 #include "sources/server.h"
 #include "sources/server_pool.h"
 #include "sources/client.h"
 #include "sources/client_pool.h"
+#include "sources/storage.h"
 #include "sources/route_id.h"
 #include "sources/route.h"
 #include "sources/route_pool.h"
 #include "sources/instance.h"
+#include "sources/dns.h"
 #include "sources/router_cancel.h"
 #include "sources/router.h"
 #include "sources/cron.h"
@@ -0,0 +1,243 @@
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+*/
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#include <machinarium.h>
+#include <kiwi.h>
+#include <odyssey.h>
+
+void
+od_prepare_map_init(od_prepare_map_t *map)
+{
+	map->buckets = NULL;
+	map->buckets_count = 0;
+	map->count = 0;
+	od_list_init(&map->lru);
+}
+
+void
+od_prepare_map_free(od_prepare_map_t *map)
+{
+	int i = 0;
+	for (; i < map->buckets_count; i++) {
+		od_list_t *j, *n;
+		od_list_foreach_safe(&map->buckets[i], j, n) {
+			od_prepare_t *stmt;
+			stmt = od_container_of(j, od_prepare_t, link);
+			free(stmt);
+		}
+	}
+	free(map->buckets);
+	od_prepare_map_init(map);
+}
+
+static inline int
+od_prepare_map_resize(od_prepare_map_t *map, int buckets_count)
+{
+	od_list_t *buckets;
+	buckets = malloc(sizeof(od_list_t) * buckets_count);
+	if (buckets == NULL)
+		return -1;
+	int i = 0;
+	for (; i < buckets_count; i++)
+		od_list_init(&buckets[i]);
+
+	/* move statements to the new buckets */
+	for (i = 0; i < map->buckets_count; i++) {
+		od_list_t *j, *n;
+		od_list_foreach_safe(&map->buckets[i], j, n) {
+			od_prepare_t *stmt;
+			stmt = od_container_of(j, od_prepare_t, link);
+			od_list_append(&buckets[stmt->key & (buckets_count - 1)],
+			               &stmt->link);
+		}
+	}
+	free(map->buckets);
+	map->buckets = buckets;
+	map->buckets_count = buckets_count;
+	return 0;
+}
+
+od_prepare_t*
+od_prepare_map_find(od_prepare_map_t *map, uint64_t key,
+                    char *name, int name_len)
+{
+	if (map->count == 0)
+		return NULL;
+	od_list_t *bucket;
+	bucket = &map->buckets[key & (map->buckets_count - 1)];
+	od_list_t *i;
+	od_list_foreach(bucket, i) {
+		od_prepare_t *stmt;
+		stmt = od_container_of(i, od_prepare_t, link);
+		if (stmt->key != key)
+			continue;
+		if (name == NULL)
+			return stmt;
+		if (stmt->name_len == name_len &&
+		    memcmp(stmt->name, name, name_len) == 0)
+			return stmt;
+	}
+	return NULL;
+}
+
+od_prepare_t*
+od_prepare_map_match(od_prepare_map_t *map, uint64_t key,
+                     char *body, int body_size)
+{
+	/* statements with the same hash are told apart by body */
+	if (map->count == 0)
+		return NULL;
+	od_list_t *bucket;
+	bucket = &map->buckets[key & (map->buckets_count - 1)];
+	od_list_t *i;
+	od_list_foreach(bucket, i) {
+		od_prepare_t *stmt;
+		stmt = od_container_of(i, od_prepare_t, link);
+		if (stmt->key == key && stmt->body_size == body_size &&
+		    memcmp(stmt->body, body, body_size) == 0)
+			return stmt;
+	}
+	return NULL;
+}
+
+od_prepare_t*
+od_prepare_map_probe(od_prepare_map_t *map, uint64_t key, int probe)
+{
+	if (map->count == 0)
+		return NULL;
+	od_list_t *bucket;
+	bucket = &map->buckets[key & (map->buckets_count - 1)];
+	od_list_t *i;
+	od_list_foreach(bucket, i) {
+		od_prepare_t *stmt;
+		stmt = od_container_of(i, od_prepare_t, link);
+		if (stmt->key == key && stmt->probe == probe)
+			return stmt;
+	}
+	return NULL;
+}
+
+int
+od_prepare_map_probe_next(od_prepare_map_t *map, uint64_t key)
+{
+	/* lowest probe number not used by statements
+	 * with the same hash */
+	int probe = 0;
+	while (od_prepare_map_probe(map, key, probe))
+		probe++;
+	return probe;
+}
+
+od_prepare_t*
+od_prepare_map_add(od_prepare_map_t *map, uint64_t key, uint64_t hash,
+                   char *name, int name_len,
+                   char *body, int body_size)
+{
+	if (map->count >= map->buckets_count) {
+		int buckets_count = map->buckets_count * 2;
+		if (buckets_count == 0)
+			buckets_count = 16;
+		int rc;
+		rc = od_prepare_map_resize(map, buckets_count);
+		if (rc == -1)
+			return NULL;
+	}
+
+	od_prepare_t *stmt;
+	stmt = malloc(sizeof(*stmt) + name_len + body_size);
+	if (stmt == NULL)
+		return NULL;
+	stmt->key = key;
+	stmt->hash = hash;
+	stmt->probe = 0;
+	stmt->name = NULL;
+	stmt->name_len = name_len;
+	stmt->body = NULL;
+	stmt->body_size = body_size;
+	if (name_len > 0) {
+		stmt->name = (char*)stmt + sizeof(*stmt);
+		memcpy(stmt->name, name, name_len);
+	}
+	if (body_size > 0) {
+		stmt->body = (char*)stmt + sizeof(*stmt) + name_len;
+		memcpy(stmt->body, body, body_size);
+	}
+	od_list_init(&stmt->link);
+	od_list_append(&map->buckets[key & (map->buckets_count - 1)],
+	               &stmt->link);
+	od_list_init(&stmt->link_lru);
+	od_list_append(&map->lru, &stmt->link_lru);
+	map->count++;
+	return stmt;
+}
+
+void
+od_prepare_map_delete(od_prepare_map_t *map, od_prepare_t *stmt)
+{
+	od_list_unlink(&stmt->link);
+	od_list_unlink(&stmt->link_lru);
+	map->count--;
+	free(stmt);
+}
+
+void
+od_prepare_queue_init(od_prepare_queue_t *queue)
+{
+	queue->reqs = NULL;
+	queue->size = 0;
+	queue->head = 0;
+	queue->count = 0;
+}
+
+void
+od_prepare_queue_free(od_prepare_queue_t *queue)
+{
+	while (queue->count > 0)
+		od_prepare_queue_pop(queue);
+	free(queue->reqs);
+	od_prepare_queue_init(queue);
+}
+
+od_prepare_req_t*
+od_prepare_queue_push(od_prepare_queue_t *queue, char type, char action)
+{
+	if (queue->count == queue->size) {
+		int size = queue->size * 2;
+		if (size == 0)
+			size = 16;
+		od_prepare_req_t *reqs;
+		reqs = malloc(sizeof(od_prepare_req_t) * size);
+		if (reqs == NULL)
+			return NULL;
+		/* unwrap ring buffer */
+		int i = 0;
+		for (; i < queue->count; i++)
+			reqs[i] = queue->reqs[(queue->head + i) % queue->size];
+		free(queue->reqs);
+		queue->reqs = reqs;
+		queue->size = size;
+		queue->head = 0;
+	}
+	od_prepare_req_t *req;
+	req = &queue->reqs[(queue->head + queue->count) % queue->size];
+	req->type = type;
+	req->action = action;
+	req->hash = 0;
+	req->probe = 0;
+	req->stmt = NULL;
+	req->reply = NULL;
+	queue->count++;
+	return req;
+}
@@ -0,0 +1,172 @@
+#ifndef ODYSSEY_PREPARE_H
+#define ODYSSEY_PREPARE_H
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+*/
+
+typedef struct od_prepare       od_prepare_t;
+typedef struct od_prepare_map   od_prepare_map_t;
+typedef struct od_prepare_req   od_prepare_req_t;
+typedef struct od_prepare_queue od_prepare_queue_t;
+
+/* Prepared statement.
+ *
+ * Client map is keyed by the client statement name and keeps
+ * Parse message body (query and parameter types) to be able to
+ * prepare the statement on any server.
+ *
+ * Server map is keyed by the statement hash and keeps the body
+ * to tell apart statements with the same hash. Statements are
+ * prepared on server using names derived from the hash and the
+ * probe number, which is unique among the colliding ones.
+ *
+ * Statements are kept in the least recently used order, to
+ * bound the number of statements prepared on server.
+*/
+
+struct od_prepare
+{
+	uint64_t   key;
+	uint64_t   hash;
+	int        probe;
+	char      *name;
+	int        name_len;
+	char      *body;
+	int        body_size;
+	od_list_t  link;
+	od_list_t  link_lru;
+};
+
+struct od_prepare_map
+{
+	od_list_t *buckets;
+	int        buckets_count;
+	int        count;
+	od_list_t  lru;
+};
+
+/* Extended protocol request sent to server and waiting
+ * for its reply. */
+
+typedef enum
+{
+	OD_PREPARE_FORWARD,
+	OD_PREPARE_SKIP,
+	OD_PREPARE_FAKE
+} od_prepare_action_t;
+
+struct od_prepare_req
+{
+	char     type;
+	char     action;
+	uint64_t hash;
+	int      probe;
+	/* client statement created by Parse */
+	od_prepare_t  *stmt;
+	/* reply generated by odyssey, instead of ParseComplete
+	 * or CloseComplete */
+	machine_msg_t *reply;
+};
+
+struct od_prepare_queue
+{
+	od_prepare_req_t *reqs;
+	int               size;
+	int               head;
+	int               count;
+};
+
+#define OD_PREPARE_NAME_LEN 36
+
+void od_prepare_map_init(od_prepare_map_t*);
+void od_prepare_map_free(od_prepare_map_t*);
+void od_prepare_map_delete(od_prepare_map_t*, od_prepare_t*);
+
+static inline void
+od_prepare_map_touch(od_prepare_map_t *map, od_prepare_t *stmt)
+{
+	od_list_unlink(&stmt->link_lru);
+	od_list_append(&map->lru, &stmt->link_lru);
+}
+
+static inline od_prepare_t*
+od_prepare_map_lru(od_prepare_map_t *map)
+{
+	if (map->count == 0)
+		return NULL;
+	return od_container_of(map->lru.next, od_prepare_t, link_lru);
+}
+
+od_prepare_t*
+od_prepare_map_find(od_prepare_map_t*, uint64_t, char*, int);
+
+od_prepare_t*
+od_prepare_map_match(od_prepare_map_t*, uint64_t, char*, int);
+
+od_prepare_t*
+od_prepare_map_probe(od_prepare_map_t*, uint64_t, int);
+
+int od_prepare_map_probe_next(od_prepare_map_t*, uint64_t);
+
+od_prepare_t*
+od_prepare_map_add(od_prepare_map_t*, uint64_t, uint64_t,
+                   char*, int, char*, int);
+
+void od_prepare_queue_init(od_prepare_queue_t*);
+void od_prepare_queue_free(od_prepare_queue_t*);
+od_prepare_req_t*
+od_prepare_queue_push(od_prepare_queue_t*, char, char);
+
+static inline int
+od_prepare_queue_empty(od_prepare_queue_t *queue)
+{
+	return queue->count == 0;
+}
+
+static inline od_prepare_req_t*
+od_prepare_queue_head(od_prepare_queue_t *queue)
+{
+	if (queue->count == 0)
+		return NULL;
+	return &queue->reqs[queue->head];
+}
+
+static inline void
+od_prepare_queue_pop(od_prepare_queue_t *queue)
+{
+	assert(queue->count > 0);
+	od_prepare_req_t *req = &queue->reqs[queue->head];
+	if (req->reply)
+		machine_msg_free(req->reply);
+	queue->head = (queue->head + 1) % queue->size;
+	queue->count--;
+}
+
+static inline void
+od_prepare_queue_forget(od_prepare_queue_t *queue, od_prepare_t *stmt)
+{
+	/* client statement is dropped, NULL drops all of them */
+	int i = 0;
+	for (; i < queue->count; i++) {
+		od_prepare_req_t *req;
+		req = &queue->reqs[(queue->head + i) % queue->size];
+		if (stmt == NULL || req->stmt == stmt)
+			req->stmt = NULL;
+	}
+}
+
+static inline int
+od_prepare_name(od_prepare_t *stmt, char *name)
+{
+	/* zero-terminated server statement name */
+	if (stmt->probe == 0)
+		return od_snprintf(name, OD_PREPARE_NAME_LEN, "odyssey_%016" PRIx64,
+		                   stmt->hash) + 1;
+	return od_snprintf(name, OD_PREPARE_NAME_LEN, "odyssey_%016" PRIx64 "_%d",
+	                   stmt->hash, stmt->probe) + 1;
+}
+
+#endif /* ODYSSEY_PREPARE_H */
@@ -24,6 +24,11 @@ od_reset(od_server_t *server)
 	od_instance_t *instance = server->global->instance;
 	od_route_t *route = server->route;
 
+	/* client queries are not tracked in session pooling,
+	 * discard session state on next deploy */
+	if (route->config->pool == OD_POOL_TYPE_SESSION)
+		server->is_dirty = 1;
+
 	/* server left in copy mode */
 	if (server->is_copy) {
 		od_log(&instance->logger, "reset", server->client, server,
@@ -31,6 +36,14 @@ od_reset(od_server_t *server)
 		goto drop;
 	}
 
+	/* replies to the tracked extended protocol requests are
+	 * not received, server statements state is unknown */
+	if (! od_prepare_queue_empty(&server->prepare_queue)) {
+		od_log(&instance->logger, "reset", server->client, server,
+		       "prepared statements are not synchronized, closing");
+		goto drop;
+	}
+
 	/* support route rollback off */
 	if (! route->config->pool_rollback) {
 		if (server->is_transaction) {
@@ -96,8 +109,8 @@ od_reset(od_server_t *server)
 			       wait_try_cancel);
 			wait_try_cancel++;
 			rc = od_cancel(server->global,
-			               route->config->storage, &server->key,
-			               &server->id);
+			               od_route_storage(route), server->endpoint,
+			               &server->key, &server->id);
 			if (rc == -1)
 				goto error;
 			continue;
@@ -11,28 +11,46 @@ typedef struct od_route od_route_t;
 
 struct od_route
 {
+	pthread_mutex_t    lock;
 	od_config_route_t *config;
+	od_storage_t      *storage;
 	od_route_id_t      id;
+	uint64_t           id_hash;
 	od_stat_t          stats;
 	od_stat_t          stats_prev;
 	int                stats_mark;
+	int                pool_limit;
+	uint64_t           pool_limit_latency;
+	od_stat_t          pool_limit_stats;
 	od_server_pool_t   server_pool;
 	od_client_pool_t   client_pool;
 	kiwi_params_lock_t params;
+	int                is_replica;
+	od_route_t        *primary;
+	od_route_t        *replica;
 	od_list_t          link;
 };
 
 static inline void
 od_route_init(od_route_t *route)
 {
+	pthread_mutex_init(&route->lock, NULL);
 	route->config = NULL;
+	route->storage = NULL;
 	od_route_id_init(&route->id);
+	route->id_hash = 0;
 	od_server_pool_init(&route->server_pool);
 	od_client_pool_init(&route->client_pool);
 	route->stats_mark = 0;
 	od_stat_init(&route->stats);
 	od_stat_init(&route->stats_prev);
+	route->pool_limit = 0;
+	route->pool_limit_latency = 0;
+	od_stat_init(&route->pool_limit_stats);
 	kiwi_params_lock_init(&route->params);
+	route->is_replica = 0;
+	route->primary = NULL;
+	route->replica = NULL;
 	od_list_init(&route->link);
 }
 
@@ -52,9 +70,41 @@ od_route_free(od_route_t *route)
 	od_route_id_free(&route->id);
 	od_server_pool_free(&route->server_pool);
 	kiwi_params_lock_free(&route->params);
+	pthread_mutex_destroy(&route->lock);
 	free(route);
 }
 
+static inline void
+od_route_lock(od_route_t *route)
+{
+	pthread_mutex_lock(&route->lock);
+}
+
+static inline void
+od_route_unlock(od_route_t *route)
+{
+	pthread_mutex_unlock(&route->lock);
+}
+
+static inline int
+od_route_pool_size(od_route_t *route)
+{
+	/* current pool size limit, adjusted by cron
+	 * for adaptive pools, zero means no limit */
+	if (route->config->pool_adaptive)
+		return route->pool_limit;
+	return route->config->pool_size;
+}
+
+static inline od_config_storage_t*
+od_route_storage(od_route_t *route)
+{
+	/* replica route shares config with its primary route */
+	if (route->is_replica)
+		return route->config->storage_replica;
+	return route->config->storage;
+}
+
 static inline int
 od_route_is_dynamic(od_route_t *route)
 {
@@ -73,12 +123,14 @@ od_route_kill_client(od_client_t *client, void *arg)
 static inline void
 od_route_kill_client_pool(od_route_t *route)
 {
+	od_route_lock(route);
 	od_client_pool_foreach(&route->client_pool, OD_CLIENT_ACTIVE,
 	                       od_route_kill_client, NULL);
 	od_client_pool_foreach(&route->client_pool, OD_CLIENT_PENDING,
 	                       od_route_kill_client, NULL);
 	od_client_pool_foreach(&route->client_pool, OD_CLIENT_QUEUE,
 	                       od_route_kill_client, NULL);
+	od_route_unlock(route);
 }
 
 #endif /* ODYSSEY_ROUTE_H */
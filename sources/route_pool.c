@@ -18,11 +18,175 @@
 #include <kiwi.h>
 #include <odyssey.h>
 
+/* marks deleted index slot */
+static char od_route_index_deleted;
+
+#define OD_ROUTE_INDEX_DELETED ((od_route_t*)&od_route_index_deleted)
+
+/* number of previous index slots moved on each
+ * route pool operation during resize */
+#define OD_ROUTE_INDEX_STEP 64
+
+static inline void
+od_route_index_init(od_route_index_t *index)
+{
+	index->slots = NULL;
+	index->size  = 0;
+	index->count = 0;
+	index->used  = 0;
+}
+
+static inline void
+od_route_index_free(od_route_index_t *index)
+{
+	free(index->slots);
+	od_route_index_init(index);
+}
+
+static inline uint64_t
+od_route_index_hash(od_route_id_t *id, od_config_route_t *config)
+{
+	uint64_t hash;
+	hash  = od_hash(id->database, id->database_len);
+	hash ^= od_hash(id->user, id->user_len) * 1099511628211ULL;
+	hash ^= (uintptr_t)config;
+	/* mix high bits into the slot number */
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+static inline od_route_t*
+od_route_index_find(od_route_index_t *index, uint64_t hash,
+                    od_route_id_t *id, od_config_route_t *config)
+{
+	if (index->count == 0)
+		return NULL;
+	int mask = index->size - 1;
+	int pos = hash & mask;
+	for (;;) {
+		od_route_t *route = index->slots[pos];
+		if (route == NULL)
+			return NULL;
+		if (route != OD_ROUTE_INDEX_DELETED &&
+		    route->id_hash == hash &&
+		    route->config == config &&
+		    od_route_id_compare(&route->id, id))
+			return route;
+		pos = (pos + 1) & mask;
+	}
+}
+
+static inline void
+od_route_index_add(od_route_index_t *index, od_route_t *route)
+{
+	int mask = index->size - 1;
+	int pos = route->id_hash & mask;
+	while (index->slots[pos] != NULL &&
+	       index->slots[pos] != OD_ROUTE_INDEX_DELETED)
+		pos = (pos + 1) & mask;
+	if (index->slots[pos] == NULL)
+		index->used++;
+	index->slots[pos] = route;
+	index->count++;
+}
+
+static inline int
+od_route_index_delete(od_route_index_t *index, od_route_t *route)
+{
+	if (index->count == 0)
+		return 0;
+	int mask = index->size - 1;
+	int pos = route->id_hash & mask;
+	for (;;) {
+		if (index->slots[pos] == NULL)
+			return 0;
+		if (index->slots[pos] == route) {
+			index->slots[pos] = OD_ROUTE_INDEX_DELETED;
+			index->count--;
+			return 1;
+		}
+		pos = (pos + 1) & mask;
+	}
+}
+
+static inline void
+od_route_pool_index_move(od_route_pool_t *pool, int count)
+{
+	/* move routes from the previous index, moved slots
+	 * are marked deleted to keep probe sequences valid */
+	od_route_index_t *prev = &pool->index_prev;
+	if (prev->slots == NULL)
+		return;
+	while (count-- > 0 && pool->index_prev_pos < prev->size) {
+		od_route_t *route = prev->slots[pool->index_prev_pos];
+		if (route && route != OD_ROUTE_INDEX_DELETED) {
+			od_route_index_add(&pool->index, route);
+			prev->slots[pool->index_prev_pos] = OD_ROUTE_INDEX_DELETED;
+			prev->count--;
+		}
+		pool->index_prev_pos++;
+	}
+	if (pool->index_prev_pos == prev->size) {
+		assert(prev->count == 0);
+		od_route_index_free(prev);
+		pool->index_prev_pos = 0;
+	}
+}
+
+static inline int
+od_route_pool_index_reserve(od_route_pool_t *pool)
+{
+	/* keep room for routes which are not moved yet */
+	od_route_index_t *index = &pool->index;
+	od_route_index_t *prev = &pool->index_prev;
+	if ((index->used + prev->count + 1) * 4 <= index->size * 3)
+		return 0;
+
+	/* finish previous resize */
+	if (prev->slots)
+		od_route_pool_index_move(pool, prev->size);
+
+	/* start incremental resize, the new index is half full
+	 * when all routes are moved */
+	int size = 16;
+	while (size < (pool->count + 1) * 2)
+		size *= 2;
+	od_route_t **slots;
+	slots = calloc(size, sizeof(od_route_t*));
+	if (slots == NULL)
+		return -1;
+	*prev = *index;
+	index->slots = slots;
+	index->size  = size;
+	index->count = 0;
+	index->used  = 0;
+	pool->index_prev_pos = 0;
+	if (prev->count == 0)
+		od_route_index_free(prev);
+	return 0;
+}
+
+static inline void
+od_route_pool_index_delete(od_route_pool_t *pool, od_route_t *route)
+{
+	int rc;
+	rc = od_route_index_delete(&pool->index, route);
+	if (! rc)
+		rc = od_route_index_delete(&pool->index_prev, route);
+	assert(rc == 1);
+	(void)rc;
+}
+
 void
 od_route_pool_init(od_route_pool_t *pool)
 {
 	od_list_init(&pool->list);
 	pool->count = 0;
+	od_route_index_init(&pool->index);
+	od_route_index_init(&pool->index_prev);
+	pool->index_prev_pos = 0;
 }
 
 void
@@ -34,35 +198,75 @@ od_route_pool_free(od_route_pool_t *pool)
 		route = od_container_of(i, od_route_t, link);
 		od_route_free(route);
 	}
+	od_route_index_free(&pool->index);
+	od_route_index_free(&pool->index_prev);
+}
+
+static inline int
+od_route_pool_in_use(od_route_t *route)
+{
+	return od_server_pool_total(&route->server_pool) > 0 ||
+	       od_client_pool_total(&route->client_pool) > 0;
+}
+
+static inline void
+od_route_pool_free_route(od_route_pool_t *pool, od_route_t *route)
+{
+	od_config_route_unref(route->config);
+
+	assert(pool->count > 0);
+	pool->count--;
+	if (! route->is_replica)
+		od_route_pool_index_delete(pool, route);
+	od_list_unlink(&route->link);
+	od_route_free(route);
 }
 
 static inline void
 od_route_pool_gc_route(od_route_pool_t *pool, od_route_t *route)
 {
-	if (od_server_pool_total(&route->server_pool) > 0 ||
-	    od_client_pool_total(&route->client_pool) > 0)
+	/* pools are updated by workers directly, new clients
+	 * can be added only by the router.
+	 *
+	 * Clients are moved between primary and replica routes
+	 * with both routes locked, so they are checked together */
+	od_route_t *replica = route->replica;
+	od_route_lock(route);
+	if (replica)
+		od_route_lock(replica);
+	int in_use;
+	in_use = od_route_pool_in_use(route) ||
+	         (replica && od_route_pool_in_use(replica));
+	if (replica)
+		od_route_unlock(replica);
+	od_route_unlock(route);
+	if (in_use)
 		return;
 
 	/* gc dynamic or absolete routes */
 	if (!od_route_is_dynamic(route) && !route->config->obsolete)
 		return;
 
-	od_config_route_unref(route->config);
-
 	/* free route data */
-	assert(pool->count > 0);
-	pool->count--;
-	od_list_unlink(&route->link);
-	od_route_free(route);
+	if (replica)
+		od_route_pool_free_route(pool, replica);
+	od_route_pool_free_route(pool, route);
 }
 
 void
 od_route_pool_gc(od_route_pool_t *pool)
 {
+	od_route_pool_index_move(pool, OD_ROUTE_INDEX_STEP);
+
 	od_list_t *i, *n;
 	od_list_foreach_safe(&pool->list, i, n) {
 		od_route_t *route;
 		route = od_container_of(i, od_route_t, link);
+		/* replica route is freed with its primary route */
+		if (route->is_replica)
+			continue;
+		if (route->replica && n == &route->replica->link)
+			n = n->next;
 		od_route_pool_gc_route(pool, route);
 	}
 }
@@ -81,6 +285,43 @@ od_route_pool_new(od_route_pool_t *pool, od_config_route_t *config,
 		return NULL;
 	}
 	route->config = config;
+	route->id_hash = od_route_index_hash(id, config);
+	route->pool_limit = config->pool_size;
+
+	od_route_pool_index_move(pool, OD_ROUTE_INDEX_STEP);
+	rc = od_route_pool_index_reserve(pool);
+	if (rc == -1) {
+		od_route_free(route);
+		return NULL;
+	}
+	od_route_index_add(&pool->index, route);
+
+	od_list_append(&pool->list, &route->link);
+	pool->count++;
+	return route;
+}
+
+od_route_t*
+od_route_pool_new_replica(od_route_pool_t *pool, od_route_t *primary)
+{
+	/* replica route is reachable only through its primary
+	 * route, so it is not added to the index */
+	od_route_t *route = od_route_allocate();
+	if (route == NULL)
+		return NULL;
+	int rc;
+	rc = od_route_id_copy(&route->id, &primary->id);
+	if (rc == -1) {
+		od_route_free(route);
+		return NULL;
+	}
+	route->config = primary->config;
+	route->id_hash = primary->id_hash;
+	route->pool_limit = primary->config->pool_size;
+	route->is_replica = 1;
+	route->primary = primary;
+	primary->replica = route;
+
 	od_list_append(&pool->list, &route->link);
 	pool->count++;
 	return route;
@@ -91,14 +332,15 @@ od_route_pool_match(od_route_pool_t *pool,
                     od_route_id_t *key,
                     od_config_route_t *config)
 {
-	od_list_t *i;
-	od_list_foreach(&pool->list, i) {
-		od_route_t *route;
-		route = od_container_of(i, od_route_t, link);
-		if (route->config == config && od_route_id_compare(&route->id, key))
-			return route;
-	}
-	return NULL;
+	od_route_pool_index_move(pool, OD_ROUTE_INDEX_STEP);
+
+	uint64_t hash;
+	hash = od_route_index_hash(key, config);
+	od_route_t *route;
+	route = od_route_index_find(&pool->index, hash, key, config);
+	if (route)
+		return route;
+	return od_route_index_find(&pool->index_prev, hash, key, config);
 }
 
 int
@@ -125,7 +367,9 @@ od_route_pool_next(od_route_pool_t *pool, od_server_state_t state)
 	od_list_foreach_safe(&pool->list, i, n) {
 		route = od_container_of(i, od_route_t, link);
 		od_server_t *server;
+		od_route_lock(route);
 		server = od_server_pool_next(&route->server_pool, state);
+		od_route_unlock(route);
 		if (server)
 			return server;
 	}
@@ -142,8 +386,10 @@ od_route_pool_server_foreach(od_route_pool_t *pool, od_server_state_t state,
 	od_list_foreach_safe(&pool->list, i, n) {
 		route = od_container_of(i, od_route_t, link);
 		od_server_t *server;
+		od_route_lock(route);
 		server = od_server_pool_foreach(&route->server_pool, state,
 		                                callback, arg);
+		od_route_unlock(route);
 		if (server)
 			return server;
 	}
@@ -160,8 +406,10 @@ od_route_pool_client_foreach(od_route_pool_t *pool, od_client_state_t state,
 	od_list_foreach_safe(&pool->list, i, n) {
 		route = od_container_of(i, od_route_t, link);
 		od_client_t *client;
+		od_route_lock(route);
 		client = od_client_pool_foreach(&route->client_pool, state,
 		                                callback, arg);
+		od_route_unlock(route);
 		if (client)
 			return client;
 	}
@@ -22,10 +22,25 @@ typedef int (*od_route_pool_stat_database_cb_t)
               od_stat_t *total,
               od_stat_t *avg, void *arg);
 
+typedef struct od_route_index od_route_index_t;
+
+/* open addressing hash table with linear probing,
+ * deleted slots are marked and reused on insert */
+struct od_route_index
+{
+	od_route_t **slots;
+	int          size;
+	int          count;
+	int          used;
+};
+
 struct od_route_pool
 {
-	od_list_t list;
-	int count;
+	od_list_t        list;
+	int              count;
+	od_route_index_t index;
+	od_route_index_t index_prev;
+	int              index_prev_pos;
 };
 
 void od_route_pool_init(od_route_pool_t*);
@@ -36,6 +51,9 @@ od_route_t*
 od_route_pool_new(od_route_pool_t*, od_config_route_t*,
                   od_route_id_t*);
 
+od_route_t*
+od_route_pool_new_replica(od_route_pool_t*, od_route_t*);
+
 od_route_t*
 od_route_pool_match(od_route_pool_t*, od_route_id_t*, od_config_route_t*);
 
@@ -22,32 +22,33 @@ typedef struct
 {
 	od_router_status_t  status;
 	od_client_t        *client;
-	machine_channel_t  *response;
-	od_router_cancel_t *cancel;
+	machine_reply_t    *response;
 } od_msg_router_t;
 
-static od_route_t*
-od_forward(od_router_t *router, kiwi_be_startup_t *startup)
+static od_storage_t*
+od_router_storage_match(od_router_t *router, od_config_storage_t *config)
 {
-	od_instance_t *instance = router->global->instance;
-
-	assert(startup->database != NULL);
-	assert(startup->user != NULL);
-
-	/* match latest version of route config */
-	od_config_route_t *config;
-	config = od_config_route_forward(&instance->config,
-	                                 kiwi_param_value(startup->database),
-	                                 kiwi_param_value(startup->user));
-	if (config == NULL)
+	/* storages are shared by name between routes and
+	 * config versions */
+	od_storage_t *storage;
+	od_list_t *i;
+	od_list_foreach(&router->storages, i) {
+		storage = od_container_of(i, od_storage_t, link);
+		if (strcmp(storage->name, config->name) == 0)
+			return storage;
+	}
+	storage = od_storage_allocate(config->name);
+	if (storage == NULL)
 		return NULL;
+	od_list_append(&router->storages, &storage->link);
+	return storage;
+}
 
-	od_route_id_t id = {
-		.database     = kiwi_param_value(startup->database),
-		.user         = kiwi_param_value(startup->user),
-		.database_len = startup->database->value_len,
-		.user_len     = startup->user->value_len
-	};
+static od_route_t*
+od_router_match(od_router_t *router, od_config_route_t *config,
+                od_route_id_t id)
+{
+	od_instance_t *instance = router->global->instance;
 
 	/* force settings required by route */
 	if (config->storage_db) {
@@ -64,24 +65,216 @@ od_forward(od_router_t *router, kiwi_be_startup_t *startup)
 	route = od_route_pool_match(&router->route_pool, &id, config);
 	if (route)
 		return route;
+	od_storage_t *storage;
+	storage = od_router_storage_match(router, config->storage);
+	if (storage == NULL) {
+		od_error(&instance->logger, "router", NULL, NULL,
+		         "failed to allocate storage");
+		return NULL;
+	}
 	route = od_route_pool_new(&router->route_pool, config, &id);
 	if (route == NULL) {
 		od_error(&instance->logger, "router", NULL, NULL,
 		         "failed to allocate route");
 		return NULL;
 	}
+	/* latest route config sets the storage limit */
+	storage->max_connections = config->storage->max_connections;
+	route->storage = storage;
+	od_config_route_ref(config);
+
+	/* read-only transactions are served by a separate
+	 * route with its own server pool, they stay on the
+	 * primary route if it cannot be created */
+	if (config->storage_replica == NULL)
+		return route;
+	storage = od_router_storage_match(router, config->storage_replica);
+	od_route_t *replica = NULL;
+	if (storage)
+		replica = od_route_pool_new_replica(&router->route_pool, route);
+	if (replica == NULL) {
+		od_error(&instance->logger, "router", NULL, NULL,
+		         "failed to allocate replica route");
+		return route;
+	}
+	storage->max_connections = config->storage_replica->max_connections;
+	replica->storage = storage;
 	od_config_route_ref(config);
 	return route;
 }
 
+static od_route_t*
+od_forward(od_router_t *router, kiwi_be_startup_t *startup)
+{
+	od_instance_t *instance = router->global->instance;
+
+	assert(startup->database != NULL);
+	assert(startup->user != NULL);
+
+	/* match latest version of route config */
+	od_config_route_t *config;
+	config = od_config_route_forward(&instance->config,
+	                                 kiwi_param_value(startup->database),
+	                                 kiwi_param_value(startup->user));
+	if (config == NULL)
+		return NULL;
+
+	od_route_id_t id = {
+		.database     = kiwi_param_value(startup->database),
+		.user         = kiwi_param_value(startup->user),
+		.database_len = startup->database->value_len,
+		.user_len     = startup->user->value_len
+	};
+	return od_router_match(router, config, id);
+}
+
+od_route_t*
+od_router_route_config(od_router_t *router, od_config_route_t *config)
+{
+	/* match or create route of a config route with explicit
+	 * database and user names, without a client */
+	assert(! config->db_is_default);
+	assert(! config->user_is_default);
+	od_route_id_t id = {
+		.database     = config->db_name,
+		.user         = config->user_name,
+		.database_len = config->db_name_len + 1,
+		.user_len     = config->user_name_len + 1
+	};
+	return od_router_match(router, config, id);
+}
+
 static inline void
-od_router_attacher(void *arg)
+od_router_affinity(od_route_t *route, od_pool_policy_t policy,
+                   od_server_t *server, od_client_t *client)
 {
-	machine_msg_t *msg;
-	msg = arg;
+	int hit;
+	switch (policy) {
+	case OD_POOL_POLICY_CLIENT:
+		hit = od_id_mgr_cmp(&server->last_client_id, &client->id);
+		break;
+	case OD_POOL_POLICY_WORKER:
+		hit = server->machine == client->machine;
+		break;
+	default:
+		return;
+	}
+	if (hit)
+		od_atomic_u64_inc(&route->stats.count_affinity_hit);
+	else
+		od_atomic_u64_inc(&route->stats.count_affinity_miss);
+}
+
+static inline od_server_t*
+od_router_next_idle(od_route_t *route, od_client_t *client)
+{
+	od_pool_policy_t policy = route->config->pool_policy;
+	od_server_t *server;
+	server = od_server_pool_next_idle(&route->server_pool, policy,
+	                                  &client->id, client->machine);
+	if (server)
+		od_router_affinity(route, policy, server, client);
+	return server;
+}
+
+static inline void
+od_router_attach_server(od_route_t *route, od_client_t *client,
+                        od_server_t *server)
+{
+	od_server_pool_set(&route->server_pool, server, OD_SERVER_ACTIVE);
+	od_client_pool_set(&route->client_pool, client, OD_CLIENT_ACTIVE);
+	client->server = server;
+	server->client = client;
+	server->idle_time = 0;
+	/* assign client session key */
+	server->key_client = client->key;
+	if (server->is_preconnected) {
+		server->is_preconnected = 0;
+		od_atomic_u64_inc(&route->stats.count_preconnect_hit);
+	}
+	od_router_t *router = client->global->router;
+	od_cancel_index_add(&router->cancel_index, server);
+}
+
+static inline void
+od_router_detach_server(od_route_t *route, od_client_t *client)
+{
+	od_server_t *server = client->server;
+	od_router_t *router = client->global->router;
+	od_cancel_index_delete(&router->cancel_index, server);
+	client->server = NULL;
+	server->client = NULL;
+	server->last_client_id = client->id;
+
+	/* close servers above the adaptive pool size limit
+	 * on return, they are swept by cron */
+	od_server_pool_t *pool = &route->server_pool;
+	od_server_state_t state = OD_SERVER_IDLE;
+	if (route->config->pool_adaptive &&
+	    od_server_pool_total(pool) - pool->count_expire > route->pool_limit)
+		state = OD_SERVER_EXPIRE;
+	od_server_pool_set(pool, server, state);
+}
+
+static inline int
+od_router_route_is_full(od_route_t *route)
+{
+	/* check pool_size limit, zero means no limit */
+	int pool_size = od_route_pool_size(route);
+	return pool_size > 0 &&
+	       od_server_pool_total(&route->server_pool) >= pool_size;
+}
+
+od_server_t*
+od_router_server_new(od_router_t *router, od_route_t *route)
+{
+	od_instance_t *instance = router->global->instance;
+
+	/* check route pool_size and storage max_connections,
+	 * which is shared by all routes using the storage */
+	if (od_router_route_is_full(route))
+		return NULL;
+	if (od_storage_is_full(route->storage))
+		return NULL;
+
+	/* create new server object, connection is started
+	 * by the attached client */
+	od_server_t *server;
+	server = od_server_allocate();
+	if (server == NULL)
+		return NULL;
+	od_id_mgr_generate(&instance->id_mgr, &server->id, "s");
+	server->global = router->global;
+	server->route = route;
+	od_storage_server_add(route->storage);
+	return server;
+}
+
+static inline void
+od_router_storage_enqueue(od_storage_t *storage, od_client_t *client)
+{
+	if (! od_list_empty(&client->link_storage))
+		return;
+	od_list_append(&storage->queue, &client->link_storage);
+	od_atomic_u32_inc(&storage->count_queue);
+}
+
+static inline void
+od_router_storage_dequeue(od_storage_t *storage, od_client_t *client)
+{
+	if (od_list_empty(&client->link_storage))
+		return;
+	od_list_unlink(&client->link_storage);
+	od_list_init(&client->link_storage);
+	od_atomic_u32_dec(&storage->count_queue);
+}
 
+static inline void
+od_router_attacher(void *arg)
+{
+	machine_msg_t *msg = arg;
 	od_msg_router_t *msg_attach;
-	msg_attach = machine_msg_get_data(arg);
+	msg_attach = machine_msg_get_data(msg);
 
 	od_client_t *client;
 	client = msg_attach->client;
@@ -95,103 +288,282 @@ od_router_attacher(void *arg)
 	od_route_t  *route;
 	route = client->route;
 
-	/* get server connection from route idle pool */
-	od_server_t *server;
-	for (;;)
-	{
-		server = od_server_pool_next(&route->server_pool, OD_SERVER_IDLE);
-		if (server)
-			goto on_attach;
-
-		/* always start new connection, if pool_size is zero */
-		if (route->config->pool_size == 0)
-			break;
-
-		/* maybe start new connection */
-		if (od_server_pool_total(&route->server_pool) < route->config->pool_size)
-			break;
+	od_storage_t *storage;
+	storage = route->storage;
 
-		/* pool_size limit implementation.
-		 *
-		 * If the limit reached, wait wakeup condition for
-		 * pool_timeout milliseconds.
-		 *
-		 * The condition triggered when a server connection
-		 * put into idle state by DETACH events.
-		 */
-		od_debug(&instance->logger, "router", client, NULL,
-		         "route '%s.%s' pool limit reached (%d), waiting",
-		          route->config->db_name,
-		          route->config->user_name,
-		          route->config->pool_size);
-
-		/* enqueue client */
-		od_client_pool_set(&route->client_pool, client, OD_CLIENT_QUEUE);
-
-		uint32_t timeout = route->config->pool_timeout;
-		if (timeout == 0)
-			timeout = UINT32_MAX;
-		int rc;
-		rc = machine_condition(timeout);
-		if (rc == -1) {
-			od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
-			od_error(&instance->logger, "router", client, NULL,
-			         "route '%s.%s' server pool wait timedout, closing",
-			         route->config->db_name,
-			         route->config->user_name);
-			msg_attach->status = OD_RERROR_TIMEDOUT;
-			machine_channel_write(msg_attach->response, msg);
+	/* get server connection from route idle pool or create
+	 * a new one, unless other clients are already waiting */
+	od_server_t *server;
+	od_route_lock(route);
+	if (route->client_pool.count_queue == 0) {
+		server = od_router_next_idle(route, client);
+		if (server == NULL)
+			server = od_router_server_new(router, route);
+		if (server) {
+			od_router_attach_server(route, client, server);
+			od_route_unlock(route);
+			msg_attach->status = OD_ROK;
+			machine_reply_signal(msg_attach->response);
 			return;
 		}
-		assert(client->state == OD_CLIENT_PENDING);
-
-		/* retry */
-		od_debug(&instance->logger, "router", client, NULL,
-		         "server pool attach retry");
-		continue;
 	}
 
-	/* create new server object */
-	server = od_server_allocate();
-	if (server == NULL) {
-		msg_attach->status = OD_RERROR;
-		machine_channel_write(msg_attach->response, msg);
+	/* pool_size and storage max_connections limits implementation.
+	 *
+	 * If the limit reached, enqueue client and wait wakeup
+	 * condition for pool_timeout milliseconds.
+	 *
+	 * Released server is attached to the next waiting client
+	 * before it is woken up (see od_router_wakeup()). Clients
+	 * are served by weighted fair queueing between priority
+	 * classes and in FIFO order within a class.
+	 *
+	 * Client waiting for the storage limit is also put in the
+	 * storage queue, which is served by evicting idle servers of
+	 * other routes (see od_router_storage_wakeup()).
+	 */
+	int storage_wait = ! od_router_route_is_full(route) &&
+	                   od_storage_is_full(storage);
+	od_client_pool_set(&route->client_pool, client, OD_CLIENT_QUEUE);
+	if (storage_wait)
+		od_router_storage_enqueue(storage, client);
+	od_route_unlock(route);
+
+	od_debug(&instance->logger, "router", client, NULL,
+	         "route '%s.%s' %s limit reached (%d), waiting",
+	          route->config->db_name,
+	          route->config->user_name,
+	          storage_wait ? "storage" : "pool",
+	          storage_wait ? storage->max_connections :
+	                         od_route_pool_size(route));
+
+	/* priority class timeout overrides route one */
+	uint32_t timeout = route->config->pool_timeout;
+	if (client->priority && client->priority->pool_timeout_set)
+		timeout = client->priority->pool_timeout;
+	if (timeout == 0)
+		timeout = UINT32_MAX;
+	uint64_t wait_start = machine_time();
+	int rc = 0;
+	if (storage_wait)
+		od_router_storage_wakeup(router, storage);
+	if (client->state == OD_CLIENT_QUEUE)
+		rc = machine_condition(timeout);
+	uint64_t wait_time = machine_time() - wait_start;
+	od_stat_wait(&route->stats, wait_time);
+
+	/* server could be attached even if wait has timedout */
+	od_route_lock(route);
+	od_router_storage_dequeue(storage, client);
+	od_stat_wait_priority(&route->stats, od_client_priority_id(client),
+	                      wait_time, client->server == NULL && rc == -1);
+	if (client->server) {
+		assert(client->state == OD_CLIENT_ACTIVE);
+		od_route_unlock(route);
+		msg_attach->status = OD_ROK;
+		machine_reply_signal(msg_attach->response);
 		return;
 	}
-	od_id_mgr_generate(&instance->id_mgr, &server->id, "s");
-	server->global = router->global;
-	server->route = route;
-
-on_attach:
-	od_server_pool_set(&route->server_pool, server, OD_SERVER_ACTIVE);
-	od_client_pool_set(&route->client_pool, client, OD_CLIENT_ACTIVE);
-	client->server = server;
-	server->client = client;
-	server->idle_time = 0;
-	/* assign client session key */
-	server->key_client = client->key;
-	msg_attach->status = OD_ROK;
-	machine_channel_write(msg_attach->response, msg);
+	od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
+	od_route_unlock(route);
+
+	if (rc == -1) {
+		od_error(&instance->logger, "router", client, NULL,
+		         "route '%s.%s' server pool wait timedout, closing",
+		         route->config->db_name,
+		         route->config->user_name);
+		msg_attach->status = OD_RERROR_TIMEDOUT;
+	} else {
+		msg_attach->status = OD_RERROR;
+	}
+	machine_reply_signal(msg_attach->response);
 }
 
-static inline void
+void
 od_router_wakeup(od_router_t *router, od_route_t *route)
 {
 	od_instance_t *instance;
 	instance = router->global->instance;
-	/* wake up first client waiting for route
-	 * server connection */
-	if (route->client_pool.count_queue > 0)
+	/* hand off idle server or a free pool slot to the next
+	 * client waiting for route server connection */
+	if (route->client_pool.count_queue == 0)
+		return;
+	od_client_t *waiter;
+	waiter = od_client_pool_next(&route->client_pool, OD_CLIENT_QUEUE);
+	od_server_t *server;
+	server = od_router_next_idle(route, waiter);
+	if (server == NULL) {
+		if (od_router_route_is_full(route))
+			return;
+		server = od_router_server_new(router, route);
+		if (server == NULL && od_storage_is_full(route->storage)) {
+			/* wait for a storage connection slot, storage
+			 * queue is served by od_router_storage_wakeup() */
+			od_router_storage_enqueue(route->storage, waiter);
+			return;
+		}
+	}
+	if (server)
+		od_router_attach_server(route, waiter, server);
+	else
+		od_client_pool_set(&route->client_pool, waiter, OD_CLIENT_PENDING);
+	int rc;
+	rc = machine_signal(waiter->coroutine_attacher_id);
+	assert(rc == 0);
+	(void)rc;
+	od_debug(&instance->logger, "router", waiter, server,
+	         "server released, waking up");
+}
+
+typedef struct
+{
+	od_router_t  *router;
+	od_storage_t *storage;
+	od_server_t  *server;
+} od_router_evict_t;
+
+static inline void
+od_router_evict_close(od_storage_t *storage, od_server_t *server)
+{
+	od_instance_t *instance = server->global->instance;
+	if (instance->is_shared)
+		machine_io_attach(server->io);
+	od_backend_close_connection(server);
+	od_backend_close(server);
+	od_storage_server_remove(storage);
+}
+
+static void
+od_router_evict_server(void *arg)
+{
+	od_router_evict_t *evict = arg;
+	od_router_t *router = evict->router;
+	od_storage_t *storage = evict->storage;
+	od_router_evict_close(storage, evict->server);
+	free(evict);
+
+	/* storage slot is free, serve next waiter */
+	storage->count_closing--;
+	od_router_storage_wakeup(router, storage);
+}
+
+static inline int
+od_router_storage_evict(od_router_t *router, od_storage_t *storage)
+{
+	od_instance_t *instance = router->global->instance;
+
+	/* find least recently used idle server among routes of
+	 * the storage, idle list tail is the oldest one */
+	od_route_t *victim = NULL;
+	int victim_idle_time = -1;
+	od_list_t *i;
+	od_list_foreach(&router->route_pool.list, i) {
+		od_route_t *route;
+		route = od_container_of(i, od_route_t, link);
+		if (route->storage != storage)
+			continue;
+		od_route_lock(route);
+		if (route->server_pool.count_idle > 0) {
+			od_server_t *server;
+			server = od_container_of(route->server_pool.idle.prev, od_server_t, link);
+			if (server->idle_time > victim_idle_time) {
+				victim = route;
+				victim_idle_time = server->idle_time;
+			}
+		}
+		od_route_unlock(route);
+	}
+	if (victim == NULL)
+		return -1;
+
+	/* idle server could be taken by a worker meanwhile */
+	od_server_t *server;
+	od_route_lock(victim);
+	if (victim->server_pool.count_idle == 0) {
+		od_route_unlock(victim);
+		return -1;
+	}
+	server = od_container_of(victim->server_pool.idle.prev, od_server_t, link);
+	od_server_pool_set(&victim->server_pool, server, OD_SERVER_UNDEF);
+	od_route_unlock(victim);
+	server->route = NULL;
+	server->idle_time = 0;
+	storage->count_evict++;
+
+	od_debug(&instance->logger, "router", NULL, server,
+	         "storage '%s' limit reached (%d), closing idle server of '%s.%s'",
+	         storage->name, storage->max_connections,
+	         victim->config->db_name,
+	         victim->config->user_name);
+
+	/* close connection in background, server is counted
+	 * against the storage limit until closed */
+	od_router_evict_t *evict;
+	evict = malloc(sizeof(*evict));
+	if (evict) {
+		evict->router  = router;
+		evict->storage = storage;
+		evict->server  = server;
+		storage->count_closing++;
+		int64_t coroutine_id;
+		coroutine_id = machine_coroutine_create(od_router_evict_server, evict);
+		if (coroutine_id != -1)
+			return 0;
+		storage->count_closing--;
+		free(evict);
+	}
+	od_router_evict_close(storage, server);
+	return 0;
+}
+
+void
+od_router_storage_wakeup(od_router_t *router, od_storage_t *storage)
+{
+	/* Serve clients waiting for the storage max_connections limit
+	 * in FIFO order: take a free storage slot or evict least recently
+	 * used idle server of any route using the storage.
+	 *
+	 * Must be called by the router without route locks held.
+	*/
+	while (od_atomic_u32_of(&storage->count_queue) > 0)
 	{
 		od_client_t *waiter;
-		waiter = od_client_pool_next(&route->client_pool, OD_CLIENT_QUEUE);
-		int rc;
-		rc = machine_signal(waiter->coroutine_attacher_id);
-		assert(rc == 0);
-		(void)rc;
-		od_client_pool_set(&route->client_pool, waiter, OD_CLIENT_PENDING);
-		od_debug(&instance->logger, "router", NULL, NULL,
-		         "server released, waking up");
+		waiter = od_container_of(storage->queue.next, od_client_t, link_storage);
+		od_route_t *route = waiter->route;
+
+		od_route_lock(route);
+		if (waiter->state != OD_CLIENT_QUEUE ||
+		    od_router_route_is_full(route)) {
+			/* served or waits for the route pool_size limit */
+			od_router_storage_dequeue(storage, waiter);
+			od_route_unlock(route);
+			continue;
+		}
+		od_server_t *server;
+		server = od_router_next_idle(route, waiter);
+		if (server == NULL && od_storage_is_full(storage)) {
+			od_route_unlock(route);
+			/* wakeup is repeated when evicted server is closed */
+			if (storage->count_closing > 0)
+				return;
+			int rc;
+			rc = od_router_storage_evict(router, storage);
+			if (rc == -1 || od_storage_is_full(storage))
+				return;
+			od_route_lock(route);
+		}
+		if (server == NULL)
+			server = od_router_server_new(router, route);
+		od_router_storage_dequeue(storage, waiter);
+		if (server)
+			od_router_attach_server(route, waiter, server);
+		else
+			od_client_pool_set(&route->client_pool, waiter, OD_CLIENT_PENDING);
+		od_route_unlock(route);
+
+		/* waiter could be the current coroutine, which has not
+		 * started waiting yet */
+		machine_signal(waiter->coroutine_attacher_id);
 	}
 }
 
@@ -219,12 +591,12 @@ od_router(void *arg)
 
 			/* ensure global client_max limit */
 			if (instance->config.client_max_set) {
-				if (router->clients >= instance->config.client_max) {
+				if ((int)od_atomic_u32_of(&router->clients) >= instance->config.client_max) {
 					od_log(&instance->logger, "router", NULL, NULL,
 					       "router: global client_max limit reached (%d)",
 					       instance->config.client_max);
 					msg_route->status = OD_RERROR_LIMIT;
-					machine_channel_write(msg_route->response, msg);
+					machine_reply_signal(msg_route->response);
 					break;
 				}
 			}
@@ -234,54 +606,56 @@ od_router(void *arg)
 			route = od_forward(router, &msg_route->client->startup);
 			if (route == NULL) {
 				msg_route->status = OD_RERROR_NOT_FOUND;
-				machine_channel_write(msg_route->response, msg);
+				machine_reply_signal(msg_route->response);
 				break;
 			}
 
-			/* ensure route client_max limit */
+			/* ensure route client_max limit, clients of the
+			 * replica route are counted too */
+			od_route_t *replica = route->replica;
+			od_route_lock(route);
 			if (route->config->client_max_set) {
 				int client_total;
 				client_total = od_client_pool_total(&route->client_pool);
+				if (replica) {
+					od_route_lock(replica);
+					client_total += od_client_pool_total(&replica->client_pool);
+					od_route_unlock(replica);
+				}
 				if (client_total >= route->config->client_max) {
+					od_route_unlock(route);
 					od_log(&instance->logger, "router", NULL, NULL,
 					       "route '%s.%s' client_max limit reached (%d)",
 					       route->config->db_name,
 					       route->config->user_name,
 					       route->config->client_max);
 					msg_route->status = OD_RERROR_LIMIT;
-					machine_channel_write(msg_route->response, msg);
+					machine_reply_signal(msg_route->response);
 					break;
 				}
 			}
 
+			/* select client priority class, it is used while
+			 * client waits in the route queue */
+			od_client_t *client = msg_route->client;
+			char *application_name = NULL;
+			if (client->startup.application_name)
+				application_name = kiwi_param_value(client->startup.application_name);
+			client->priority =
+				od_config_priority_select(&instance->config,
+				                          client->config_listen,
+				                          route->config,
+				                          application_name);
+
 			/* add client to route client pool */
 			od_client_pool_set(&route->client_pool, msg_route->client, OD_CLIENT_PENDING);
-			router->clients++;
+			od_route_unlock(route);
+			od_atomic_u32_inc(&router->clients);
 
 			msg_route->client->config = route->config;
 			msg_route->client->route = route;
 			msg_route->status = OD_ROK;
-			machine_channel_write(msg_route->response, msg);
-			break;
-		}
-
-		case OD_MROUTER_UNROUTE:
-		{
-			/* detach client from route */
-			od_msg_router_t *msg_unroute;
-			msg_unroute = machine_msg_get_data(msg);
-
-			od_client_t *client = msg_unroute->client;
-			od_route_t *route = client->route;
-			client->route = NULL;
-			assert(client->server == NULL);
-			od_client_pool_set(&route->client_pool, client, OD_CLIENT_UNDEF);
-
-			assert(router->clients > 0);
-			router->clients--;
-
-			msg_unroute->status = OD_ROK;
-			machine_channel_write(msg_unroute->response, msg);
+			machine_reply_signal(msg_route->response);
 			break;
 		}
 
@@ -298,7 +672,7 @@ od_router(void *arg)
 			coroutine_id = machine_coroutine_create(od_router_attacher, msg);
 			if (coroutine_id == -1) {
 				msg_attach->status = OD_RERROR;
-				machine_channel_write(msg_attach->response, msg);
+				machine_reply_signal(msg_attach->response);
 				break;
 			}
 			client->coroutine_attacher_id = coroutine_id;
@@ -307,54 +681,47 @@ od_router(void *arg)
 
 		case OD_MROUTER_DETACH:
 		{
-			/* push client server back to route server pool */
+			/* push client server back to route server pool
+			 * and wakeup attachers */
 			od_msg_router_t *msg_detach;
 			msg_detach = machine_msg_get_data(msg);
 
 			od_client_t *client = msg_detach->client;
 			od_route_t *route = client->route;
-			od_server_t *server = client->server;
 
-			client->server = NULL;
-			server->client = NULL;
-			server->last_client_id = client->id;
-			od_server_pool_set(&route->server_pool, server, OD_SERVER_IDLE);
+			od_route_lock(route);
+			od_router_detach_server(route, client);
 			od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
-
-			/* wakeup attachers */
 			od_router_wakeup(router, route);
+			od_route_unlock(route);
+			od_router_storage_wakeup(router, route->storage);
 
 			msg_detach->status = OD_ROK;
-			machine_channel_write(msg_detach->response, msg);
+			machine_reply_signal(msg_detach->response);
 			break;
 		}
 
 		case OD_MROUTER_DETACH_AND_UNROUTE:
 		{
 			/* push client server back to route server pool,
-			 * unroute client */
+			 * unroute client and wakeup attachers */
 			od_msg_router_t *msg_detach;
 			msg_detach = machine_msg_get_data(msg);
 
 			od_client_t *client = msg_detach->client;
 			od_route_t *route = client->route;
-			od_server_t *server = client->server;
-
-			server->last_client_id = client->id;
-			server->client = NULL;
-			od_server_pool_set(&route->server_pool, server, OD_SERVER_IDLE);
 
-			client->server = NULL;
+			od_route_lock(route);
+			od_router_detach_server(route, client);
 			client->route = NULL;
 			od_client_pool_set(&route->client_pool, client, OD_CLIENT_UNDEF);
-			assert(router->clients > 0);
-			router->clients--;
-
-			/* wakeup attachers */
 			od_router_wakeup(router, route);
+			od_route_unlock(route);
+			od_router_storage_wakeup(router, route->storage);
+			od_atomic_u32_dec(&router->clients);
 
 			msg_detach->status = OD_ROK;
-			machine_channel_write(msg_detach->response, msg);
+			machine_reply_signal(msg_detach->response);
 			break;
 		}
 
@@ -368,10 +735,15 @@ od_router(void *arg)
 			od_route_t *route = client->route;
 			od_server_t *server = client->server;
 
+			od_route_lock(route);
+			od_cancel_index_delete(&router->cancel_index, server);
 			client->server = NULL;
 			od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
-
 			od_server_pool_set(&route->server_pool, server, OD_SERVER_UNDEF);
+			od_storage_server_remove(route->storage);
+			od_router_wakeup(router, route);
+			od_route_unlock(route);
+			od_router_storage_wakeup(router, route->storage);
 			server->last_client_id = client->id;
 			server->client = NULL;
 			server->route  = NULL;
@@ -380,7 +752,7 @@ od_router(void *arg)
 			od_backend_close(server);
 
 			msg_detach->status = OD_ROK;
-			machine_channel_write(msg_detach->response, msg);
+			machine_reply_signal(msg_detach->response);
 			break;
 		}
 
@@ -393,42 +765,31 @@ od_router(void *arg)
 			od_client_t *client = msg_close->client;
 			od_route_t *route = client->route;
 			od_server_t *server = client->server;
-			od_server_pool_set(&route->server_pool, server, OD_SERVER_UNDEF);
 			server->client = NULL;
 			server->route  = NULL;
 
 			/* remove client from route client pool */
+			od_route_lock(route);
+			od_cancel_index_delete(&router->cancel_index, server);
+			od_server_pool_set(&route->server_pool, server, OD_SERVER_UNDEF);
+			od_storage_server_remove(route->storage);
 			client->server = NULL;
 			client->route  = NULL;
 			od_client_pool_set(&route->client_pool, client, OD_CLIENT_UNDEF);
-			assert(router->clients > 0);
-			router->clients--;
+			od_router_wakeup(router, route);
+			od_route_unlock(route);
+			od_router_storage_wakeup(router, route->storage);
+			assert(od_atomic_u32_of(&router->clients) > 0);
+			od_atomic_u32_dec(&router->clients);
 
 			assert(server->io == NULL);
 			od_backend_close(server);
 
 			msg_close->status = OD_ROK;
-			machine_channel_write(msg_close->response, msg);
+			machine_reply_signal(msg_close->response);
 			break;
 		}
 
-		case OD_MROUTER_CANCEL:
-		{
-			/* match server key and config by client key */
-			od_msg_router_t *msg_cancel;
-			msg_cancel = machine_msg_get_data(msg);
-
-			int rc;
-			rc = od_cancel_find(&router->route_pool,
-			                    &msg_cancel->client->startup.key,
-			                     msg_cancel->cancel);
-			if (rc == -1)
-				msg_cancel->status = OD_RERROR;
-			else
-				msg_cancel->status = OD_ROK;
-			machine_channel_write(msg_cancel->response, msg);
-			break;
-		}
 		default:
 			assert(0);
 			break;
@@ -440,6 +801,9 @@ void
 od_router_init(od_router_t *router, od_global_t *global)
 {
 	od_route_pool_init(&router->route_pool);
+	od_cancel_index_init(&router->cancel_index);
+	od_dns_init(&router->dns);
+	od_list_init(&router->storages);
 	router->global  = global;
 	router->clients = 0;
 	router->channel = NULL;
@@ -467,70 +831,111 @@ od_router_start(od_router_t *router)
 }
 
 static od_router_status_t
-od_router_do(od_client_t *client, od_msg_t msg_type, od_router_cancel_t *cancel)
+od_router_do(od_client_t *client, od_msg_t msg_type)
 {
 	od_router_t *router = client->global->router;
-	od_instance_t *instance = router->global->instance;
 
-	/* send request to router */
-	machine_msg_t *msg;
-	msg = machine_msg_create(sizeof(od_msg_router_t));
-	if (msg == NULL)
-		return OD_RERROR;
+	/* request message and reply slot are allocated once
+	 * per client and reused by the following requests */
+	if (client->router_msg == NULL) {
+		client->router_msg = machine_msg_create(sizeof(od_msg_router_t));
+		if (client->router_msg == NULL)
+			return OD_RERROR;
+	}
+	if (client->router_reply == NULL) {
+		client->router_reply = machine_reply_create();
+		if (client->router_reply == NULL)
+			return OD_RERROR;
+	}
+
+	machine_msg_t *msg = client->router_msg;
 	machine_msg_set_type(msg, msg_type);
 
 	od_msg_router_t *msg_route;
 	msg_route = machine_msg_get_data(msg);
 	msg_route->status = OD_RERROR;
 	msg_route->client = client;
-	msg_route->response = NULL;
-	msg_route->cancel = cancel;
-
-	/* create response channel */
-	machine_channel_t *response;
-	response = machine_channel_create(instance->is_shared);
-	if (response == NULL) {
-		machine_msg_free(msg);
-		return OD_RERROR;
-	}
-	msg_route->response = response;
-	machine_channel_write(router->channel, msg);
+	msg_route->response = client->router_reply;
 
-	/* wait for reply */
-	msg = machine_channel_read(response, UINT32_MAX);
-	if (msg == NULL) {
+	/* send request to router and wait for reply */
+	int rc;
+	rc = machine_channel_call(router->channel, msg, client->router_reply,
+	                          UINT32_MAX);
+	if (rc == -1)
 		abort();
-		machine_channel_free(response);
-		return OD_RERROR;
-	}
-	msg_route = machine_msg_get_data(msg);
-	od_router_status_t status;
-	status = msg_route->status;
-	machine_channel_free(response);
-	machine_msg_free(msg);
-	return status;
+	return msg_route->status;
 }
 
 od_router_status_t
 od_route(od_client_t *client)
 {
-	return od_router_do(client, OD_MROUTER_ROUTE, NULL);
+	return od_router_do(client, OD_MROUTER_ROUTE);
 }
 
 od_router_status_t
 od_unroute(od_client_t *client)
 {
-	return od_router_do(client, OD_MROUTER_UNROUTE, NULL);
+	od_router_t *router = client->global->router;
+	od_route_t *route = client->route;
+
+	/* detach client from route */
+	od_route_lock(route);
+	client->route = NULL;
+	assert(client->server == NULL);
+	od_client_pool_set(&route->client_pool, client, OD_CLIENT_UNDEF);
+	od_route_unlock(route);
+
+	assert(od_atomic_u32_of(&router->clients) > 0);
+	od_atomic_u32_dec(&router->clients);
+	return OD_ROK;
+}
+
+void
+od_router_switch(od_client_t *client, od_route_t *route)
+{
+	/* move client without server between primary and replica
+	 * routes, both routes are locked to keep them in use
+	 * for the gc (see od_route_pool_gc()) */
+	od_route_t *current = client->route;
+	od_route_t *primary = route->is_replica ? route->primary : route;
+	od_route_t *replica = primary->replica;
+	assert(client->server == NULL);
+	assert(current == primary || current == replica);
+	od_route_lock(primary);
+	od_route_lock(replica);
+	od_client_pool_set(&current->client_pool, client, OD_CLIENT_UNDEF);
+	od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
+	client->route = route;
+	od_route_unlock(replica);
+	od_route_unlock(primary);
 }
 
 od_router_status_t
 od_router_attach(od_client_t *client)
 {
 	od_instance_t *instance = client->global->instance;
-	od_router_status_t status;
-	status = od_router_do(client, OD_MROUTER_ATTACH, NULL);
+	od_route_t *route = client->route;
+
+	/* take idle server directly from route pool, unless
+	 * other clients are waiting for it. Router is used
+	 * to wait on the pool limit and to start new connections */
+	od_server_t *server = NULL;
+	od_route_lock(route);
+	if (route->client_pool.count_queue == 0) {
+		server = od_router_next_idle(route, client);
+		if (server)
+			od_router_attach_server(route, client, server);
+	}
+	od_route_unlock(route);
+
+	od_router_status_t status = OD_ROK;
+	if (server == NULL)
+		status = od_router_do(client, OD_MROUTER_ATTACH);
+
 	/* attach server io to clients machine context */
-	od_server_t *server = client->server;
+	server = client->server;
+	if (server)
+		server->machine = client->machine;
 	if (instance->is_shared) {
 		if (server && server->io)
 			machine_io_attach(server->io);
@@ -542,20 +947,50 @@ od_router_status_t
 od_router_detach(od_client_t *client)
 {
 	od_instance_t *instance = client->global->instance;
+	od_route_t *route = client->route;
 	od_server_t *server = client->server;
-	if (instance->is_shared)
+	if (instance->is_shared && server->io)
 		machine_io_detach(server->io);
-	return od_router_do(client, OD_MROUTER_DETACH, NULL);
+
+	/* return server to route pool directly, router is used
+	 * only to wakeup waiting attachers of the route or
+	 * its storage */
+	od_route_lock(route);
+	if (route->client_pool.count_queue > 0 ||
+	    od_atomic_u32_of(&route->storage->count_queue) > 0) {
+		od_route_unlock(route);
+		return od_router_do(client, OD_MROUTER_DETACH);
+	}
+	od_router_detach_server(route, client);
+	od_client_pool_set(&route->client_pool, client, OD_CLIENT_PENDING);
+	od_route_unlock(route);
+	return OD_ROK;
 }
 
 od_router_status_t
 od_router_detach_and_unroute(od_client_t *client)
 {
 	od_instance_t *instance = client->global->instance;
+	od_router_t *router = client->global->router;
+	od_route_t *route = client->route;
 	od_server_t *server = client->server;
-	if (instance->is_shared)
+	if (instance->is_shared && server->io)
 		machine_io_detach(server->io);
-	return od_router_do(client, OD_MROUTER_DETACH_AND_UNROUTE, NULL);
+
+	od_route_lock(route);
+	if (route->client_pool.count_queue > 0 ||
+	    od_atomic_u32_of(&route->storage->count_queue) > 0) {
+		od_route_unlock(route);
+		return od_router_do(client, OD_MROUTER_DETACH_AND_UNROUTE);
+	}
+	od_router_detach_server(route, client);
+	client->route = NULL;
+	od_client_pool_set(&route->client_pool, client, OD_CLIENT_UNDEF);
+	od_route_unlock(route);
+
+	assert(od_atomic_u32_of(&router->clients) > 0);
+	od_atomic_u32_dec(&router->clients);
+	return OD_ROK;
 }
 
 od_router_status_t
@@ -563,7 +998,7 @@ od_router_close(od_client_t *client)
 {
 	od_server_t *server = client->server;
 	od_backend_close_connection(server);
-	return od_router_do(client, OD_MROUTER_CLOSE, NULL);
+	return od_router_do(client, OD_MROUTER_CLOSE);
 }
 
 od_router_status_t
@@ -571,11 +1006,18 @@ od_router_close_and_unroute(od_client_t *client)
 {
 	od_server_t *server = client->server;
 	od_backend_close_connection(server);
-	return od_router_do(client, OD_MROUTER_CLOSE_AND_UNROUTE, NULL);
+	return od_router_do(client, OD_MROUTER_CLOSE_AND_UNROUTE);
 }
 
 od_router_status_t
 od_router_cancel(od_client_t *client, od_router_cancel_t *cancel)
 {
-	return od_router_do(client, OD_MROUTER_CANCEL, cancel);
+	/* match server key and config by client key, index is
+	 * shared between workers and router is not involved */
+	od_router_t *router = client->global->router;
+	int rc;
+	rc = od_cancel_find(&router->cancel_index, &client->startup.key, cancel);
+	if (rc == -1)
+		return OD_RERROR;
+	return OD_ROK;
 }
@@ -21,13 +21,24 @@ typedef enum
 struct od_router
 {
 	od_route_pool_t    route_pool;
+	od_cancel_index_t  cancel_index;
+	od_dns_t           dns;
+	od_list_t          storages;
 	machine_channel_t *channel;
-	int                clients;
+	od_atomic_u32_t    clients;
 	od_global_t       *global;
 };
 
 void od_router_init(od_router_t*, od_global_t*);
 int  od_router_start(od_router_t*);
+void od_router_wakeup(od_router_t*, od_route_t*);
+void od_router_storage_wakeup(od_router_t*, od_storage_t*);
+
+od_server_t*
+od_router_server_new(od_router_t*, od_route_t*);
+
+od_route_t*
+od_router_route_config(od_router_t*, od_config_route_t*);
 
 od_router_status_t
 od_route(od_client_t*);
@@ -35,6 +46,9 @@ od_route(od_client_t*);
 od_router_status_t
 od_unroute(od_client_t*);
 
+void
+od_router_switch(od_client_t*, od_route_t*);
+
 od_router_status_t
 od_router_attach(od_client_t*);
 
@@ -9,15 +9,17 @@
 
 typedef struct
 {
-	od_id_t              id;
-	od_config_storage_t *config;
-	kiwi_key_t           key;
+	od_id_t                id;
+	od_config_storage_t   *config;
+	od_storage_endpoint_t *endpoint;
+	kiwi_key_t             key;
 } od_router_cancel_t;
 
 static inline void
 od_router_cancel_init(od_router_cancel_t *cancel)
 {
 	cancel->config = NULL;
+	cancel->endpoint = NULL;
 	kiwi_key_init(&cancel->key);
 }
 
@@ -28,4 +30,28 @@ od_router_cancel_free(od_router_cancel_t *cancel)
 		od_config_storage_free(cancel->config);
 }
 
+typedef struct
+{
+	pthread_mutex_t lock;
+	od_list_t      *buckets;
+	int             buckets_count;
+	int             count;
+} od_cancel_index_t;
+
+static inline void
+od_cancel_index_init(od_cancel_index_t *index)
+{
+	pthread_mutex_init(&index->lock, NULL);
+	index->buckets = NULL;
+	index->buckets_count = 0;
+	index->count = 0;
+}
+
+static inline void
+od_cancel_index_free(od_cancel_index_t *index)
+{
+	pthread_mutex_destroy(&index->lock);
+	free(index->buckets);
+}
+
 #endif /* ODYSSEY_ROUTER_CANCEL_H */
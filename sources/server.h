@@ -14,7 +14,8 @@ typedef enum
 	OD_SERVER_UNDEF,
 	OD_SERVER_IDLE,
 	OD_SERVER_ACTIVE,
-	OD_SERVER_EXPIRE
+	OD_SERVER_EXPIRE,
+	OD_SERVER_CONNECT
 } od_server_state_t;
 
 struct od_server
@@ -26,6 +27,8 @@ struct od_server
 	int                is_allocated;
 	int                is_transaction;
 	int                is_copy;
+	int                is_dirty;
+	int                is_preconnected;
 	int                deploy_sync;
 	od_stat_state_t    stats_state;
 	uint64_t           sync_request;
@@ -34,11 +37,18 @@ struct od_server
 	kiwi_key_t         key;
 	kiwi_key_t         key_client;
 	od_id_t            last_client_id;
+	int64_t            machine;
 	machine_msg_t     *error_connect;
+	kiwi_params_t      params;
+	kiwi_params_t      deploy_params;
+	od_prepare_map_t   prepare_map;
+	od_prepare_queue_t prepare_queue;
 	void              *client;
 	void              *route;
+	void              *endpoint;
 	od_global_t       *global;
 	od_list_t          link;
+	od_list_t          link_cancel;
 };
 
 static inline void
@@ -46,6 +56,7 @@ od_server_init(od_server_t *server)
 {
 	server->state          = OD_SERVER_UNDEF;
 	server->route          = NULL;
+	server->endpoint       = NULL;
 	server->client         = NULL;
 	server->global         = NULL;
 	server->io             = NULL;
@@ -54,14 +65,22 @@ od_server_init(od_server_t *server)
 	server->is_allocated   = 0;
 	server->is_transaction = 0;
 	server->is_copy        = 0;
+	server->is_dirty       = 0;
+	server->is_preconnected = 0;
 	server->deploy_sync    = 0;
+	server->machine        = -1;
 	server->sync_request   = 0;
 	server->sync_reply     = 0;
 	server->error_connect  = NULL;
+	kiwi_params_init(&server->params);
+	kiwi_params_init(&server->deploy_params);
+	od_prepare_map_init(&server->prepare_map);
+	od_prepare_queue_init(&server->prepare_queue);
 	od_stat_state_init(&server->stats_state);
 	kiwi_key_init(&server->key);
 	kiwi_key_init(&server->key_client);
 	od_list_init(&server->link);
+	od_list_init(&server->link_cancel);
 	memset(&server->id, 0, sizeof(server->id));
 	memset(&server->last_client_id, 0, sizeof(server->last_client_id));
 }
@@ -80,6 +99,10 @@ od_server_allocate(void)
 static inline void
 od_server_free(od_server_t *server)
 {
+	kiwi_params_free(&server->params);
+	kiwi_params_free(&server->deploy_params);
+	od_prepare_map_free(&server->prepare_map);
+	od_prepare_queue_free(&server->prepare_queue);
 	if (server->is_allocated)
 		free(server);
 }
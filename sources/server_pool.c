@@ -24,9 +24,11 @@ od_server_pool_init(od_server_pool_t *pool)
 	pool->count_idle = 0;
 	pool->count_active = 0;
 	pool->count_expire = 0;
+	pool->count_connect = 0;
 	od_list_init(&pool->idle);
 	od_list_init(&pool->active);
 	od_list_init(&pool->expire);
+	od_list_init(&pool->connect);
 	od_list_init(&pool->link);
 }
 
@@ -47,6 +49,10 @@ od_server_pool_free(od_server_pool_t *pool)
 		server = od_container_of(i, od_server_t, link);
 		od_server_free(server);
 	}
+	od_list_foreach_safe(&pool->connect, i, n) {
+		server = od_container_of(i, od_server_t, link);
+		od_server_free(server);
+	}
 }
 
 void
@@ -67,6 +73,9 @@ od_server_pool_set(od_server_pool_t *pool, od_server_t *server,
 	case OD_SERVER_ACTIVE:
 		pool->count_active--;
 		break;
+	case OD_SERVER_CONNECT:
+		pool->count_connect--;
+		break;
 	}
 	od_list_t *target = NULL;
 	switch (state) {
@@ -84,6 +93,10 @@ od_server_pool_set(od_server_pool_t *pool, od_server_t *server,
 		target = &pool->active;
 		pool->count_active++;
 		break;
+	case OD_SERVER_CONNECT:
+		target = &pool->connect;
+		pool->count_connect++;
+		break;
 	}
 	od_list_unlink(&server->link);
 	od_list_init(&server->link);
@@ -110,6 +123,10 @@ od_server_pool_next(od_server_pool_t *pool, od_server_state_t state)
 		target_count = pool->count_active;
 		target = &pool->active;
 		break;
+	case OD_SERVER_CONNECT:
+		target_count = pool->count_connect;
+		target = &pool->connect;
+		break;
 	case OD_SERVER_UNDEF:
 		assert(0);
 		break;
@@ -121,6 +138,41 @@ od_server_pool_next(od_server_pool_t *pool, od_server_state_t state)
 	return server;
 }
 
+od_server_t*
+od_server_pool_next_idle(od_server_pool_t *pool, od_pool_policy_t policy,
+                         od_id_t *client_id, int64_t machine)
+{
+	if (pool->count_idle == 0)
+		return NULL;
+
+	/* idle list is kept in LIFO order: the most recently
+	 * used server goes first, the rest get expired */
+	od_server_t *server;
+	od_list_t *i;
+	switch (policy) {
+	case OD_POOL_POLICY_LIFO:
+		break;
+	case OD_POOL_POLICY_CLIENT:
+		/* server last used by the client */
+		od_list_foreach(&pool->idle, i) {
+			server = od_container_of(i, od_server_t, link);
+			if (od_id_mgr_cmp(&server->last_client_id, client_id))
+				return server;
+		}
+		break;
+	case OD_POOL_POLICY_WORKER:
+		/* server last used by the client worker machine */
+		od_list_foreach(&pool->idle, i) {
+			server = od_container_of(i, od_server_t, link);
+			if (server->machine == machine)
+				return server;
+		}
+		break;
+	}
+	server = od_container_of(pool->idle.next, od_server_t, link);
+	return server;
+}
+
 od_server_t*
 od_server_pool_foreach(od_server_pool_t *pool, od_server_state_t state,
                        od_server_pool_cb_t callback,
@@ -134,6 +186,8 @@ od_server_pool_foreach(od_server_pool_t *pool, od_server_state_t state,
 		break;
 	case OD_SERVER_ACTIVE: target = &pool->active;
 		break;
+	case OD_SERVER_CONNECT: target = &pool->connect;
+		break;
 	case OD_SERVER_UNDEF:  assert(0);
 		break;
 	}
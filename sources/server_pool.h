@@ -16,9 +16,11 @@ struct od_server_pool
 	od_list_t active;
 	od_list_t idle;
 	od_list_t expire;
+	od_list_t connect;
 	int       count_active;
 	int       count_idle;
 	int       count_expire;
+	int       count_connect;
 	od_list_t link;
 };
 
@@ -30,6 +32,10 @@ void od_server_pool_set(od_server_pool_t*, od_server_t*,
 od_server_t*
 od_server_pool_next(od_server_pool_t*, od_server_state_t);
 
+od_server_t*
+od_server_pool_next_idle(od_server_pool_t*, od_pool_policy_t,
+                         od_id_t*, int64_t);
+
 od_server_t*
 od_server_pool_foreach(od_server_pool_t*, od_server_state_t,
                        od_server_pool_cb_t, void*);
@@ -39,7 +45,8 @@ od_server_pool_total(od_server_pool_t *pool)
 {
 	return pool->count_active +
 	       pool->count_idle +
-	       pool->count_expire;
+	       pool->count_expire +
+	       pool->count_connect;
 }
 
 #endif /* ODYSSEY_SERVER_POOL_H */
@@ -0,0 +1,66 @@
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+*/
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#include <machinarium.h>
+#include <kiwi.h>
+#include <odyssey.h>
+
+/* server pool queue wait histogram, bucket upper
+ * bounds in microseconds */
+static const uint64_t
+od_stat_wait_buckets[OD_STAT_WAIT_BUCKETS] =
+{
+	1000, 5000, 10000, 50000, 100000, 500000, 1000000, UINT64_MAX
+};
+
+static inline void
+od_stat_max(od_atomic_u64_t *max, uint64_t value)
+{
+	/* retry until the value is stored or a larger one
+	 * is set concurrently */
+	uint64_t current = *max;
+	while (value > current) {
+		uint64_t prev;
+		prev = od_atomic_u64_cas(max, current, value);
+		if (prev == current)
+			break;
+		current = prev;
+	}
+}
+
+void
+od_stat_wait(od_stat_t *stat, uint64_t time_us)
+{
+	int i = 0;
+	while (time_us > od_stat_wait_buckets[i])
+		i++;
+	od_atomic_u64_inc(&stat->wait[i]);
+	od_atomic_u64_inc(&stat->count_wait);
+	od_atomic_u64_add(&stat->wait_time, time_us);
+	od_stat_max(&stat->wait_max, time_us);
+}
+
+void
+od_stat_wait_priority(od_stat_t *stat, int priority, uint64_t time_us,
+                      int timedout)
+{
+	od_stat_priority_t *class_stat = &stat->priority[priority];
+	od_atomic_u64_inc(&class_stat->count_wait);
+	if (timedout)
+		od_atomic_u64_inc(&class_stat->count_timeout);
+	od_atomic_u64_add(&class_stat->wait_time, time_us);
+	od_stat_max(&class_stat->wait_max, time_us);
+}
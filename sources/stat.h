@@ -7,8 +7,12 @@
  * Scalable PostgreSQL connection pooler.
 */
 
-typedef struct od_stat_state od_stat_state_t;
-typedef struct od_stat       od_stat_t;
+typedef struct od_stat_state    od_stat_state_t;
+typedef struct od_stat_priority od_stat_priority_t;
+typedef struct od_stat          od_stat_t;
+
+/* server pool queue wait histogram buckets */
+#define OD_STAT_WAIT_BUCKETS 8
 
 struct od_stat_state
 {
@@ -16,6 +20,15 @@ struct od_stat_state
 	uint64_t tx_time_start;
 };
 
+/* server pool queue wait per client priority class */
+struct od_stat_priority
+{
+	od_atomic_u64_t count_wait;
+	od_atomic_u64_t count_timeout;
+	od_atomic_u64_t wait_time;
+	od_atomic_u64_t wait_max;
+};
+
 struct od_stat
 {
 	od_atomic_u64_t count_query;
@@ -24,6 +37,18 @@ struct od_stat
 	od_atomic_u64_t tx_time;
 	od_atomic_u64_t recv_server;
 	od_atomic_u64_t recv_client;
+	od_atomic_u64_t count_deploy;
+	od_atomic_u64_t count_deploy_skip;
+	od_atomic_u64_t count_deploy_short;
+	od_atomic_u64_t count_affinity_hit;
+	od_atomic_u64_t count_affinity_miss;
+	od_atomic_u64_t count_preconnect;
+	od_atomic_u64_t count_preconnect_hit;
+	od_atomic_u64_t count_wait;
+	od_atomic_u64_t wait_time;
+	od_atomic_u64_t wait_max;
+	od_atomic_u64_t wait[OD_STAT_WAIT_BUCKETS];
+	od_stat_priority_t priority[OD_CONFIG_PRIORITY_MAX];
 };
 
 static inline void
@@ -98,6 +123,27 @@ od_stat_copy(od_stat_t *dst, od_stat_t *src)
 	dst->tx_time     = od_atomic_u64_of(&src->tx_time);
 	dst->recv_client = od_atomic_u64_of(&src->recv_client);
 	dst->recv_server = od_atomic_u64_of(&src->recv_server);
+	dst->count_deploy       = od_atomic_u64_of(&src->count_deploy);
+	dst->count_deploy_skip  = od_atomic_u64_of(&src->count_deploy_skip);
+	dst->count_deploy_short = od_atomic_u64_of(&src->count_deploy_short);
+	dst->count_affinity_hit  = od_atomic_u64_of(&src->count_affinity_hit);
+	dst->count_affinity_miss = od_atomic_u64_of(&src->count_affinity_miss);
+	dst->count_preconnect     = od_atomic_u64_of(&src->count_preconnect);
+	dst->count_preconnect_hit = od_atomic_u64_of(&src->count_preconnect_hit);
+	dst->count_wait = od_atomic_u64_of(&src->count_wait);
+	dst->wait_time  = od_atomic_u64_of(&src->wait_time);
+	dst->wait_max   = od_atomic_u64_of(&src->wait_max);
+	int i = 0;
+	for (; i < OD_STAT_WAIT_BUCKETS; i++)
+		dst->wait[i] = od_atomic_u64_of(&src->wait[i]);
+	for (i = 0; i < OD_CONFIG_PRIORITY_MAX; i++) {
+		od_stat_priority_t *a = &dst->priority[i];
+		od_stat_priority_t *b = &src->priority[i];
+		a->count_wait    = od_atomic_u64_of(&b->count_wait);
+		a->count_timeout = od_atomic_u64_of(&b->count_timeout);
+		a->wait_time     = od_atomic_u64_of(&b->wait_time);
+		a->wait_max      = od_atomic_u64_of(&b->wait_max);
+	}
 }
 
 static inline void
@@ -109,6 +155,29 @@ od_stat_sum(od_stat_t *sum, od_stat_t *stat)
 	sum->tx_time     += od_atomic_u64_of(&stat->tx_time);
 	sum->recv_client += od_atomic_u64_of(&stat->recv_client);
 	sum->recv_server += od_atomic_u64_of(&stat->recv_server);
+	sum->count_deploy       += od_atomic_u64_of(&stat->count_deploy);
+	sum->count_deploy_skip  += od_atomic_u64_of(&stat->count_deploy_skip);
+	sum->count_deploy_short += od_atomic_u64_of(&stat->count_deploy_short);
+	sum->count_affinity_hit  += od_atomic_u64_of(&stat->count_affinity_hit);
+	sum->count_affinity_miss += od_atomic_u64_of(&stat->count_affinity_miss);
+	sum->count_preconnect     += od_atomic_u64_of(&stat->count_preconnect);
+	sum->count_preconnect_hit += od_atomic_u64_of(&stat->count_preconnect_hit);
+	sum->count_wait += od_atomic_u64_of(&stat->count_wait);
+	sum->wait_time  += od_atomic_u64_of(&stat->wait_time);
+	if (od_atomic_u64_of(&stat->wait_max) > sum->wait_max)
+		sum->wait_max = od_atomic_u64_of(&stat->wait_max);
+	int i = 0;
+	for (; i < OD_STAT_WAIT_BUCKETS; i++)
+		sum->wait[i] += od_atomic_u64_of(&stat->wait[i]);
+	for (i = 0; i < OD_CONFIG_PRIORITY_MAX; i++) {
+		od_stat_priority_t *a = &sum->priority[i];
+		od_stat_priority_t *b = &stat->priority[i];
+		a->count_wait    += od_atomic_u64_of(&b->count_wait);
+		a->count_timeout += od_atomic_u64_of(&b->count_timeout);
+		a->wait_time     += od_atomic_u64_of(&b->wait_time);
+		if (od_atomic_u64_of(&b->wait_max) > a->wait_max)
+			a->wait_max = od_atomic_u64_of(&b->wait_max);
+	}
 }
 
 static inline void
@@ -138,6 +207,11 @@ od_stat_average(od_stat_t *avg, od_stat_t *current, od_stat_t *prev,
 	                    interval_us;
 	avg->recv_server = ((current->recv_server - prev->recv_server) * interval_usec) /
 	                    interval_us;
+	avg->wait_time   = ((current->wait_time - prev->wait_time) * interval_usec) /
+	                    interval_us;
 }
 
+void od_stat_wait(od_stat_t*, uint64_t);
+void od_stat_wait_priority(od_stat_t*, int, uint64_t, int);
+
 #endif /* ODYSSEY_STAT_H */
@@ -0,0 +1,149 @@
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+*/
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#include <machinarium.h>
+#include <kiwi.h>
+#include <odyssey.h>
+
+/* maximum backoff is host_backoff * 2^shift */
+#define OD_STORAGE_BACKOFF_SHIFT_MAX 3
+
+static inline od_storage_endpoint_t*
+od_storage_endpoint_match(od_storage_t *storage, od_config_endpoint_t *config)
+{
+	/* hosts are matched by address, so their state is kept
+	 * between config reloads */
+	od_list_t *i;
+	od_list_foreach(&storage->endpoints, i) {
+		od_storage_endpoint_t *endpoint;
+		endpoint = od_container_of(i, od_storage_endpoint_t, link);
+		if (endpoint->port == config->port &&
+		    strcmp(endpoint->host, config->host) == 0)
+			return endpoint;
+	}
+	od_storage_endpoint_t *endpoint;
+	endpoint = malloc(sizeof(*endpoint));
+	if (endpoint == NULL)
+		return NULL;
+	memset(endpoint, 0, sizeof(*endpoint));
+	endpoint->host = strdup(config->host);
+	if (endpoint->host == NULL) {
+		free(endpoint);
+		return NULL;
+	}
+	endpoint->port = config->port;
+	/* connections work without session resumption,
+	 * if the cache cannot be allocated */
+	endpoint->tls_session = machine_tls_session_create();
+	od_list_init(&endpoint->link);
+	od_list_append(&storage->endpoints, &endpoint->link);
+	return endpoint;
+}
+
+od_storage_endpoint_t*
+od_storage_endpoint_select(od_storage_t *storage, od_config_storage_t *config)
+{
+	/* Choose storage host for a new server connection.
+	 *
+	 * Hosts with recent connection errors are skipped until
+	 * their backoff time passes. If every host is in backoff,
+	 * the one to recover first is used.
+	 *
+	 * The scan starts from the next host on each call, so
+	 * ties are balanced round robin.
+	*/
+	uint64_t now = machine_time();
+	od_storage_endpoint_t *match = NULL;
+	od_storage_endpoint_t *match_backoff = NULL;
+
+	pthread_mutex_lock(&storage->lock);
+	int count = config->endpoints_count;
+	int start = storage->endpoints_next++ % count;
+	int i = 0;
+	for (; i < count; i++) {
+		od_storage_endpoint_t *endpoint;
+		endpoint = od_storage_endpoint_match(storage,
+		                                     &config->endpoints[(start + i) % count]);
+		if (endpoint == NULL)
+			continue;
+		if (endpoint->backoff > now) {
+			if (match_backoff == NULL || endpoint->backoff < match_backoff->backoff)
+				match_backoff = endpoint;
+			continue;
+		}
+		if (match == NULL) {
+			match = endpoint;
+			if (config->balance_policy == OD_BALANCE_ROUND_ROBIN)
+				break;
+			continue;
+		}
+		switch (config->balance_policy) {
+		case OD_BALANCE_LEAST_CONNECTIONS:
+			if (od_atomic_u32_of(&endpoint->count) < od_atomic_u32_of(&match->count))
+				match = endpoint;
+			break;
+		case OD_BALANCE_LEAST_LATENCY:
+			/* hosts without connections yet are tried first */
+			if (endpoint->latency < match->latency)
+				match = endpoint;
+			break;
+		case OD_BALANCE_ROUND_ROBIN:
+			break;
+		}
+	}
+	if (match == NULL)
+		match = match_backoff;
+	if (match)
+		od_atomic_u32_inc(&match->count);
+	pthread_mutex_unlock(&storage->lock);
+	return match;
+}
+
+void
+od_storage_endpoint_connected(od_storage_t *storage,
+                              od_storage_endpoint_t *endpoint,
+                              uint64_t time_connect)
+{
+	pthread_mutex_lock(&storage->lock);
+	endpoint->count_connect++;
+	endpoint->errors = 0;
+	endpoint->backoff = 0;
+	/* moving average of connect time */
+	if (endpoint->latency == 0)
+		endpoint->latency = time_connect;
+	else
+		endpoint->latency = (endpoint->latency * 7 + time_connect) / 8;
+	pthread_mutex_unlock(&storage->lock);
+}
+
+int
+od_storage_endpoint_failed(od_storage_t *storage,
+                           od_storage_endpoint_t *endpoint,
+                           int host_backoff)
+{
+	/* take host out of rotation, backoff time doubles
+	 * on each consecutive error */
+	pthread_mutex_lock(&storage->lock);
+	endpoint->count_error++;
+	int shift = endpoint->errors;
+	if (shift > OD_STORAGE_BACKOFF_SHIFT_MAX)
+		shift = OD_STORAGE_BACKOFF_SHIFT_MAX;
+	endpoint->errors++;
+	int backoff = host_backoff << shift;
+	endpoint->backoff = machine_time() + (uint64_t)backoff * 1000000;
+	pthread_mutex_unlock(&storage->lock);
+	return backoff;
+}
@@ -0,0 +1,141 @@
+#ifndef ODYSSEY_STORAGE_H
+#define ODYSSEY_STORAGE_H
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+*/
+
+typedef struct od_storage_endpoint od_storage_endpoint_t;
+typedef struct od_storage          od_storage_t;
+
+/* storage host state, shared by workers */
+struct od_storage_endpoint
+{
+	char            *host;
+	int              port;
+	od_atomic_u32_t  count;
+	uint64_t         count_connect;
+	uint64_t         count_error;
+	int              errors;
+	uint64_t         backoff;
+	uint64_t         latency;
+	/* tls sessions are resumed by new connections */
+	machine_tls_session_t *tls_session;
+	od_atomic_u64_t  count_tls_full;
+	od_atomic_u64_t  count_tls_resumed;
+	od_atomic_u64_t  tls_time_full;
+	od_atomic_u64_t  tls_time_resumed;
+	od_list_t        link;
+};
+
+/* server connections of all routes using the same
+ * storage, updated by the router only */
+struct od_storage
+{
+	char            *name;
+	int              max_connections;
+	int              count;
+	od_list_t        queue;
+	od_atomic_u32_t  count_queue;
+	uint64_t         count_evict;
+	/* evicted servers keep storage slots until closed */
+	int              count_closing;
+	/* hosts, updated under the lock */
+	pthread_mutex_t  lock;
+	od_list_t        endpoints;
+	uint32_t         endpoints_next;
+	od_list_t        link;
+};
+
+static inline od_storage_t*
+od_storage_allocate(char *name)
+{
+	od_storage_t *storage = malloc(sizeof(*storage));
+	if (storage == NULL)
+		return NULL;
+	storage->name = strdup(name);
+	if (storage->name == NULL) {
+		free(storage);
+		return NULL;
+	}
+	storage->max_connections = 0;
+	storage->count = 0;
+	storage->count_queue = 0;
+	storage->count_evict = 0;
+	storage->count_closing = 0;
+	storage->endpoints_next = 0;
+	pthread_mutex_init(&storage->lock, NULL);
+	od_list_init(&storage->queue);
+	od_list_init(&storage->endpoints);
+	od_list_init(&storage->link);
+	return storage;
+}
+
+static inline void
+od_storage_free(od_storage_t *storage)
+{
+	od_list_t *i, *n;
+	od_list_foreach_safe(&storage->endpoints, i, n) {
+		od_storage_endpoint_t *endpoint;
+		endpoint = od_container_of(i, od_storage_endpoint_t, link);
+		if (endpoint->tls_session)
+			machine_tls_session_free(endpoint->tls_session);
+		free(endpoint->host);
+		free(endpoint);
+	}
+	pthread_mutex_destroy(&storage->lock);
+	free(storage->name);
+	free(storage);
+}
+
+static inline void
+od_storage_server_add(od_storage_t *storage)
+{
+	storage->count++;
+}
+
+static inline void
+od_storage_server_remove(od_storage_t *storage)
+{
+	assert(storage->count > 0);
+	storage->count--;
+}
+
+static inline int
+od_storage_is_full(od_storage_t *storage)
+{
+	/* zero means no limit */
+	return storage->max_connections > 0 &&
+	       storage->count >= storage->max_connections;
+}
+
+od_storage_endpoint_t*
+od_storage_endpoint_select(od_storage_t*, od_config_storage_t*);
+
+void od_storage_endpoint_connected(od_storage_t*, od_storage_endpoint_t*,
+                                   uint64_t);
+int  od_storage_endpoint_failed(od_storage_t*, od_storage_endpoint_t*, int);
+
+static inline void
+od_storage_endpoint_handshake(od_storage_endpoint_t *endpoint, int is_resumed,
+                              uint64_t time_handshake)
+{
+	if (is_resumed) {
+		od_atomic_u64_inc(&endpoint->count_tls_resumed);
+		od_atomic_u64_add(&endpoint->tls_time_resumed, time_handshake);
+	} else {
+		od_atomic_u64_inc(&endpoint->count_tls_full);
+		od_atomic_u64_add(&endpoint->tls_time_full, time_handshake);
+	}
+}
+
+static inline void
+od_storage_endpoint_release(od_storage_endpoint_t *endpoint)
+{
+	assert(od_atomic_u32_of(&endpoint->count) > 0);
+	od_atomic_u32_dec(&endpoint->count);
+}
+
+#endif /* ODYSSEY_STORAGE_H */
@@ -93,6 +93,7 @@ od_system_server(void *arg)
 		client->io = client_io;
 		client->io_notify = notify_io;
 		client->config_listen = server->config;
+		client->listen = server;
 		client->tls = server->tls;
 		client->time_accept = machine_time();
 
@@ -107,6 +108,15 @@ od_system_server(void *arg)
 	}
 }
 
+static inline void
+od_system_server_free_tls(od_system_server_t *server)
+{
+	if (server->tls)
+		machine_tls_free(server->tls);
+	if (server->tls_tickets)
+		machine_tls_tickets_free(server->tls_tickets);
+}
+
 static inline int
 od_system_server_start(od_system_t *system, od_config_listen_t *config,
                        struct addrinfo *addr)
@@ -119,11 +129,11 @@ od_system_server_start(od_system_t *system, od_config_listen_t *config,
 		         "failed to allocate system server object");
 		return -1;
 	}
+	memset(server, 0, sizeof(*server));
 	server->config = config;
 	server->addr   = addr;
-	server->io     = NULL;
-	server->tls    = NULL;
 	server->global = &system->global;
+	od_list_init(&server->link);
 
 	/* create server tls */
 	if (server->config->tls_mode != OD_TLS_DISABLE) {
@@ -134,6 +144,19 @@ od_system_server_start(od_system_t *system, od_config_listen_t *config,
 			free(server);
 			return -1;
 		}
+		/* session ticket keys are shared by all workers */
+		if (server->config->tls_tickets) {
+			server->tls_tickets =
+				machine_tls_tickets_create(server->config->tls_tickets_rotate);
+			if (server->tls_tickets == NULL) {
+				od_error(&instance->logger, "server", NULL, NULL,
+				         "failed to create tls session tickets");
+				od_system_server_free_tls(server);
+				free(server);
+				return -1;
+			}
+			machine_tls_set_tickets(server->tls, server->tls_tickets);
+		}
 	}
 
 	/* create server io */
@@ -141,8 +164,7 @@ od_system_server_start(od_system_t *system, od_config_listen_t *config,
 	if (server->io == NULL) {
 		od_error(&instance->logger, "server", NULL, NULL,
 		         "failed to create system io");
-		if (server->tls)
-			machine_tls_free(server->tls);
+		od_system_server_free_tls(server);
 		free(server);
 		return -1;
 	}
@@ -176,8 +198,7 @@ od_system_server_start(od_system_t *system, od_config_listen_t *config,
 		         "bind to '%s' failed: %s",
 		         addr_name,
 		         machine_error(server->io));
-		if (server->tls)
-			machine_tls_free(server->tls);
+		od_system_server_free_tls(server);
 		machine_close(server->io);
 		machine_io_free(server->io);
 		free(server);
@@ -210,13 +231,13 @@ od_system_server_start(od_system_t *system, od_config_listen_t *config,
 	if (coroutine_id == -1) {
 		od_error(&instance->logger, "system", NULL, NULL,
 		         "failed to start server coroutine");
-		if (server->tls)
-			machine_tls_free(server->tls);
+		od_system_server_free_tls(server);
 		machine_close(server->io);
 		machine_io_free(server->io);
 		free(server);
 		return -1;
 	}
+	od_list_append(&system->servers, &server->link);
 	return 0;
 }
 
@@ -466,6 +487,7 @@ od_system_init(od_system_t *system)
 {
 	system->machine = -1;
 	memset(&system->global, 0, sizeof(system->global));
+	od_list_init(&system->servers);
 	return 0;
 }
 
@@ -7,25 +7,44 @@
  * Scalable PostgreSQL connection pooler.
 */
 
-typedef struct od_system_server od_system_server_t;
-typedef struct od_system        od_system_t;
+typedef struct od_system od_system_t;
 
 struct od_system_server
 {
-	machine_io_t       *io;
-	machine_tls_t      *tls;
-	od_config_listen_t *config;
-	struct addrinfo    *addr;
-	od_global_t        *global;
+	machine_io_t          *io;
+	machine_tls_t         *tls;
+	machine_tls_tickets_t *tls_tickets;
+	od_atomic_u64_t        count_tls_full;
+	od_atomic_u64_t        count_tls_resumed;
+	od_atomic_u64_t        tls_time_full;
+	od_atomic_u64_t        tls_time_resumed;
+	od_config_listen_t    *config;
+	struct addrinfo       *addr;
+	od_global_t           *global;
+	od_list_t              link;
 };
 
 struct od_system
 {
 	int64_t     machine;
 	od_global_t global;
+	od_list_t   servers;
 };
 
 int od_system_init(od_system_t*);
 int od_system_start(od_system_t*);
 
+static inline void
+od_system_server_handshake(od_system_server_t *server, int is_resumed,
+                           uint64_t time_handshake)
+{
+	if (is_resumed) {
+		od_atomic_u64_inc(&server->count_tls_resumed);
+		od_atomic_u64_add(&server->tls_time_resumed, time_handshake);
+	} else {
+		od_atomic_u64_inc(&server->count_tls_full);
+		od_atomic_u64_add(&server->tls_time_full, time_handshake);
+	}
+}
+
 #endif /* ODYSSEY_SYSTEM_H */
@@ -111,13 +111,23 @@ od_tls_frontend_accept(od_client_t *client,
 			         machine_error(client->io));
 			return -1;
 		}
+		uint64_t time_handshake;
+		time_handshake = machine_time();
 		rc = machine_set_tls(client->io, tls);
 		if (rc == -1) {
 			od_error(logger, "tls", client, NULL, "error: %s",
 			         machine_error(client->io));
 			return -1;
 		}
-		od_debug(logger, "tls", client, NULL, "ok");
+		time_handshake = machine_time() - time_handshake;
+		int is_resumed;
+		is_resumed = machine_io_is_resumed(client->io);
+		if (client->listen)
+			od_system_server_handshake(client->listen, is_resumed,
+			                           time_handshake);
+		od_debug(logger, "tls", client, NULL, "ok (%s, %d usec)",
+		         is_resumed ? "resumed" : "full handshake",
+		         (int)time_handshake);
 		return 0;
 	}
 	switch (config->tls_mode) {
@@ -175,7 +185,8 @@ od_tls_backend(od_config_storage_t *config)
 int
 od_tls_backend_connect(od_server_t *server,
                        od_logger_t *logger,
-                       od_config_storage_t *config)
+                       od_config_storage_t *config,
+                       od_storage_endpoint_t *endpoint)
 {
 	od_debug(logger, "tls", NULL, server, "init");
 
@@ -212,13 +223,25 @@ od_tls_backend_connect(od_server_t *server,
 	case 'S':
 		/* supported */
 		od_debug(logger, "tls", NULL, server, "supported");
+		/* resume the last session of the storage host */
+		if (endpoint && endpoint->tls_session)
+			machine_tls_set_session(server->tls, endpoint->tls_session);
+		uint64_t time_handshake;
+		time_handshake = machine_time();
 		rc = machine_set_tls(server->io, server->tls);
 		if (rc == -1) {
 			od_error(logger, "tls", NULL, server, "error: %s",
 			         machine_error(server->io));
 			return -1;
 		}
-		od_debug(logger, "tls", NULL, server, "ok");
+		time_handshake = machine_time() - time_handshake;
+		int is_resumed;
+		is_resumed = machine_io_is_resumed(server->io);
+		if (endpoint)
+			od_storage_endpoint_handshake(endpoint, is_resumed, time_handshake);
+		od_debug(logger, "tls", NULL, server, "ok (%s, %d usec)",
+		         is_resumed ? "resumed" : "full handshake",
+		         (int)time_handshake);
 		break;
 	case 'N':
 		/* not supported */
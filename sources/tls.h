@@ -18,6 +18,7 @@ machine_tls_t*
 od_tls_backend(od_config_storage_t*);
 
 int
-od_tls_backend_connect(od_server_t*, od_logger_t*, od_config_storage_t*);
+od_tls_backend_connect(od_server_t*, od_logger_t*, od_config_storage_t*,
+                       od_storage_endpoint_t*);
 
 #endif /* ODYSSEY_TLS_H */
@@ -0,0 +1,715 @@
+
+/*
+ * Odyssey.
+ *
+ * Scalable PostgreSQL connection pooler.
+*/
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <assert.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <machinarium.h>
+#include <kiwi.h>
+#include <odyssey.h>
+
+/* Router benchmarks.
+ *
+ * attach: measures server attach/detach rate of a single
+ * route from a number of worker threads. Route server pool is
+ * preloaded with idle server objects which have no
+ * connection, so only router and pools are involved.
+ *
+ * route: measures route pool lookup rate for 10, 1000 ..
+ * routes, compared to the linear scan of the routes list.
+ *
+ * config: measures parsing, route matching and reload of
+ * generated configs with 10, 1000 .. routes.
+*/
+
+typedef struct {
+	char     *benchmark;
+	int       time_to_run;
+	int       workers;
+	int       clients;
+	int       servers;
+	int       routes;
+	char     *pool;
+} bench_t;
+
+typedef struct bench_worker bench_worker_t;
+
+typedef struct {
+	od_client_t     client;
+	bench_worker_t *worker;
+} bench_client_t;
+
+struct bench_worker {
+	int             id;
+	int64_t         machine_id;
+	bench_client_t *clients;
+	int             clients_count;
+	uint64_t        attaches;
+	uint64_t        errors;
+};
+
+static bench_t       bench;
+static od_instance_t bench_instance;
+static od_router_t   bench_router;
+static od_global_t   bench_global;
+static volatile int  bench_run;
+
+static inline int
+bench_client_init(od_client_t *client)
+{
+	od_client_init(client);
+	client->global = &bench_global;
+	od_id_mgr_generate(&bench_instance.id_mgr, &client->id, "c");
+
+	kiwi_param_t *param;
+	param = kiwi_param_allocate("database", 9, "bench", 6);
+	if (param == NULL)
+		return -1;
+	kiwi_params_add(&client->startup.params, param);
+	client->startup.database = param;
+
+	param = kiwi_param_allocate("user", 5, "bench", 6);
+	if (param == NULL)
+		return -1;
+	kiwi_params_add(&client->startup.params, param);
+	client->startup.user = param;
+	return 0;
+}
+
+static inline void
+bench_client_free(od_client_t *client)
+{
+	kiwi_be_startup_free(&client->startup);
+	if (client->router_msg)
+		machine_msg_free(client->router_msg);
+	if (client->router_reply)
+		machine_reply_free(client->router_reply);
+}
+
+static inline void
+bench_client_main(void *arg)
+{
+	bench_client_t *bench_client = arg;
+	bench_worker_t *worker = bench_client->worker;
+	od_client_t *client = &bench_client->client;
+	client->machine = machine_self();
+
+	od_router_status_t status;
+	status = od_route(client);
+	if (status != OD_ROK) {
+		worker->errors++;
+		return;
+	}
+
+	while (bench_run)
+	{
+		status = od_router_attach(client);
+		if (status != OD_ROK) {
+			worker->errors++;
+			break;
+		}
+		status = od_router_detach(client);
+		if (status != OD_ROK) {
+			worker->errors++;
+			break;
+		}
+		worker->attaches++;
+
+		/* let other clients of this worker run */
+		if (worker->clients_count > 1)
+			machine_sleep(0);
+	}
+
+	od_unroute(client);
+}
+
+static inline void
+bench_worker_main(void *arg)
+{
+	bench_worker_t *worker = arg;
+
+	int64_t *coroutines;
+	coroutines = malloc(sizeof(int64_t) * worker->clients_count);
+	if (coroutines == NULL)
+		return;
+	int i = 0;
+	for (; i < worker->clients_count; i++) {
+		bench_client_t *client = &worker->clients[i];
+		client->worker = worker;
+		coroutines[i] = machine_coroutine_create(bench_client_main, client);
+	}
+	for (i = 0; i < worker->clients_count; i++) {
+		if (coroutines[i] != -1)
+			machine_join(coroutines[i]);
+	}
+	free(coroutines);
+}
+
+static inline int
+bench_preload(void)
+{
+	/* create route using a temporary client */
+	od_client_t client;
+	int rc;
+	rc = bench_client_init(&client);
+	if (rc == -1)
+		return -1;
+	client.machine = machine_self();
+	od_router_status_t status;
+	status = od_route(&client);
+	if (status != OD_ROK) {
+		bench_client_free(&client);
+		return -1;
+	}
+	od_route_t *route = client.route;
+	od_unroute(&client);
+	bench_client_free(&client);
+
+	/* add idle servers */
+	int i = 0;
+	for (; i < bench.servers; i++) {
+		od_server_t *server;
+		server = od_server_allocate();
+		if (server == NULL)
+			return -1;
+		od_id_mgr_generate(&bench_instance.id_mgr, &server->id, "s");
+		server->global = &bench_global;
+		server->route = route;
+		od_route_lock(route);
+		od_server_pool_set(&route->server_pool, server, OD_SERVER_IDLE);
+		od_route_unlock(route);
+	}
+	return 0;
+}
+
+static inline int
+bench_do(int workers_count)
+{
+	bench_worker_t *workers;
+	workers = calloc(workers_count, sizeof(bench_worker_t));
+	if (workers == NULL)
+		return -1;
+
+	/* prepare clients */
+	int i = 0;
+	for (; i < workers_count; i++) {
+		bench_worker_t *worker = &workers[i];
+		worker->id = i;
+		worker->clients_count = bench.clients;
+		worker->clients = calloc(bench.clients, sizeof(bench_client_t));
+		if (worker->clients == NULL)
+			return -1;
+		int j = 0;
+		for (; j < bench.clients; j++) {
+			int rc;
+			rc = bench_client_init(&worker->clients[j].client);
+			if (rc == -1)
+				return -1;
+		}
+	}
+
+	/* start workers */
+	bench_run = 1;
+	for (i = 0; i < workers_count; i++) {
+		bench_worker_t *worker = &workers[i];
+		char name[32];
+		snprintf(name, sizeof(name), "bench%d", i);
+		worker->machine_id = machine_create(name, bench_worker_main, worker);
+	}
+
+	/* give time for work */
+	uint64_t start_time = machine_time();
+	machine_sleep(bench.time_to_run * 1000);
+	bench_run = 0;
+
+	uint64_t attaches = 0;
+	uint64_t errors = 0;
+	for (i = 0; i < workers_count; i++) {
+		bench_worker_t *worker = &workers[i];
+		if (worker->machine_id != -1)
+			machine_wait(worker->machine_id);
+		attaches += worker->attaches;
+		errors += worker->errors;
+		int j = 0;
+		for (; j < bench.clients; j++)
+			bench_client_free(&worker->clients[j].client);
+		free(worker->clients);
+	}
+	free(workers);
+
+	double time_to_run;
+	time_to_run = (machine_time() - start_time) / 1000000.0;
+	printf("workers: %2d  attaches: %12.2f/sec  errors: %" PRIu64 "\n",
+	       workers_count, attaches / time_to_run, errors);
+	return 0;
+}
+
+static inline void
+bench_router_main(void *arg)
+{
+	(void)arg;
+	int rc;
+	rc = od_router_start(&bench_router);
+	if (rc == -1)
+		exit(1);
+}
+
+static inline void
+bench_main(void *arg)
+{
+	(void)arg;
+
+	/* router runs in its own thread, so that its coroutines
+	 * are not blocked while waiting for the workers */
+	int64_t machine_id;
+	machine_id = machine_create("router", bench_router_main, NULL);
+	if (machine_id == -1) {
+		printf("failed to create router thread\n");
+		exit(1);
+	}
+	while (bench_router.channel == NULL)
+		machine_sleep(1);
+
+	int rc;
+	rc = bench_preload();
+	if (rc == -1) {
+		printf("failed to preload route server pool\n");
+		goto done;
+	}
+
+	/* 1, 2, 4 .. workers */
+	int workers = 1;
+	for (;;) {
+		rc = bench_do(workers);
+		if (rc == -1)
+			break;
+		if (workers == bench.workers)
+			break;
+		workers *= 2;
+		if (workers > bench.workers)
+			workers = bench.workers;
+	}
+
+done:
+	/* router coroutine never finishes, terminate
+	 * the same way odyssey does on shutdown */
+	exit(rc == -1);
+}
+
+static inline uint64_t
+bench_time_us(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * (uint64_t)1000000 + t.tv_nsec / 1000;
+}
+
+static inline od_route_t*
+bench_route_scan(od_route_pool_t *pool, od_route_id_t *id,
+                 od_config_route_t *config)
+{
+	od_list_t *i;
+	od_list_foreach(&pool->list, i) {
+		od_route_t *route;
+		route = od_container_of(i, od_route_t, link);
+		if (route->config == config && od_route_id_compare(&route->id, id))
+			return route;
+	}
+	return NULL;
+}
+
+static inline double
+bench_route_lookup(od_route_pool_t *pool, od_config_route_t *config,
+                   char (*names)[32], int routes_count, int is_scan)
+{
+	uint64_t lookups = 0;
+	uint64_t start_time = bench_time_us();
+	uint64_t time_to_run = bench.time_to_run * (uint64_t)1000000;
+	uint64_t time_spent = 0;
+	int pos = 0;
+	while (time_spent < time_to_run)
+	{
+		int i = 0;
+		for (; i < 64; i++) {
+			/* visit routes in a scattered order */
+			pos = (pos + 7919) % routes_count;
+			od_route_id_t id = {
+				.database     = names[pos],
+				.database_len = strlen(names[pos]) + 1,
+				.user         = "bench",
+				.user_len     = 6
+			};
+			od_route_t *route;
+			if (is_scan)
+				route = bench_route_scan(pool, &id, config);
+			else
+				route = od_route_pool_match(pool, &id, config);
+			if (route == NULL)
+				abort();
+		}
+		lookups += 64;
+		time_spent = bench_time_us() - start_time;
+	}
+	return lookups / (time_spent / 1000000.0);
+}
+
+static inline int
+bench_route_do(od_config_route_t *config, int routes_count)
+{
+	char (*names)[32];
+	names = malloc(sizeof(*names) * routes_count);
+	if (names == NULL)
+		return -1;
+
+	od_route_pool_t pool;
+	od_route_pool_init(&pool);
+	int i = 0;
+	for (; i < routes_count; i++) {
+		snprintf(names[i], sizeof(names[i]), "database%d", i);
+		od_route_id_t id = {
+			.database     = names[i],
+			.database_len = strlen(names[i]) + 1,
+			.user         = "bench",
+			.user_len     = 6
+		};
+		od_route_t *route;
+		route = od_route_pool_new(&pool, config, &id);
+		if (route == NULL) {
+			od_route_pool_free(&pool);
+			free(names);
+			return -1;
+		}
+	}
+
+	double index_rate;
+	index_rate = bench_route_lookup(&pool, config, names, routes_count, 0);
+	double scan_rate;
+	scan_rate = bench_route_lookup(&pool, config, names, routes_count, 1);
+	printf("routes: %6d  index: %12.2f/sec  list: %12.2f/sec\n",
+	       routes_count, index_rate, scan_rate);
+
+	od_route_pool_free(&pool);
+	free(names);
+	return 0;
+}
+
+static inline int
+bench_route(void)
+{
+	od_config_route_t *config;
+	config = od_container_of(bench_instance.config.routes.next,
+	                         od_config_route_t, link);
+	/* 10, 1000 .. routes */
+	int routes = 10;
+	for (;;) {
+		int rc;
+		rc = bench_route_do(config, routes);
+		if (rc == -1)
+			return -1;
+		if (routes == bench.routes)
+			break;
+		routes *= 100;
+		if (routes > bench.routes)
+			routes = bench.routes;
+	}
+	return 0;
+}
+
+static inline int
+bench_config_write(char *path, int routes_count, int version)
+{
+	FILE *file = fopen(path, "w");
+	if (file == NULL)
+		return -1;
+	fprintf(file,
+	        "log_format \"%%p %%t %%l [%%i %%s] (%%c) %%m\\n\"\n"
+	        "listen { host \"127.0.0.1\" port 6432 }\n"
+	        "storage \"bench\" { type \"remote\" host \"127.0.0.1\" port 5432 }\n"
+	        "database default {\n"
+	        "\tuser default { authentication \"none\" storage \"bench\" pool \"transaction\" }\n"
+	        "}\n");
+	int i = 0;
+	for (; i < routes_count; i++) {
+		/* every tenth route is changed by the next version */
+		int pool_size = 10;
+		if (i % 10 == 0)
+			pool_size += version;
+		fprintf(file,
+		        "database \"database%d\" {\n"
+		        "\tuser \"bench\" { authentication \"none\" storage \"bench\" pool \"transaction\" pool_size %d }\n"
+		        "\tuser default { authentication \"none\" storage \"bench\" pool \"session\" }\n"
+		        "}\n", i, pool_size);
+	}
+	fclose(file);
+	return 0;
+}
+
+static inline int
+bench_config_read(od_config_t *config, char *path)
+{
+	od_config_init(config);
+	od_error_t error;
+	od_error_init(&error);
+	int rc;
+	rc = od_config_reader_import(config, &error, path);
+	if (rc == -1) {
+		printf("%s\n", error.error);
+		return -1;
+	}
+	return od_config_validate(config, &bench_instance.logger);
+}
+
+static inline int
+bench_config_do(int routes_count)
+{
+	char path[64];
+	snprintf(path, sizeof(path), "/tmp/odyssey_bench.%d.conf", (int)getpid());
+
+	/* parse */
+	int rc;
+	rc = bench_config_write(path, routes_count, 0);
+	if (rc == -1)
+		return -1;
+	od_config_t config;
+	uint64_t start_time = bench_time_us();
+	rc = bench_config_read(&config, path);
+	uint64_t parse_time = bench_time_us() - start_time;
+	if (rc == -1)
+		goto error;
+
+	/* match routes, including default ones */
+	uint64_t lookups = 0;
+	uint64_t time_to_run = bench.time_to_run * (uint64_t)1000000;
+	uint64_t time_spent = 0;
+	start_time = bench_time_us();
+	int pos = 0;
+	while (time_spent < time_to_run)
+	{
+		int i = 0;
+		for (; i < 64; i++) {
+			char db_name[32];
+			pos = (pos + 7919) % (routes_count + routes_count / 4 + 1);
+			snprintf(db_name, sizeof(db_name), "database%d", pos);
+			od_config_route_t *route;
+			route = od_config_route_forward(&config, db_name,
+			                                (i % 2) ? "bench" : "other");
+			if (route == NULL)
+				abort();
+		}
+		lookups += 64;
+		time_spent = bench_time_us() - start_time;
+	}
+
+	/* reload, every tenth route is updated */
+	rc = bench_config_write(path, routes_count, 1);
+	if (rc == -1)
+		goto error;
+	od_config_t config_new;
+	start_time = bench_time_us();
+	rc = bench_config_read(&config_new, path);
+	if (rc == -1) {
+		od_config_free(&config_new);
+		goto error;
+	}
+	od_config_merge(&config, &bench_instance.logger, &config_new);
+	od_config_free(&config_new);
+	uint64_t reload_time = bench_time_us() - start_time;
+
+	printf("routes: %6d  parse: %8.2f ms  match: %12.2f/sec  reload: %8.2f ms\n",
+	       routes_count,
+	       parse_time / 1000.0,
+	       lookups / (time_spent / 1000000.0),
+	       reload_time / 1000.0);
+
+	od_config_free(&config);
+	unlink(path);
+	return 0;
+error:
+	od_config_free(&config);
+	unlink(path);
+	return -1;
+}
+
+static inline int
+bench_config(void)
+{
+	/* 10, 1000 .. routes */
+	int routes = 10;
+	for (;;) {
+		int rc;
+		rc = bench_config_do(routes);
+		if (rc == -1)
+			return -1;
+		if (routes == bench.routes)
+			break;
+		routes *= 100;
+		if (routes > bench.routes)
+			routes = bench.routes;
+	}
+	return 0;
+}
+
+static inline int
+bench_configure(void)
+{
+	od_config_t *config = &bench_instance.config;
+	config->log_to_stdout = 0;
+	od_logger_set_stdout(&bench_instance.logger, 0);
+
+	od_config_storage_t *storage;
+	storage = od_config_storage_add(config);
+	if (storage == NULL)
+		return -1;
+	storage->name = strdup("bench");
+	storage->storage_type = OD_STORAGE_TYPE_REMOTE;
+
+	od_config_route_t *route;
+	route = od_config_route_add(config);
+	if (route == NULL)
+		return -1;
+	route->db_name = strdup("bench");
+	route->db_name_len = strlen(route->db_name);
+	route->user_name = strdup("bench");
+	route->user_name_len = strlen(route->user_name);
+	int rc;
+	rc = od_config_route_index(config, route);
+	if (rc == -1)
+		return -1;
+	route->storage = storage;
+	route->pool_sz = strdup(bench.pool);
+	if (strcmp(bench.pool, "session") == 0)
+		route->pool = OD_POOL_TYPE_SESSION;
+	else
+		route->pool = OD_POOL_TYPE_TRANSACTION;
+	route->pool_size = bench.servers;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	memset(&bench, 0, sizeof(bench));
+	bench.benchmark = "attach";
+	bench.time_to_run = 2;
+	bench.workers = 32;
+	bench.clients = 1;
+	bench.servers = 0;
+	bench.routes = 100000;
+	bench.pool = "transaction";
+
+	int opt;
+	while ((opt = getopt(argc, argv, "b:t:w:c:s:r:p:")) != -1) {
+		switch (opt) {
+		/* benchmark */
+		case 'b':
+			bench.benchmark = optarg;
+			break;
+		/* time */
+		case 't':
+			bench.time_to_run = atoi(optarg);
+			break;
+		/* max workers */
+		case 'w':
+			bench.workers = atoi(optarg);
+			break;
+		/* clients per worker */
+		case 'c':
+			bench.clients = atoi(optarg);
+			break;
+		/* servers */
+		case 's':
+			bench.servers = atoi(optarg);
+			break;
+		/* max routes */
+		case 'r':
+			bench.routes = atoi(optarg);
+			break;
+		/* pool mode */
+		case 'p':
+			bench.pool = optarg;
+			break;
+		default:
+			printf("Odyssey router benchmark.\n\n");
+			printf("usage: %s [btwcsrp]\n", argv[0]);
+			printf("  \n");
+			printf("  -b <benchmark>  attach (default), route or config\n");
+			printf("  -t <time>       time to run for each step (seconds)\n");
+			printf("  -w <workers>    max number of workers (1, 2, 4 .. workers)\n");
+			printf("  -c <clients>    number of clients per worker\n");
+			printf("  -s <servers>    number of idle servers (default: all clients)\n");
+			printf("  -r <routes>     max number of routes (10, 1000 .. routes)\n");
+			printf("  -p <pool>       transaction (default) or session\n");
+			return 1;
+		}
+	}
+	if (bench.workers <= 0)
+		bench.workers = 1;
+	if (bench.clients <= 0)
+		bench.clients = 1;
+	if (bench.servers <= 0)
+		bench.servers = bench.workers * bench.clients;
+	if (bench.routes <= 0)
+		bench.routes = 1;
+
+	printf("Odyssey router benchmark.\n\n");
+	printf("benchmark:   %s\n", bench.benchmark);
+	printf("time to run: %d secs\n", bench.time_to_run);
+
+	od_instance_init(&bench_instance);
+	bench_instance.is_shared = 1;
+
+	int rc;
+	rc = bench_configure();
+	if (rc == -1)
+		return 1;
+
+	if (strcmp(bench.benchmark, "config") == 0) {
+		printf("routes:      10 - %d\n", bench.routes);
+		printf("\n");
+		rc = bench_config();
+		od_config_free(&bench_instance.config);
+		return rc == -1;
+	}
+
+	if (strcmp(bench.benchmark, "route") == 0) {
+		printf("routes:      10 - %d\n", bench.routes);
+		printf("\n");
+		rc = bench_route();
+		od_config_free(&bench_instance.config);
+		return rc == -1;
+	}
+
+	printf("workers:     1 - %d\n", bench.workers);
+	printf("clients:     %d per worker\n", bench.clients);
+	printf("servers:     %d\n", bench.servers);
+	printf("pool:        %s\n", bench.pool);
+	printf("\n");
+
+	memset(&bench_global, 0, sizeof(bench_global));
+	bench_global.instance = &bench_instance;
+	bench_global.router = &bench_router;
+	od_router_init(&bench_router, &bench_global);
+
+	machinarium_init();
+	od_id_mgr_seed(&bench_instance.id_mgr);
+
+	int64_t machine_id;
+	machine_id = machine_create("bench", bench_main, NULL);
+	if (machine_id == -1) {
+		printf("failed to create bench thread\n");
+		return 1;
+	}
+	machine_wait(machine_id);
+	return 0;
+}
@@ -26,6 +26,9 @@ typedef struct {
 	machine_io_t *io;
 	int           coroutine_id;
 	int           processed;
+	kiwi_key_t    key;
+	uint64_t      rows;
+	uint64_t      bytes;
 } stress_client_t;
 
 typedef struct {
@@ -35,6 +38,12 @@ typedef struct {
 	char *port;
 	int   time_to_run;
 	int   clients;
+	char *scenario;
+	int   rows;
+	int   row_size;
+	int   chunk;
+	int   rate;
+	int   cancel_delay;
 } stress_t;
 
 static stress_t       stress;
@@ -59,6 +68,107 @@ stress_read(machine_io_t *io)
 	return msg;
 }
 
+static inline int
+stress_execute(stress_client_t *client, char *query)
+{
+	machine_msg_t *msg;
+	msg = kiwi_fe_write_query(query, strlen(query) + 1);
+	if (msg == NULL)
+		return -1;
+	int rc;
+	rc = machine_write(client->io, msg);
+	if (rc == -1)
+		return -1;
+	int is_error = 0;
+	for (;;) {
+		msg = stress_read(client->io);
+		if (msg == NULL)
+			return -1;
+		char type = *(char*)machine_msg_get_data(msg);
+		machine_msg_free(msg);
+		if (type == KIWI_BE_ERROR_RESPONSE)
+			is_error = 1;
+		if (type == KIWI_BE_READY_FOR_QUERY)
+			break;
+	}
+	return is_error ? -1 : 0;
+}
+
+static inline int
+stress_copy_in(stress_client_t *client, char *chunk, int chunk_size)
+{
+	/* send rows in CopyData messages of chunk size */
+	int64_t left = (int64_t)stress.rows * stress.row_size;
+	while (left > 0)
+	{
+		int size = chunk_size;
+		if (size > left)
+			size = left;
+		machine_msg_t *msg;
+		msg = kiwi_fe_write_copy_data(chunk, size);
+		if (msg == NULL)
+			return -1;
+		int rc;
+		rc = machine_write(client->io, msg);
+		if (rc == -1)
+			return -1;
+		rc = machine_flush(client->io, UINT32_MAX);
+		if (rc == -1)
+			return -1;
+		client->bytes += size;
+		left -= size;
+	}
+	client->rows += stress.rows;
+
+	machine_msg_t *msg;
+	msg = kiwi_fe_write_copy_done();
+	if (msg == NULL)
+		return -1;
+	return machine_write(client->io, msg);
+}
+
+static inline int
+stress_cancel(stress_client_t *client)
+{
+	/* send CancelRequest for the client key using a
+	 * separate connection, as libpq does */
+	machine_io_t *io;
+	io = machine_io_create();
+	if (io == NULL)
+		return -1;
+	machine_set_nodelay(io, 1);
+
+	struct addrinfo *ai = NULL;
+	int rc;
+	rc = machine_getaddrinfo(stress.host, stress.port, NULL, &ai, UINT32_MAX);
+	if (rc == -1)
+		goto error;
+	rc = machine_connect(io, ai->ai_addr, UINT32_MAX);
+	freeaddrinfo(ai);
+	if (rc == -1)
+		goto error;
+
+	machine_msg_t *msg;
+	msg = kiwi_fe_write_cancel(client->key.key_pid, client->key.key);
+	if (msg == NULL)
+		goto error;
+	rc = machine_write(io, msg);
+	if (rc == -1)
+		goto error;
+	rc = machine_flush(io, UINT32_MAX);
+	if (rc == -1)
+		goto error;
+
+	machine_close(io);
+	machine_io_free(io);
+	return 0;
+error:
+	printf("client %d: cancel error: %s\n", client->id, machine_error(io));
+	machine_close(io);
+	machine_io_free(io);
+	return -1;
+}
+
 static inline void
 stress_client_main(void *arg)
 {
@@ -127,6 +237,8 @@ stress_client_main(void *arg)
 			return;
 		}
 		char type = *(char*)machine_msg_get_data(msg);
+		if (type == KIWI_BE_BACKEND_KEY_DATA)
+			kiwi_fe_read_key(msg, &client->key);
 		machine_msg_free(msg);
 
 		if (type == KIWI_BE_ERROR_RESPONSE)
@@ -137,15 +249,45 @@ stress_client_main(void *arg)
 
 	printf("client %d: ready\n", client->id);
 
-	char query[] = "SELECT 1";
+	/* select: oltp, large: result sets of many rows,
+	 * copy: bulk load using COPY FROM STDIN,
+	 * cancel: cancel storm of long running queries */
+	char query[256];
+	char *chunk = NULL;
+	int is_cancel = strcmp(stress.scenario, "cancel") == 0;
+	if (is_cancel) {
+		snprintf(query, sizeof(query), "SELECT pg_sleep(10)");
+	} else
+	if (strcmp(stress.scenario, "large") == 0) {
+		snprintf(query, sizeof(query),
+		         "SELECT i, repeat('x', %d) FROM generate_series(1, %d) i",
+		         stress.row_size, stress.rows);
+	} else
+	if (strcmp(stress.scenario, "copy") == 0) {
+		rc = stress_execute(client, "CREATE TEMP TABLE odyssey_stress (data text)");
+		if (rc == -1) {
+			printf("client %d: failed to create table\n", client->id);
+			return;
+		}
+		snprintf(query, sizeof(query), "COPY odyssey_stress FROM STDIN");
+
+		/* rows of row width, including new line */
+		chunk = malloc(stress.chunk);
+		if (chunk == NULL)
+			return;
+		int i;
+		for (i = 0; i < stress.chunk; i++)
+			chunk[i] = ((i + 1) % stress.row_size == 0) ? '\n' : 'x';
+	} else {
+		snprintf(query, sizeof(query), "SELECT 1");
+	}
 
-	/* oltp */
 	while (stress_run)
 	{
 		int start_time = od_histogram_time_us();
 
 		/* request */
-		msg = kiwi_fe_write_query(query, sizeof(query));
+		msg = kiwi_fe_write_query(query, strlen(query) + 1);
 		if (msg == NULL)
 			return;
 		rc = machine_write(client->io, msg);
@@ -156,20 +298,54 @@ stress_client_main(void *arg)
 		}
 		/* no flush */
 
+		/* cancel query while it is running, latency is
+		 * measured from the cancel request */
+		if (is_cancel) {
+			rc = machine_flush(client->io, UINT32_MAX);
+			if (rc == -1) {
+				printf("client %d: write error: %s\n", client->id,
+				       machine_error(client->io));
+				return;
+			}
+			machine_sleep(stress.cancel_delay);
+			start_time = od_histogram_time_us();
+			rc = stress_cancel(client);
+			if (rc == -1)
+				return;
+		}
+
 		/* reply */
 		for (;;) {
 			msg = stress_read(client->io);
-			if (rc == -1) {
+			if (msg == NULL) {
 				printf("client %d: read error: %s\n", client->id,
 				       machine_error(client->io));
+				free(chunk);
 				return;
 			}
 			char type = *(char*)machine_msg_get_data(msg);
+			client->bytes += machine_msg_get_size(msg);
 			machine_msg_free(msg);
 
+			if (type == KIWI_BE_COPY_IN_RESPONSE) {
+				rc = stress_copy_in(client, chunk, stress.chunk);
+				if (rc == -1) {
+					printf("client %d: write error: %s\n", client->id,
+					       machine_error(client->io));
+					free(chunk);
+					return;
+				}
+				continue;
+			}
+
 			if (type == KIWI_BE_ERROR_RESPONSE)
 				break;
 
+			if (type == KIWI_BE_DATA_ROW) {
+				client->rows++;
+				continue;
+			}
+
 			if (type == KIWI_BE_READY_FOR_QUERY) {
 				int execution_time = od_histogram_time_us() - start_time;
 				od_histogram_add(&stress_histogram, execution_time);
@@ -177,8 +353,17 @@ stress_client_main(void *arg)
 				break;
 			}
 		}
+
+		/* keep fixed per-client request rate */
+		if (stress.rate > 0) {
+			int left = 1000000 / stress.rate - (od_histogram_time_us() - start_time);
+			if (left > 0)
+				machine_sleep(left / 1000);
+		}
 	}
 
+	free(chunk);
+
 	/* finish */
 	msg = kiwi_fe_write_terminate();
 	if (rc == -1)
@@ -226,16 +411,24 @@ stress_main(void *arg)
 	stress_run = 0;
 
 	/* wait for completion and calculate stats */
+	uint64_t rows = 0;
+	uint64_t bytes = 0;
 	for (i = 0; i < stress->clients; i++) {
 		stress_client_t *client = &clients[i];
 		machine_join(client->coroutine_id);
 		if (client->io)
 			machine_io_free(client->io);
+		rows  += client->rows;
+		bytes += client->bytes;
 	}
 	free(clients);
 
 	/* result */
 	od_histogram_print(&stress_histogram, stress->clients, stress->time_to_run);
+	printf("rows              : %.2f rows/sec\n",
+	       (double)rows / stress->time_to_run);
+	printf("transferred       : %.2f MB/sec\n",
+	       (double)bytes / (1024 * 1024) / stress->time_to_run);
 }
 
 int main(int argc, char *argv[])
@@ -252,9 +445,15 @@ int main(int argc, char *argv[])
 	stress.port = "6432";
 	stress.time_to_run = 5;
 	stress.clients = 10;
+	stress.scenario = "select";
+	stress.rows = 10000;
+	stress.row_size = 100;
+	stress.chunk = 65536;
+	stress.rate = 0;
+	stress.cancel_delay = 10;
 
 	int opt;
-	while ((opt = getopt(argc, argv, "d:u:h:p:t:c:")) != -1) {
+	while ((opt = getopt(argc, argv, "d:u:h:p:t:c:s:r:w:b:q:l:")) != -1) {
 		switch (opt) {
 		/* database */
 		case 'd':
@@ -280,9 +479,33 @@ int main(int argc, char *argv[])
 		case 'c':
 			stress.clients = atoi(optarg);
 			break;
+		/* scenario */
+		case 's':
+			stress.scenario = optarg;
+			break;
+		/* rows per result */
+		case 'r':
+			stress.rows = atoi(optarg);
+			break;
+		/* row width */
+		case 'w':
+			stress.row_size = atoi(optarg);
+			break;
+		/* CopyData message size */
+		case 'b':
+			stress.chunk = atoi(optarg);
+			break;
+		/* requests per second per client */
+		case 'q':
+			stress.rate = atoi(optarg);
+			break;
+		/* delay before cancel request */
+		case 'l':
+			stress.cancel_delay = atoi(optarg);
+			break;
 		default:
 			printf("PostgreSQL benchmarking.\n\n");
-			printf("usage: %s [duhptc]\n", argv[0]);
+			printf("usage: %s [duhptcsrwbql]\n", argv[0]);
 			printf("  \n");
 			printf("  -d <database>   database name\n");
 			printf("  -u <user>       user name\n");
@@ -290,6 +513,12 @@ int main(int argc, char *argv[])
 			printf("  -p <port>       server port\n");
 			printf("  -t <time>       time to run (seconds)\n");
 			printf("  -c <clients>    number of clients\n");
+			printf("  -s <scenario>   select (default), large, copy or cancel\n");
+			printf("  -r <rows>       rows per result or COPY (large, copy)\n");
+			printf("  -w <width>      row width in bytes (large, copy)\n");
+			printf("  -b <size>       CopyData message size (copy)\n");
+			printf("  -q <rate>       requests per second per client (0 - unlimited)\n");
+			printf("  -l <msec>       delay before cancel request (cancel)\n");
 			return 1;
 		}
 	}
@@ -301,6 +530,18 @@ int main(int argc, char *argv[])
 	printf("user:        %s\n", stress.user);
 	printf("host:        %s\n", stress.host);
 	printf("port:        %s\n", stress.port);
+	printf("scenario:    %s\n", stress.scenario);
+	if (stress.rate > 0)
+		printf("rate:        %d rps per client\n", stress.rate);
+	if (strcmp(stress.scenario, "cancel") == 0)
+		printf("cancel delay: %d ms\n", stress.cancel_delay);
+	else
+	if (strcmp(stress.scenario, "select") != 0) {
+		printf("rows:        %d\n", stress.rows);
+		printf("row width:   %d\n", stress.row_size);
+	}
+	if (strcmp(stress.scenario, "copy") == 0)
+		printf("copy chunk:  %d\n", stress.chunk);
 	printf("\n");
 
 	machinarium_init();
@@ -0,0 +1,176 @@
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <string.h>
+#include <arpa/inet.h>
+
+/*
+ * Ping-pong over a persistent poll set: every message costs one
+ * read and one write, ios are registered only once.
+ */
+
+#define PINGPONG_COUNT 10000
+
+static machine_io_t *notify = NULL;
+
+static void
+server(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	machine_io_t *client;
+	rc = machine_accept(server, &client, 16, 1, UINT32_MAX);
+	test(rc == 0);
+	machine_set_nodelay(client, 1);
+
+	machine_pollset_t *pollset;
+	pollset = machine_pollset_create();
+	test(pollset != NULL);
+
+	rc = machine_pollset_add(pollset, notify);
+	test(rc == 0);
+	rc = machine_pollset_add(pollset, client);
+	test(rc == 0);
+	rc = machine_pollset_add(pollset, client);
+	test(rc == -1);
+
+	int count = 0;
+	int done = 0;
+	while (! done)
+	{
+		machine_io_t *ready[2];
+		rc = machine_pollset_wait(pollset, ready, 2, UINT32_MAX);
+		test(rc > 0);
+		int i;
+		for (i = 0; i < rc; i++) {
+			if (ready[i] == notify) {
+				machine_msg_t *msg;
+				msg = machine_read(notify, sizeof(uint64_t), UINT32_MAX);
+				test(msg != NULL);
+				machine_msg_free(msg);
+				done = 1;
+				continue;
+			}
+			test(ready[i] == client);
+
+			/* echo everything buffered */
+			char *data;
+			int size;
+			size = machine_read_peek(client, &data);
+			if (size == 0)
+				continue;
+			test(size % sizeof(uint32_t) == 0);
+			count += size / sizeof(uint32_t);
+			rc = machine_write_direct(client, data, size);
+			test(rc == 0);
+			rc = machine_read_advance(client, size);
+			test(rc == 0);
+		}
+	}
+	test(count == PINGPONG_COUNT);
+
+	rc = machine_pollset_delete(pollset, client);
+	test(rc == 0);
+	rc = machine_pollset_delete(pollset, client);
+	test(rc == -1);
+	machine_pollset_free(pollset);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+
+	rc = machine_close(notify);
+	test(rc == 0);
+	machine_io_free(notify);
+}
+
+static void
+client(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = machine_io_create();
+	test(client != NULL);
+	machine_set_nodelay(client, 1);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	uint32_t i;
+	for (i = 0; i < PINGPONG_COUNT; i++) {
+		rc = machine_write_direct(client, (char*)&i, sizeof(i));
+		test(rc == 0);
+		machine_msg_t *msg;
+		msg = machine_read(client, sizeof(i), UINT32_MAX);
+		test(msg != NULL);
+		test(*(uint32_t*)machine_msg_get_data(msg) == i);
+		machine_msg_free(msg);
+	}
+
+	/* wakeup server */
+	machine_msg_t *msg;
+	msg = machine_msg_create(0);
+	test(msg != NULL);
+	uint64_t value = 1;
+	rc = machine_msg_write(msg, (char*)&value, sizeof(value));
+	test(rc == 0);
+	rc = machine_write(notify, msg);
+	test(rc == 0);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+}
+
+static void
+test_cs(void *arg)
+{
+	(void)arg;
+	notify = machine_io_create();
+	test(notify != NULL);
+	int rc;
+	rc = machine_eventfd(notify);
+	test(rc == 0);
+	rc = machine_io_attach(notify);
+	test(rc == 0);
+
+	rc = machine_coroutine_create(server, NULL);
+	test(rc != -1);
+
+	rc = machine_coroutine_create(client, NULL);
+	test(rc != -1);
+}
+
+void
+machinarium_test_pollset(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_cs, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
@@ -0,0 +1,140 @@
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <string.h>
+#include <arpa/inet.h>
+
+static void
+server(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	machine_io_t *client;
+	rc = machine_accept(server, &client, 16, 1, UINT32_MAX);
+	test(rc == 0);
+	machine_set_nodelay(client, 1);
+
+	char chunk[1000];
+	int i = 0;
+	for (; i < (int)sizeof(chunk); i++)
+		chunk[i] = i % 256;
+
+	machine_msg_t *msg;
+	msg = machine_msg_create(0);
+	test(msg != NULL);
+	rc = machine_msg_write(msg, chunk, sizeof(chunk));
+	test(rc == 0);
+	rc = machine_write(client, msg);
+	test(rc == 0);
+	rc = machine_flush(client, UINT32_MAX);
+	test(rc == 0);
+
+	/* read relayed data back */
+	msg = machine_read(client, sizeof(chunk), UINT32_MAX);
+	test(msg != NULL);
+	test(memcmp(machine_msg_get_data(msg), chunk, sizeof(chunk)) == 0);
+	machine_msg_free(msg);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+}
+
+static void
+client(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = machine_io_create();
+	test(client != NULL);
+	machine_set_nodelay(client, 1);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	char *data;
+	rc = machine_read_peek(client, &data);
+	test(rc == 0);
+	test(data == NULL);
+
+	/* relay received data back without copying it
+	 * from the readahead buffer */
+	int relayed = 0;
+	while (relayed < 1000)
+	{
+		machine_io_t *ready;
+		rc = machine_read_poll(&client, &ready, 1, UINT32_MAX);
+		test(rc == 1);
+
+		int size;
+		size = machine_read_peek(client, &data);
+		test(size > 0);
+		test(data != NULL);
+
+		rc = machine_read_advance(client, size + 1);
+		test(rc == -1);
+
+		rc = machine_write_direct(client, data, size);
+		test(rc == 0);
+		rc = machine_read_advance(client, size);
+		test(rc == 0);
+		relayed += size;
+	}
+	test(relayed == 1000);
+
+	rc = machine_read_peek(client, &data);
+	test(rc == 0);
+
+	rc = machine_flush(client, UINT32_MAX);
+	test(rc == 0);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+}
+
+static void
+test_cs(void *arg)
+{
+	(void)arg;
+	int rc;
+	rc = machine_coroutine_create(server, NULL);
+	test(rc != -1);
+
+	rc = machine_coroutine_create(client, NULL);
+	test(rc != -1);
+}
+
+void
+machinarium_test_read_peek(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_cs, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
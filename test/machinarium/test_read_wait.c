@@ -0,0 +1,128 @@
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <string.h>
+#include <arpa/inet.h>
+
+static void
+server(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	machine_io_t *client;
+	rc = machine_accept(server, &client, 16, 1, UINT32_MAX);
+	test(rc == 0);
+	machine_set_nodelay(client, 1);
+
+	char chunk[1000];
+	int i = 0;
+	for (; i < (int)sizeof(chunk); i++)
+		chunk[i] = i % 256;
+
+	/* write data in two parts */
+	rc = machine_write_direct(client, chunk, 600);
+	test(rc == 0);
+	machine_sleep(100);
+	rc = machine_write_direct(client, chunk + 600, sizeof(chunk) - 600);
+	test(rc == 0);
+
+	/* wait for client eof */
+	machine_msg_t *msg;
+	msg = machine_read(client, 1, UINT32_MAX);
+	test(msg == NULL);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+}
+
+static void
+client(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = machine_io_create();
+	test(client != NULL);
+	machine_set_nodelay(client, 1);
+
+	int rc;
+	rc = machine_set_readahead(client, 1000);
+	test(rc == 0);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	rc = machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	/* larger than readahead */
+	rc = machine_read_wait(client, 2000, UINT32_MAX);
+	test(rc == -1);
+
+	rc = machine_read_wait(client, 600, UINT32_MAX);
+	test(rc == 0);
+
+	char *data;
+	rc = machine_read_peek(client, &data);
+	test(rc == 600);
+	rc = machine_read_advance(client, 100);
+	test(rc == 0);
+
+	/* rest of the data does not fit after the read position,
+	 * buffered data must be moved to the beginning */
+	rc = machine_read_wait(client, 900, UINT32_MAX);
+	test(rc == 0);
+	rc = machine_read_peek(client, &data);
+	test(rc == 900);
+	int i = 0;
+	for (; i < 900; i++)
+		test(data[i] == (char)((100 + i) % 256));
+	rc = machine_read_advance(client, 900);
+	test(rc == 0);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+}
+
+static void
+test_cs(void *arg)
+{
+	(void)arg;
+	int rc;
+	rc = machine_coroutine_create(server, NULL);
+	test(rc != -1);
+
+	rc = machine_coroutine_create(client, NULL);
+	test(rc != -1);
+}
+
+void
+machinarium_test_read_wait(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_cs, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
@@ -0,0 +1,80 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+/* request-reply between two machines */
+
+static machine_channel_t *channel;
+
+static void
+test_server(void *arg)
+{
+	(void)arg;
+	for (;;) {
+		machine_msg_t *msg;
+		msg = machine_channel_read(channel, UINT32_MAX);
+		test(msg != NULL);
+		machine_reply_t **reply = machine_msg_get_data(msg);
+		if (*reply == NULL) {
+			machine_msg_free(msg);
+			break;
+		}
+		machine_msg_set_type(msg, machine_msg_get_type(msg) + 1);
+		machine_reply_signal(*reply);
+	}
+}
+
+static void
+test_client(void *arg)
+{
+	(void)arg;
+	machine_reply_t *reply;
+	reply = machine_reply_create();
+	test(reply != NULL);
+
+	/* request message and reply slot are reused */
+	machine_msg_t *msg;
+	msg = machine_msg_create(sizeof(machine_reply_t*));
+	test(msg != NULL);
+	*(machine_reply_t**)machine_msg_get_data(msg) = reply;
+
+	int i = 0;
+	for (; i < 1000; i++) {
+		machine_msg_set_type(msg, i);
+		int rc;
+		rc = machine_channel_call(channel, msg, reply, UINT32_MAX);
+		test(rc == 0);
+		test(machine_msg_get_type(msg) == i + 1);
+	}
+	machine_reply_free(reply);
+
+	/* stop server */
+	*(machine_reply_t**)machine_msg_get_data(msg) = NULL;
+	machine_channel_write(channel, msg);
+}
+
+void
+machinarium_test_reply0(void)
+{
+	machinarium_init();
+
+	channel = machine_channel_create(1);
+	test(channel != NULL);
+
+	int server_id;
+	server_id = machine_create("server", test_server, NULL);
+	test(server_id != -1);
+
+	int client_id;
+	client_id = machine_create("client", test_client, NULL);
+	test(client_id != -1);
+
+	int rc;
+	rc = machine_wait(client_id);
+	test(rc != -1);
+	rc = machine_wait(server_id);
+	test(rc != -1);
+
+	machine_channel_free(channel);
+	machinarium_free();
+}
@@ -0,0 +1,77 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+/* request-reply within one machine, reply timeout */
+
+static machine_channel_t *channel;
+
+static void
+test_server(void *arg)
+{
+	(void)arg;
+	machine_msg_t *msg;
+	msg = machine_channel_read(channel, UINT32_MAX);
+	test(msg != NULL);
+	machine_reply_t *reply = *(machine_reply_t**)machine_msg_get_data(msg);
+	machine_msg_set_type(msg, 1);
+	machine_reply_signal(reply);
+
+	/* do not reply to the second request in time */
+	msg = machine_channel_read(channel, UINT32_MAX);
+	test(msg != NULL);
+	machine_sleep(100);
+	machine_reply_signal(reply);
+}
+
+static void
+test_client(void *arg)
+{
+	(void)arg;
+	channel = machine_channel_create(0);
+	test(channel != NULL);
+
+	int64_t id;
+	id = machine_coroutine_create(test_server, NULL);
+	test(id != -1);
+
+	machine_reply_t *reply;
+	reply = machine_reply_create();
+	test(reply != NULL);
+
+	machine_msg_t *msg;
+	msg = machine_msg_create(sizeof(machine_reply_t*));
+	test(msg != NULL);
+	*(machine_reply_t**)machine_msg_get_data(msg) = reply;
+
+	int rc;
+	rc = machine_channel_call(channel, msg, reply, UINT32_MAX);
+	test(rc == 0);
+	test(machine_msg_get_type(msg) == 1);
+
+	rc = machine_channel_call(channel, msg, reply, 10);
+	test(rc == -1);
+	test(machine_timedout());
+
+	/* late reply is ignored */
+	machine_join(id);
+	machine_reply_free(reply);
+	machine_msg_free(msg);
+	machine_channel_free(channel);
+}
+
+void
+machinarium_test_reply1(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_client, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
@@ -0,0 +1,153 @@
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <string.h>
+#include <arpa/inet.h>
+
+#define SPLICE_SIZE (1024 * 1024)
+
+static void
+server(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	/* writer connects first */
+	machine_io_t *src;
+	rc = machine_accept(server, &src, 16, 1, UINT32_MAX);
+	test(rc == 0);
+
+	machine_io_t *dst;
+	rc = machine_accept(server, &dst, 16, 1, UINT32_MAX);
+	test(rc == 0);
+
+	/* part of the data is already in readahead */
+	machine_msg_t *msg;
+	msg = machine_read(src, 16, UINT32_MAX);
+	test(msg != NULL);
+	rc = machine_write_direct(dst, machine_msg_get_data(msg), 16);
+	test(rc == 0);
+	machine_msg_free(msg);
+
+	rc = machine_splice(src, dst, SPLICE_SIZE - 16, UINT32_MAX);
+	test(rc == 0);
+
+	/* wait for reader eof */
+	msg = machine_read(dst, 1, UINT32_MAX);
+	test(msg == NULL);
+
+	rc = machine_close(src);
+	test(rc == 0);
+	machine_io_free(src);
+
+	rc = machine_close(dst);
+	test(rc == 0);
+	machine_io_free(dst);
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+}
+
+static inline machine_io_t*
+client_connect(void)
+{
+	machine_io_t *client = machine_io_create();
+	test(client != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+	test(rc == 0);
+	return client;
+}
+
+static void
+writer(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = client_connect();
+
+	machine_msg_t *msg;
+	msg = machine_msg_create(SPLICE_SIZE);
+	test(msg != NULL);
+	char *data = machine_msg_get_data(msg);
+	int i = 0;
+	for (; i < SPLICE_SIZE; i++)
+		data[i] = i % 251;
+
+	int rc;
+	rc = machine_write(client, msg);
+	test(rc == 0);
+	rc = machine_flush(client, UINT32_MAX);
+	test(rc == 0);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+}
+
+static void
+reader(void *arg)
+{
+	(void)arg;
+	machine_sleep(100);
+	machine_io_t *client = client_connect();
+
+	machine_msg_t *msg;
+	msg = machine_read(client, SPLICE_SIZE, UINT32_MAX);
+	test(msg != NULL);
+	char *data = machine_msg_get_data(msg);
+	int i = 0;
+	for (; i < SPLICE_SIZE; i++)
+		test(data[i] == (char)(i % 251));
+	machine_msg_free(msg);
+
+	int rc;
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+}
+
+static void
+test_cs(void *arg)
+{
+	(void)arg;
+	int rc;
+	rc = machine_coroutine_create(server, NULL);
+	test(rc != -1);
+
+	rc = machine_coroutine_create(writer, NULL);
+	test(rc != -1);
+
+	rc = machine_coroutine_create(reader, NULL);
+	test(rc != -1);
+}
+
+void
+machinarium_test_splice(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_cs, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
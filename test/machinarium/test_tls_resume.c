@@ -0,0 +1,170 @@
+
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <string.h>
+#include <arpa/inet.h>
+
+#define CONNECTS 3
+
+static void
+server(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	machine_tls_tickets_t *tickets;
+	tickets = machine_tls_tickets_create(60);
+	test(tickets != NULL);
+
+	machine_tls_t *tls;
+	tls = machine_tls_create();
+	rc = machine_tls_set_verify(tls, "none");
+	test(rc == 0);
+	rc = machine_tls_set_ca_file(tls, "./machinarium/ca.crt");
+	test(rc == 0);
+	rc = machine_tls_set_cert_file(tls, "./machinarium/server.crt");
+	test(rc == 0);
+	rc = machine_tls_set_key_file(tls, "./machinarium/server.key");
+	test(rc == 0);
+	rc = machine_tls_set_tickets(tls, tickets);
+	test(rc == 0);
+
+	int i = 0;
+	for (; i < CONNECTS; i++) {
+		machine_io_t *client = NULL;
+		rc = machine_accept(server, &client, 16, 1, UINT32_MAX);
+		test(rc == 0);
+		test(client != NULL);
+
+		rc = machine_set_tls(client, tls);
+		if (rc == -1) {
+			printf("%s\n", machine_error(client));
+			test(rc == 0);
+		}
+		/* first connection does a full handshake */
+		test(machine_io_is_resumed(client) == (i > 0));
+
+		machine_msg_t *msg;
+		msg = machine_msg_create(0);
+		test(msg != NULL);
+		char text[] = "hello world";
+		rc = machine_msg_write(msg, text, sizeof(text));
+		test(rc == 0);
+
+		rc = machine_write(client, msg);
+		test(rc == 0);
+
+		rc = machine_flush(client, UINT32_MAX);
+		test(rc == 0);
+
+		rc = machine_close(client);
+		test(rc == 0);
+		machine_io_free(client);
+	}
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+
+	machine_tls_free(tls);
+	machine_tls_tickets_free(tickets);
+}
+
+static void
+client(void *arg)
+{
+	(void)arg;
+	machine_tls_session_t *session;
+	session = machine_tls_session_create();
+	test(session != NULL);
+
+	int i = 0;
+	for (; i < CONNECTS; i++) {
+		machine_io_t *client = machine_io_create();
+		test(client != NULL);
+
+		struct sockaddr_in sa;
+		sa.sin_family = AF_INET;
+		sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+		sa.sin_port = htons(7778);
+		int rc;
+		rc = machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+		test(rc == 0);
+
+		machine_tls_t *tls;
+		tls = machine_tls_create();
+		rc = machine_tls_set_verify(tls, "none");
+		test(rc == 0);
+		rc = machine_tls_set_ca_file(tls, "./machinarium/ca.crt");
+		test(rc == 0);
+		rc = machine_tls_set_cert_file(tls, "./machinarium/client.crt");
+		test(rc == 0);
+		rc = machine_tls_set_key_file(tls, "./machinarium/client.key");
+		test(rc == 0);
+		rc = machine_tls_set_session(tls, session);
+		test(rc == 0);
+		rc = machine_set_tls(client, tls);
+		if (rc == -1) {
+			printf("%s\n", machine_error(client));
+			test(rc == 0);
+		}
+		test(machine_io_is_resumed(client) == (i > 0));
+
+		/* session ticket is received with the data */
+		machine_msg_t *msg;
+		msg = machine_read(client, 12, UINT32_MAX);
+		test(msg != NULL);
+		test(memcmp(machine_msg_get_data(msg), "hello world", 12) == 0);
+		machine_msg_free(msg);
+
+		msg = machine_read(client, 1, UINT32_MAX);
+		/* eof */
+		test(msg == NULL);
+
+		rc = machine_close(client);
+		test(rc == 0);
+		machine_io_free(client);
+
+		machine_tls_free(tls);
+	}
+
+	machine_tls_session_free(session);
+}
+
+static void
+test_cs(void *arg)
+{
+	(void)arg;
+	int rc;
+	rc = machine_coroutine_create(server, NULL);
+	test(rc != -1);
+
+	rc = machine_coroutine_create(client, NULL);
+	test(rc != -1);
+}
+
+void
+machinarium_test_tls_resume(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_cs, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
@@ -0,0 +1,115 @@
+#include <machinarium.h>
+#include <odyssey_test.h>
+
+#include <string.h>
+#include <arpa/inet.h>
+
+static void
+server(void *arg)
+{
+	(void)arg;
+	machine_io_t *server = machine_io_create();
+	test(server != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_bind(server, (struct sockaddr*)&sa);
+	test(rc == 0);
+
+	machine_io_t *client;
+	rc = machine_accept(server, &client, 16, 1, UINT32_MAX);
+	test(rc == 0);
+
+	rc = machine_set_write_watermark(client, 1024, 2048);
+	test(rc == -1);
+	rc = machine_set_write_watermark(client, 64 * 1024, 16 * 1024);
+	test(rc == 0);
+
+	test(machine_write_queue_size(client) == 0);
+	test(machine_write_overflow(client) == 0);
+
+	int i = 0;
+	for (; i < 32; i++) {
+		machine_msg_t *msg;
+		msg = machine_msg_create(8 * 1024);
+		test(msg != NULL);
+		memset(machine_msg_get_data(msg), 'x', 8 * 1024);
+		rc = machine_write(client, msg);
+		test(rc == 0);
+	}
+	test(machine_write_queue_size(client) == 256 * 1024);
+	test(machine_write_overflow(client) == 1);
+
+	rc = machine_write_wait(client, UINT32_MAX);
+	test(rc == 0);
+	test(machine_write_queue_size(client) <= 16 * 1024);
+	test(machine_write_overflow(client) == 0);
+
+	rc = machine_flush(client, UINT32_MAX);
+	test(rc == 0);
+	test(machine_write_queue_size(client) == 0);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+
+	rc = machine_close(server);
+	test(rc == 0);
+	machine_io_free(server);
+}
+
+static void
+client(void *arg)
+{
+	(void)arg;
+	machine_io_t *client = machine_io_create();
+	test(client != NULL);
+
+	struct sockaddr_in sa;
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sa.sin_port = htons(7778);
+	int rc;
+	rc = machine_connect(client, (struct sockaddr*)&sa, UINT32_MAX);
+	test(rc == 0);
+
+	machine_msg_t *msg;
+	msg = machine_read(client, 256 * 1024, UINT32_MAX);
+	test(msg != NULL);
+	machine_msg_free(msg);
+
+	rc = machine_close(client);
+	test(rc == 0);
+	machine_io_free(client);
+}
+
+static void
+test_cs(void *arg)
+{
+	(void)arg;
+	int rc;
+	rc = machine_coroutine_create(server, NULL);
+	test(rc != -1);
+
+	rc = machine_coroutine_create(client, NULL);
+	test(rc != -1);
+}
+
+void
+machinarium_test_write_watermark(void)
+{
+	machinarium_init();
+
+	int id;
+	id = machine_create("test", test_cs, NULL);
+	test(id != -1);
+
+	int rc;
+	rc = machine_wait(id);
+	test(rc != -1);
+
+	machinarium_free();
+}
@@ -69,6 +69,13 @@ extern void machinarium_test_read_poll1(void);
 extern void machinarium_test_read_poll2(void);
 extern void machinarium_test_read_poll3(void);
 extern void machinarium_test_read_var(void);
+extern void machinarium_test_read_peek(void);
+extern void machinarium_test_write_watermark(void);
+extern void machinarium_test_pollset(void);
+extern void machinarium_test_read_wait(void);
+extern void machinarium_test_splice(void);
+extern void machinarium_test_reply0(void);
+extern void machinarium_test_reply1(void);
 extern void machinarium_test_tls0(void);
 extern void machinarium_test_tls_unix_socket(void);
 extern void machinarium_test_tls_read_10mb0(void);
@@ -77,6 +84,7 @@ extern void machinarium_test_tls_read_10mb2(void);
 extern void machinarium_test_tls_read_10mb_poll(void);
 extern void machinarium_test_tls_read_multithread(void);
 extern void machinarium_test_tls_read_var(void);
+extern void machinarium_test_tls_resume(void);
 
 int main(int argc, char *argv[])
 {
@@ -136,6 +144,13 @@ int main(int argc, char *argv[])
 	odyssey_test(machinarium_test_read_poll2);
 	odyssey_test(machinarium_test_read_poll3);
 	odyssey_test(machinarium_test_read_var);
+	odyssey_test(machinarium_test_read_peek);
+	odyssey_test(machinarium_test_write_watermark);
+	odyssey_test(machinarium_test_pollset);
+	odyssey_test(machinarium_test_read_wait);
+	odyssey_test(machinarium_test_splice);
+	odyssey_test(machinarium_test_reply0);
+	odyssey_test(machinarium_test_reply1);
 	odyssey_test(machinarium_test_tls0);
 	odyssey_test(machinarium_test_tls_unix_socket);
 	odyssey_test(machinarium_test_tls_read_10mb0);
@@ -144,5 +159,6 @@ int main(int argc, char *argv[])
 	odyssey_test(machinarium_test_tls_read_10mb_poll);
 	odyssey_test(machinarium_test_tls_read_multithread);
 	odyssey_test(machinarium_test_tls_read_var);
+	odyssey_test(machinarium_test_tls_resume);
 	return 0;
 }
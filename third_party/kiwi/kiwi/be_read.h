@@ -160,13 +160,8 @@ kiwi_be_read_password(machine_msg_t *msg, kiwi_password_t *pw)
 }
 
 KIWI_API static inline int
-kiwi_be_read_query(machine_msg_t *msg, char **query, uint32_t *query_len)
+kiwi_be_read_query(char *data, uint32_t size, char **query, uint32_t *query_len)
 {
-	char *data;
-	data = machine_msg_get_data(msg);
-	uint32_t size;
-	size = machine_msg_get_size(msg);
-
 	kiwi_header_t *header = (kiwi_header_t*)data;
 	uint32_t len;
 	int rc = kiwi_read(&len, &data, &size);
@@ -180,14 +175,9 @@ kiwi_be_read_query(machine_msg_t *msg, char **query, uint32_t *query_len)
 }
 
 KIWI_API static inline int
-kiwi_be_read_parse(machine_msg_t *msg, char **name, uint32_t *name_len,
+kiwi_be_read_parse(char *data, uint32_t size, char **name, uint32_t *name_len,
                    char **query, uint32_t *query_len)
 {
-	char *data;
-	data = machine_msg_get_data(msg);
-	uint32_t size;
-	size = machine_msg_get_size(msg);
-
 	kiwi_header_t *header = (kiwi_header_t*)data;
 	uint32_t len;
 	int rc = kiwi_read(&len, &data, &size);
@@ -216,4 +206,85 @@ kiwi_be_read_parse(machine_msg_t *msg, char **name, uint32_t *name_len,
 	return 0;
 }
 
+KIWI_API static inline int
+kiwi_be_read_bind(char *data, uint32_t size, char **portal, uint32_t *portal_len,
+                  char **name, uint32_t *name_len)
+{
+	kiwi_header_t *header = (kiwi_header_t*)data;
+	uint32_t len;
+	int rc = kiwi_read(&len, &data, &size);
+	if (kiwi_unlikely(rc != 0))
+		return -1;
+	if (kiwi_unlikely(header->type != KIWI_FE_BIND))
+		return -1;
+	uint32_t pos_size = len;
+	char *pos = header->data;
+	/* portal_name */
+	*portal = pos;
+	rc = kiwi_readsz(&pos, &pos_size);
+	if (kiwi_unlikely(rc == -1))
+		return -1;
+	*portal_len = pos - *portal;
+	/* operator_name */
+	*name = pos;
+	rc = kiwi_readsz(&pos, &pos_size);
+	if (kiwi_unlikely(rc == -1))
+		return -1;
+	*name_len = pos - *name;
+	/* parameters and result formats */
+	return 0;
+}
+
+KIWI_API static inline int
+kiwi_be_read_describe(char *data, uint32_t size, char *type,
+                      char **name, uint32_t *name_len)
+{
+	kiwi_header_t *header = (kiwi_header_t*)data;
+	uint32_t len;
+	int rc = kiwi_read(&len, &data, &size);
+	if (kiwi_unlikely(rc != 0))
+		return -1;
+	if (kiwi_unlikely(header->type != KIWI_FE_DESCRIBE))
+		return -1;
+	uint32_t pos_size = len;
+	char *pos = header->data;
+	/* 'S' statement or 'P' portal */
+	rc = kiwi_read8(type, &pos, &pos_size);
+	if (kiwi_unlikely(rc == -1))
+		return -1;
+	/* name */
+	*name = pos;
+	rc = kiwi_readsz(&pos, &pos_size);
+	if (kiwi_unlikely(rc == -1))
+		return -1;
+	*name_len = pos - *name;
+	return 0;
+}
+
+KIWI_API static inline int
+kiwi_be_read_close(char *data, uint32_t size, char *type,
+                   char **name, uint32_t *name_len)
+{
+	kiwi_header_t *header = (kiwi_header_t*)data;
+	uint32_t len;
+	int rc = kiwi_read(&len, &data, &size);
+	if (kiwi_unlikely(rc != 0))
+		return -1;
+	if (kiwi_unlikely(header->type != KIWI_FE_CLOSE))
+		return -1;
+	uint32_t pos_size = len;
+	char *pos = header->data;
+	/* 'S' statement or 'P' portal */
+	rc = kiwi_read8(type, &pos, &pos_size);
+	if (kiwi_unlikely(rc == -1))
+		return -1;
+	/* name */
+	*name = pos;
+	rc = kiwi_readsz(&pos, &pos_size);
+	if (kiwi_unlikely(rc == -1))
+		return -1;
+	*name_len = pos - *name;
+	return 0;
+}
+
 #endif /* KIWI_BE_READ_H */
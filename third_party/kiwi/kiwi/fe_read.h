@@ -19,13 +19,8 @@ struct kiwi_fe_error
 };
 
 KIWI_API static inline int
-kiwi_fe_read_ready(machine_msg_t *msg, int *status)
+kiwi_fe_read_ready(char *data, uint32_t size, int *status)
 {
-	char *data;
-	data = machine_msg_get_data(msg);
-	uint32_t size;
-	size = machine_msg_get_size(msg);
-
 	kiwi_header_t *header = (kiwi_header_t*)data;
 	uint32_t len;
 	int rc = kiwi_read(&len, &data, &size);
@@ -101,15 +96,10 @@ kiwi_fe_read_auth(machine_msg_t *msg, uint32_t *type, char salt[4])
 }
 
 KIWI_API static inline int
-kiwi_fe_read_parameter(machine_msg_t *msg,
+kiwi_fe_read_parameter(char *data, uint32_t size,
                        char **name, uint32_t *name_len,
                        char **value, uint32_t *value_len)
 {
-	char *data;
-	data = machine_msg_get_data(msg);
-	uint32_t size;
-	size = machine_msg_get_size(msg);
-
 	kiwi_header_t *header = (kiwi_header_t*)data;
 	uint32_t len;
 	int rc = kiwi_read(&len, &data, &size);
@@ -135,13 +125,8 @@ kiwi_fe_read_parameter(machine_msg_t *msg,
 }
 
 KIWI_API static inline int
-kiwi_fe_read_error(machine_msg_t *msg, kiwi_fe_error_t *error)
+kiwi_fe_read_error(char *data, uint32_t size, kiwi_fe_error_t *error)
 {
-	char *data;
-	data = machine_msg_get_data(msg);
-	uint32_t size;
-	size = machine_msg_get_size(msg);
-
 	kiwi_header_t *header = (kiwi_header_t*)data;
 	uint32_t len;
 	int rc = kiwi_read(&len, &data, &size);
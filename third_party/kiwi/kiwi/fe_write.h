@@ -238,6 +238,37 @@ kiwi_fe_write_execute(char *portal, int portal_len, uint32_t limit)
 	return msg;
 }
 
+KIWI_API static inline machine_msg_t*
+kiwi_fe_write_copy_data(char *data, int len)
+{
+	int size = sizeof(kiwi_header_t) + len;
+	machine_msg_t *msg;
+	msg = machine_msg_create(size);
+	if (kiwi_unlikely(msg == NULL))
+		return NULL;
+	char *pos;
+	pos = machine_msg_get_data(msg);
+	kiwi_write8(&pos, KIWI_FE_COPY_DATA);
+	kiwi_write32(&pos, sizeof(uint32_t) + len);
+	kiwi_write(&pos, data, len);
+	return msg;
+}
+
+KIWI_API static inline machine_msg_t*
+kiwi_fe_write_copy_done(void)
+{
+	int size = sizeof(kiwi_header_t);
+	machine_msg_t *msg;
+	msg = machine_msg_create(size);
+	if (kiwi_unlikely(msg == NULL))
+		return NULL;
+	char *pos;
+	pos = machine_msg_get_data(msg);
+	kiwi_write8(&pos, KIWI_FE_COPY_DONE);
+	kiwi_write32(&pos, sizeof(uint32_t));
+	return msg;
+}
+
 KIWI_API static inline machine_msg_t*
 kiwi_fe_write_sync(void)
 {
@@ -150,6 +150,27 @@ kiwi_params_find(kiwi_params_t *params, char *name, int name_len)
 	return NULL;
 }
 
+static inline void
+kiwi_params_remove(kiwi_params_t *params, kiwi_param_t *param)
+{
+	kiwi_param_t *current = params->list;
+	kiwi_param_t *prev = NULL;
+	while (current)
+	{
+		if (current == param) {
+			if (prev)
+				prev->next = param->next;
+			else
+				params->list = param->next;
+			params->count--;
+			kiwi_param_free(param);
+			return;
+		}
+		prev    = current;
+		current = current->next;
+	}
+}
+
 static inline int
 kiwi_enquote(char *src, char *dst, int dst_len)
 {
@@ -133,7 +133,9 @@ int mm_eventmgr_signal(mm_event_t *event)
 
 	pthread_spin_lock(&mgr->lock);
 
-	if (event->state == MM_EVENT_ACTIVE) {
+	/* already signaled or the waiter is gone */
+	if (event->state == MM_EVENT_ACTIVE ||
+	    event->state == MM_EVENT_NONE) {
 		pthread_spin_unlock(&mgr->lock);
 		return 0;
 	}
@@ -30,6 +30,10 @@ machine_io_create(void)
 	/* write */
 	mm_list_init(&io->write_queue);
 	mm_buf_init(&io->write_iov);
+
+	/* splice */
+	io->splice_pipe[0] = -1;
+	io->splice_pipe[1] = -1;
 	return (machine_io_t*)io;
 }
 
@@ -47,6 +51,7 @@ machine_io_free(machine_io_t *obj)
 		msg = mm_container_of(i, mm_msg_t, link);
 		machine_msg_free((machine_msg_t*)msg);
 	}
+	mm_splice_free(io);
 	free(io);
 }
 
@@ -107,6 +112,20 @@ machine_set_keepalive(machine_io_t *obj, int enable, int delay)
 	return 0;
 }
 
+MACHINE_API int
+machine_set_write_watermark(machine_io_t *obj, int high, int low)
+{
+	mm_io_t *io = mm_cast(mm_io_t*, obj);
+	mm_errno_set(0);
+	if (high < 0 || low < 0 || (high > 0 && low >= high)) {
+		mm_errno_set(EINVAL);
+		return -1;
+	}
+	io->write_high = high;
+	io->write_low  = low;
+	return 0;
+}
+
 MACHINE_API int
 machine_io_attach(machine_io_t *obj)
 {
@@ -159,6 +178,15 @@ machine_io_verify(machine_io_t *obj, char *common_name)
 	return rc;
 }
 
+MACHINE_API int
+machine_io_is_resumed(machine_io_t *obj)
+{
+	mm_io_t *io = mm_cast(mm_io_t*, obj);
+	if (! mm_tlsio_is_active(&io->tls))
+		return 0;
+	return SSL_session_reused(io->tls.ssl);
+}
+
 int mm_io_socket_set(mm_io_t *io, int fd)
 {
 	io->fd = fd;
@@ -24,6 +24,8 @@ struct mm_io
 	mm_call_t   call;
 	mm_call_t  *poll_call;
 	int         poll_ready;
+	mm_pollset_t *pollset;
+	int         pollset_ready;
 	/* connect */
 	int         connected;
 	/* accept */
@@ -44,7 +46,13 @@ struct mm_io
 	int         write_iov_pos;
 	mm_list_t   write_queue;
 	int         write_queue_count;
+	int         write_queue_size;
+	int         write_high;
+	int         write_low;
+	int         write_wait;
 	int         write_status;
+	/* splice */
+	int         splice_pipe[2];
 };
 
 int mm_io_socket_set(mm_io_t*, int);
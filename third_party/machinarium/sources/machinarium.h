@@ -34,7 +34,11 @@ typedef void (*machine_coroutine_t)(void *arg);
 typedef struct machine_msg_private     machine_msg_t;
 typedef struct machine_channel_private machine_channel_t;
 typedef struct machine_tls_private     machine_tls_t;
+typedef struct machine_tls_session_private machine_tls_session_t;
+typedef struct machine_tls_tickets_private machine_tls_tickets_t;
 typedef struct machine_io_private      machine_io_t;
+typedef struct machine_pollset_private machine_pollset_t;
+typedef struct machine_reply_private   machine_reply_t;
 
 /* configuration */
 
@@ -161,6 +165,21 @@ machine_channel_write(machine_channel_t*, machine_msg_t*);
 MACHINE_API machine_msg_t*
 machine_channel_read(machine_channel_t*, uint32_t time_ms);
 
+/* request-reply */
+
+MACHINE_API machine_reply_t*
+machine_reply_create(void);
+
+MACHINE_API void
+machine_reply_free(machine_reply_t*);
+
+MACHINE_API int
+machine_channel_call(machine_channel_t*, machine_msg_t*, machine_reply_t*,
+                     uint32_t time_ms);
+
+MACHINE_API void
+machine_reply_signal(machine_reply_t*);
+
 /* tls */
 
 MACHINE_API machine_tls_t*
@@ -190,6 +209,24 @@ machine_tls_set_cert_file(machine_tls_t*, char*);
 MACHINE_API int
 machine_tls_set_key_file(machine_tls_t*, char*);
 
+MACHINE_API int
+machine_tls_set_session(machine_tls_t*, machine_tls_session_t*);
+
+MACHINE_API machine_tls_session_t*
+machine_tls_session_create(void);
+
+MACHINE_API void
+machine_tls_session_free(machine_tls_session_t*);
+
+MACHINE_API int
+machine_tls_set_tickets(machine_tls_t*, machine_tls_tickets_t*);
+
+MACHINE_API machine_tls_tickets_t*
+machine_tls_tickets_create(int rotate);
+
+MACHINE_API void
+machine_tls_tickets_free(machine_tls_tickets_t*);
+
 /* io control */
 
 MACHINE_API machine_io_t*
@@ -219,12 +256,18 @@ machine_set_keepalive(machine_io_t*, int enable, int delay);
 MACHINE_API int
 machine_set_readahead(machine_io_t*, int size);
 
+MACHINE_API int
+machine_set_write_watermark(machine_io_t*, int high, int low);
+
 MACHINE_API int
 machine_set_tls(machine_io_t*, machine_tls_t*);
 
 MACHINE_API int
 machine_io_verify(machine_io_t*, char *common_name);
 
+MACHINE_API int
+machine_io_is_resumed(machine_io_t*);
+
 /* dns */
 
 MACHINE_API int
@@ -262,21 +305,62 @@ machine_read_poll(machine_io_t**, machine_io_t**, int count, uint32_t time_ms);
 MACHINE_API int
 machine_read_pending(machine_io_t*);
 
+/* persistent poll set */
+
+MACHINE_API machine_pollset_t*
+machine_pollset_create(void);
+
+MACHINE_API void
+machine_pollset_free(machine_pollset_t*);
+
+MACHINE_API int
+machine_pollset_add(machine_pollset_t*, machine_io_t*);
+
+MACHINE_API int
+machine_pollset_delete(machine_pollset_t*, machine_io_t*);
+
+MACHINE_API int
+machine_pollset_wait(machine_pollset_t*, machine_io_t **ready, int count, uint32_t time_ms);
+
 MACHINE_API machine_msg_t*
 machine_read(machine_io_t*, int size, uint32_t time_ms);
 
 MACHINE_API int
 machine_read_to(machine_io_t*, machine_msg_t*, int size, uint32_t time_ms);
 
+MACHINE_API int
+machine_read_peek(machine_io_t*, char **data);
+
+MACHINE_API int
+machine_read_advance(machine_io_t*, int size);
+
+MACHINE_API int
+machine_read_wait(machine_io_t*, int size, uint32_t time_ms);
+
+MACHINE_API int
+machine_splice(machine_io_t *src, machine_io_t *dst, int size, uint32_t time_ms);
+
 MACHINE_API int
 machine_write_batch(machine_io_t*, machine_channel_t*);
 
 MACHINE_API int
 machine_write(machine_io_t*, machine_msg_t*);
 
+MACHINE_API int
+machine_write_direct(machine_io_t*, char *buf, int size);
+
 MACHINE_API int
 machine_flush(machine_io_t*, uint32_t time_ms);
 
+MACHINE_API int
+machine_write_wait(machine_io_t*, uint32_t time_ms);
+
+MACHINE_API int
+machine_write_overflow(machine_io_t*);
+
+MACHINE_API int
+machine_write_queue_size(machine_io_t*);
+
 MACHINE_API int
 machine_close(machine_io_t*);
 
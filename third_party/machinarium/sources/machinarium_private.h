@@ -38,6 +38,13 @@
 #include <openssl/conf.h>
 #include <openssl/bio.h>
 #include <openssl/err.h>
+#include <openssl/rand.h>
+#include <openssl/evp.h>
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+#include <openssl/core_names.h>
+#else
+#include <openssl/hmac.h>
+#endif
 
 #include "build.h"
 #include "macro.h"
@@ -72,6 +79,7 @@
 #include "channel_type.h"
 #include "channel.h"
 #include "channel_fast.h"
+#include "reply.h"
 
 #include "task.h"
 #include "task_mgr.h"
@@ -83,8 +91,10 @@
 #include "tls_api.h"
 #include "tls.h"
 
+#include "pollset.h"
 #include "io.h"
 #include "read.h"
 #include "write.h"
+#include "splice.h"
 
 #endif
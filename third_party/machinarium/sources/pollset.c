@@ -0,0 +1,173 @@
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+*/
+
+#include <machinarium.h>
+#include <machinarium_private.h>
+
+/*
+ * Unlike machine_read_poll(), poll set keeps its ios registered
+ * for reading between wait calls: read handler is installed once
+ * on add and readahead callback signals the set directly.
+ */
+
+static inline mm_io_t**
+mm_pollset_ios(mm_pollset_t *pollset)
+{
+	return (mm_io_t**)pollset->set.start;
+}
+
+MACHINE_API machine_pollset_t*
+machine_pollset_create(void)
+{
+	mm_errno_set(0);
+	mm_pollset_t *pollset;
+	pollset = malloc(sizeof(*pollset));
+	if (pollset == NULL) {
+		mm_errno_set(ENOMEM);
+		return NULL;
+	}
+	memset(&pollset->call, 0, sizeof(pollset->call));
+	mm_buf_init(&pollset->set);
+	pollset->count = 0;
+	return (machine_pollset_t*)pollset;
+}
+
+MACHINE_API void
+machine_pollset_free(machine_pollset_t *obj)
+{
+	mm_pollset_t *pollset = mm_cast(mm_pollset_t*, obj);
+	mm_io_t **ios = mm_pollset_ios(pollset);
+	int i;
+	for (i = 0; i < pollset->count; i++) {
+		ios[i]->pollset = NULL;
+		ios[i]->pollset_ready = 0;
+	}
+	mm_buf_free(&pollset->set);
+	free(pollset);
+}
+
+MACHINE_API int
+machine_pollset_add(machine_pollset_t *obj, machine_io_t *obj_io)
+{
+	mm_pollset_t *pollset = mm_cast(mm_pollset_t*, obj);
+	mm_io_t *io = mm_cast(mm_io_t*, obj_io);
+	mm_errno_set(0);
+	if (io->pollset != NULL) {
+		mm_errno_set(EEXIST);
+		return -1;
+	}
+	if (! io->attached) {
+		mm_errno_set(ENOTCONN);
+		return -1;
+	}
+	int rc;
+	rc = mm_buf_add(&pollset->set, &io, sizeof(io));
+	if (rc == -1) {
+		mm_errno_set(ENOMEM);
+		return -1;
+	}
+	rc = mm_readahead_start(io, mm_readahead_cb, io);
+	if (rc == -1) {
+		pollset->set.pos -= sizeof(io);
+		return -1;
+	}
+	io->pollset = pollset;
+	io->pollset_ready = 0;
+	pollset->count++;
+	return 0;
+}
+
+MACHINE_API int
+machine_pollset_delete(machine_pollset_t *obj, machine_io_t *obj_io)
+{
+	mm_pollset_t *pollset = mm_cast(mm_pollset_t*, obj);
+	mm_io_t *io = mm_cast(mm_io_t*, obj_io);
+	mm_errno_set(0);
+	if (io->pollset != pollset) {
+		mm_errno_set(ENOENT);
+		return -1;
+	}
+
+	/* io stays registered for reading, same as after machine_read(),
+	 * it might be already detached from the loop at this point */
+	io->pollset = NULL;
+	io->pollset_ready = 0;
+
+	mm_io_t **ios = mm_pollset_ios(pollset);
+	int i;
+	for (i = 0; i < pollset->count; i++) {
+		if (ios[i] != io)
+			continue;
+		memmove(&ios[i], &ios[i + 1],
+		        sizeof(mm_io_t*) * (pollset->count - i - 1));
+		break;
+	}
+	pollset->count--;
+	pollset->set.pos -= sizeof(mm_io_t*);
+	return 0;
+}
+
+MACHINE_API int
+machine_pollset_wait(machine_pollset_t *obj, machine_io_t **obj_set_ready,
+                     int count, uint32_t time_ms)
+{
+	mm_pollset_t *pollset = mm_cast(mm_pollset_t*, obj);
+	mm_io_t **io_ready = mm_cast(mm_io_t**, obj_set_ready);
+	mm_io_t **ios = mm_pollset_ios(pollset);
+
+	mm_errno_set(0);
+	if (count <= 0 || pollset->count == 0) {
+		mm_errno_set(EINVAL);
+		return -1;
+	}
+	if (mm_call_is_active(&pollset->call)) {
+		mm_errno_set(EINPROGRESS);
+		return -1;
+	}
+
+	/* check for any pending events or data */
+	int rc;
+	int ready = 0;
+	int i;
+	for (i = 0; i < pollset->count && ready < count; i++) {
+		rc = machine_read_pending((machine_io_t*)ios[i]);
+		if (rc == -1)
+			return -1;
+		ios[i]->pollset_ready = 0;
+		if (rc > 0) {
+			io_ready[ready] = ios[i];
+			ready++;
+		}
+	}
+	if (ready > 0)
+		return ready;
+
+	/* restore read handler, which might have been replaced or
+	 * stopped by a read call (no syscall if already armed) */
+	for (i = 0; i < pollset->count; i++) {
+		rc = mm_readahead_start(ios[i], mm_readahead_cb, ios[i]);
+		if (rc == -1)
+			return -1;
+	}
+
+	mm_call(&pollset->call, MM_CALL_READ_POLL, time_ms);
+
+	rc = pollset->call.status;
+	if (rc != 0) {
+		mm_errno_set(rc);
+		return -1;
+	}
+
+	/* fill ready set */
+	for (i = 0; i < pollset->count && ready < count; i++) {
+		if (! ios[i]->pollset_ready)
+			continue;
+		ios[i]->pollset_ready = 0;
+		io_ready[ready] = ios[i];
+		ready++;
+	}
+	return ready;
+}
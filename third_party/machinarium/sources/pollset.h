@@ -0,0 +1,19 @@
+#ifndef MM_POLLSET_H
+#define MM_POLLSET_H
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+*/
+
+typedef struct mm_pollset mm_pollset_t;
+
+struct mm_pollset
+{
+	mm_call_t call;
+	mm_buf_t  set;
+	int       count;
+};
+
+#endif /* MM_POLLSET_H */
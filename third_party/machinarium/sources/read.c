@@ -8,6 +8,17 @@
 #include <machinarium.h>
 #include <machinarium_private.h>
 
+static inline void
+mm_readahead_notify(mm_io_t *io)
+{
+	mm_pollset_t *pollset = io->pollset;
+	if (pollset == NULL)
+		return;
+	io->pollset_ready = 1;
+	if (mm_call_is(&pollset->call, MM_CALL_READ_POLL))
+		mm_scheduler_wakeup(&mm_self->scheduler, pollset->call.coroutine);
+}
+
 void
 mm_readahead_cb(mm_fd_t *handle)
 {
@@ -34,6 +45,7 @@ mm_readahead_cb(mm_fd_t *handle)
 				call->status = errno;
 				mm_scheduler_wakeup(&mm_self->scheduler, call->coroutine);
 			}
+			mm_readahead_notify(io);
 			return;
 		}
 		io->readahead_pos += rc;
@@ -59,6 +71,7 @@ mm_readahead_cb(mm_fd_t *handle)
 		if (io->read_eof || ra_left >= io->read_size)
 			mm_scheduler_wakeup(&mm_self->scheduler, call->coroutine);
 	}
+	mm_readahead_notify(io);
 }
 
 int mm_readahead_start(mm_io_t *io, mm_fd_callback_t callback, void *arg)
@@ -245,6 +258,122 @@ machine_set_readahead(machine_io_t *obj, int size)
 	return 0;
 }
 
+MACHINE_API int
+machine_read_peek(machine_io_t *obj, char **data)
+{
+	mm_io_t *io = mm_cast(mm_io_t*, obj);
+
+	mm_errno_set(0);
+	*data = NULL;
+	if (mm_call_is_active(&io->call)) {
+		mm_errno_set(EINPROGRESS);
+		return -1;
+	}
+	if (! io->attached) {
+		mm_errno_set(ENOTCONN);
+		return -1;
+	}
+
+	/* readahead buffer contains encrypted data */
+	if (mm_tlsio_is_active(&io->tls))
+		return 0;
+
+	int ra_left = io->readahead_pos - io->readahead_pos_read;
+	if (ra_left == 0)
+		return 0;
+	*data = io->readahead_buf.start + io->readahead_pos_read;
+	return ra_left;
+}
+
+MACHINE_API int
+machine_read_advance(machine_io_t *obj, int size)
+{
+	mm_io_t *io = mm_cast(mm_io_t*, obj);
+
+	mm_errno_set(0);
+	int ra_left = io->readahead_pos - io->readahead_pos_read;
+	if (size < 0 || size > ra_left) {
+		mm_errno_set(EINVAL);
+		return -1;
+	}
+	io->readahead_pos_read += size;
+
+	/* reset readahead position, so the next read could use
+	 * the whole buffer */
+	if (io->readahead_pos_read == io->readahead_pos) {
+		io->readahead_pos = 0;
+		io->readahead_pos_read = 0;
+		mm_buf_reset(&io->readahead_buf);
+	}
+	return 0;
+}
+
+MACHINE_API int
+machine_read_wait(machine_io_t *obj, int size, uint32_t time_ms)
+{
+	mm_io_t *io = mm_cast(mm_io_t*, obj);
+
+	mm_errno_set(0);
+	if (mm_call_is_active(&io->call)) {
+		mm_errno_set(EINPROGRESS);
+		return -1;
+	}
+	if (! io->attached) {
+		mm_errno_set(ENOTCONN);
+		return -1;
+	}
+	if (size > io->readahead_size || mm_tlsio_is_active(&io->tls)) {
+		mm_errno_set(EINVAL);
+		return -1;
+	}
+	int ra_left = io->readahead_pos - io->readahead_pos_read;
+	if (ra_left >= size)
+		return 0;
+	if (io->readahead_status != 0) {
+		mm_errno_set(io->readahead_status);
+		return -1;
+	}
+	if (io->read_eof || !io->connected) {
+		mm_errno_set(ECONNRESET);
+		return -1;
+	}
+
+	/* move partial data to the beginning of the readahead
+	 * buffer, so the rest can be read in place */
+	if (io->readahead_pos_read > 0) {
+		memmove(io->readahead_buf.start,
+		        io->readahead_buf.start + io->readahead_pos_read,
+		        ra_left);
+		io->readahead_pos = ra_left;
+		io->readahead_pos_read = 0;
+	}
+
+	int rc;
+	rc = mm_readahead_start(io, mm_readahead_cb, io);
+	if (rc == -1)
+		return -1;
+
+	/* wait until readahead has enough data */
+	io->read_buf  = NULL;
+	io->read_size = size;
+	io->read_pos  = 0;
+	mm_call(&io->call, MM_CALL_READ, time_ms);
+
+	rc = io->call.status;
+	if (rc == 0)
+		rc = io->readahead_status;
+	if (rc != 0) {
+		mm_errno_set(rc);
+		return -1;
+	}
+	ra_left = io->readahead_pos - io->readahead_pos_read;
+	if (ra_left < size) {
+		mm_errno_set(ECONNRESET);
+		return -1;
+	}
+	return 0;
+}
+
 MACHINE_API int
 machine_read_pending(machine_io_t *obj)
 {
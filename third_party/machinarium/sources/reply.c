@@ -0,0 +1,62 @@
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+*/
+
+#include <machinarium.h>
+#include <machinarium_private.h>
+
+MACHINE_API machine_reply_t*
+machine_reply_create(void)
+{
+	mm_reply_t *reply;
+	reply = malloc(sizeof(mm_reply_t));
+	if (reply == NULL) {
+		mm_errno_set(ENOMEM);
+		return NULL;
+	}
+	memset(&reply->event, 0, sizeof(reply->event));
+	reply->event.state = MM_EVENT_NONE;
+	mm_list_init(&reply->event.link);
+	return (machine_reply_t*)reply;
+}
+
+MACHINE_API void
+machine_reply_free(machine_reply_t *obj)
+{
+	mm_reply_t *reply = mm_cast(mm_reply_t*, obj);
+	assert(reply->event.state == MM_EVENT_NONE);
+	free(reply);
+}
+
+MACHINE_API int
+machine_channel_call(machine_channel_t *channel, machine_msg_t *msg,
+                     machine_reply_t *obj, uint32_t time_ms)
+{
+	mm_errno_set(0);
+	mm_reply_t *reply = mm_cast(mm_reply_t*, obj);
+
+	/* register event before the request becomes visible
+	 * to the handler, so the reply cannot be lost */
+	mm_eventmgr_add(&mm_self->event_mgr, &reply->event);
+	machine_channel_write(channel, msg);
+
+	/* wait for cancel, timedout or reply */
+	int complete;
+	complete = mm_eventmgr_wait(&mm_self->event_mgr, &reply->event, time_ms);
+	if (! complete)
+		return -1;
+	return 0;
+}
+
+MACHINE_API void
+machine_reply_signal(machine_reply_t *obj)
+{
+	mm_reply_t *reply = mm_cast(mm_reply_t*, obj);
+	int event_mgr_fd;
+	event_mgr_fd = mm_eventmgr_signal(&reply->event);
+	if (event_mgr_fd > 0)
+		mm_eventmgr_wakeup(event_mgr_fd);
+}
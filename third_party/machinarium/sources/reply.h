@@ -0,0 +1,26 @@
+#ifndef MM_REPLY_H
+#define MM_REPLY_H
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+*/
+
+typedef struct mm_reply mm_reply_t;
+
+/* Reusable reply slot.
+ *
+ * A coroutine posts a request message to another machine
+ * and waits on the slot event, the request handler wakes it up
+ * directly using the slot stored in the request. Only one
+ * request can be outstanding per slot: on timeout or cancel
+ * the slot must not be reused until the handler replied.
+*/
+
+struct mm_reply
+{
+	mm_event_t event;
+};
+
+#endif /* MM_REPLY_H */
@@ -0,0 +1,211 @@
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+*/
+
+#include <machinarium.h>
+#include <machinarium_private.h>
+
+static void
+mm_splice_read_cb(mm_fd_t *handle)
+{
+	mm_call_t *call = handle->on_read_arg;
+	if (mm_call_is(call, MM_CALL_READ))
+		mm_scheduler_wakeup(&mm_self->scheduler, call->coroutine);
+}
+
+static void
+mm_splice_write_cb(mm_fd_t *handle)
+{
+	mm_call_t *call = handle->on_write_arg;
+	if (mm_call_is(call, MM_CALL_FLUSH))
+		mm_scheduler_wakeup(&mm_self->scheduler, call->coroutine);
+}
+
+static inline int
+mm_splice_wait_read(mm_io_t *io, uint32_t time_ms)
+{
+	mm_machine_t *machine = mm_self;
+	int rc;
+	rc = mm_loop_read(&machine->loop, &io->handle, mm_splice_read_cb, &io->call);
+	if (rc == -1) {
+		mm_errno_set(errno);
+		return -1;
+	}
+	mm_call(&io->call, MM_CALL_READ, time_ms);
+	rc = io->call.status;
+	if (rc != 0) {
+		mm_errno_set(rc);
+		return -1;
+	}
+	return 0;
+}
+
+static inline int
+mm_splice_wait_write(mm_io_t *io, uint32_t time_ms)
+{
+	mm_machine_t *machine = mm_self;
+	int rc;
+	rc = mm_loop_write(&machine->loop, &io->handle, mm_splice_write_cb, &io->call);
+	if (rc == -1) {
+		mm_errno_set(errno);
+		return -1;
+	}
+	mm_call(&io->call, MM_CALL_FLUSH, time_ms);
+	mm_loop_write_stop(&machine->loop, &io->handle);
+	rc = io->call.status;
+	if (rc != 0) {
+		mm_errno_set(rc);
+		return -1;
+	}
+	return 0;
+}
+
+void
+mm_splice_free(mm_io_t *io)
+{
+	if (io->splice_pipe[0] == -1)
+		return;
+	close(io->splice_pipe[0]);
+	close(io->splice_pipe[1]);
+	io->splice_pipe[0] = -1;
+	io->splice_pipe[1] = -1;
+}
+
+static inline int
+mm_splice(mm_io_t *src, mm_io_t *dst, int pipe_fd[2], int size, uint32_t time_ms)
+{
+	int flags = SPLICE_F_MOVE|SPLICE_F_NONBLOCK;
+	int in_pipe = 0;
+	ssize_t rc;
+	while (size > 0 || in_pipe > 0)
+	{
+		int progress = 0;
+
+		/* socket to pipe */
+		if (size > 0) {
+			rc = splice(src->fd, NULL, pipe_fd[1], NULL, size, flags);
+			if (rc > 0) {
+				size -= rc;
+				in_pipe += rc;
+				progress = 1;
+			} else if (rc == 0) {
+				src->connected = 0;
+				src->read_eof = 1;
+				mm_errno_set(ECONNRESET);
+				return -1;
+			} else if (errno != EAGAIN &&
+			           errno != EWOULDBLOCK &&
+			           errno != EINTR) {
+				src->connected = 0;
+				src->readahead_status = errno;
+				mm_errno_set(errno);
+				return -1;
+			}
+		}
+
+		/* pipe to socket */
+		if (in_pipe > 0) {
+			rc = splice(pipe_fd[0], NULL, dst->fd, NULL, in_pipe, flags);
+			if (rc > 0) {
+				in_pipe -= rc;
+				progress = 1;
+			} else if (rc == -1 &&
+			           errno != EAGAIN &&
+			           errno != EWOULDBLOCK &&
+			           errno != EINTR) {
+				dst->write_status = errno;
+				mm_errno_set(errno);
+				return -1;
+			}
+		}
+		if (progress)
+			continue;
+
+		/* wait for the side which blocks the transfer */
+		if (in_pipe > 0)
+			rc = mm_splice_wait_write(dst, time_ms);
+		else
+			rc = mm_splice_wait_read(src, time_ms);
+		if (rc == -1)
+			return -1;
+	}
+	return 0;
+}
+
+MACHINE_API int
+machine_splice(machine_io_t *obj_src, machine_io_t *obj_dst, int size,
+               uint32_t time_ms)
+{
+	mm_io_t *src = mm_cast(mm_io_t*, obj_src);
+	mm_io_t *dst = mm_cast(mm_io_t*, obj_dst);
+	mm_errno_set(0);
+
+	if (mm_tlsio_is_active(&src->tls) ||
+	    mm_tlsio_is_active(&dst->tls)) {
+		mm_errno_set(ENOTSUP);
+		return -1;
+	}
+	if (mm_call_is_active(&src->call) ||
+	    mm_call_is_active(&dst->call)) {
+		mm_errno_set(EINPROGRESS);
+		return -1;
+	}
+	if (! src->attached || ! dst->attached) {
+		mm_errno_set(ENOTCONN);
+		return -1;
+	}
+
+	/* forward data already buffered in readahead */
+	int rc;
+	int ra_left = src->readahead_pos - src->readahead_pos_read;
+	if (ra_left > 0) {
+		if (ra_left > size)
+			ra_left = size;
+		rc = mm_write_direct(dst, src->readahead_buf.start + src->readahead_pos_read,
+		                     ra_left);
+		if (rc == -1)
+			return -1;
+		rc = machine_read_advance(obj_src, ra_left);
+		assert(rc == 0);
+		size -= ra_left;
+	}
+	if (size == 0)
+		return 0;
+
+	/* stop reading into readahead, rest of the data
+	 * is moved by the kernel */
+	mm_machine_t *machine = mm_self;
+	rc = mm_loop_read(&machine->loop, &src->handle, mm_splice_read_cb, &src->call);
+	if (rc == -1) {
+		mm_errno_set(errno);
+		return -1;
+	}
+
+	/* data must not outrun pending writes */
+	rc = machine_flush(obj_dst, time_ms);
+	if (rc == -1)
+		goto done;
+
+	/* pipe is created on first use and kept with the
+	 * source io */
+	if (src->splice_pipe[0] == -1) {
+		rc = pipe2(src->splice_pipe, O_NONBLOCK|O_CLOEXEC);
+		if (rc == -1) {
+			src->splice_pipe[0] = -1;
+			src->splice_pipe[1] = -1;
+			mm_errno_set(errno);
+			goto done;
+		}
+	}
+	rc = mm_splice(src, dst, src->splice_pipe, size, time_ms);
+
+	/* data left in the pipe after error is dropped */
+	if (rc == -1)
+		mm_splice_free(src);
+done:
+	/* restore readahead handler */
+	mm_loop_read(&machine->loop, &src->handle, mm_readahead_cb, src);
+	return rc;
+}
@@ -0,0 +1,12 @@
+#ifndef MM_SPLICE_H
+#define MM_SPLICE_H
+
+/*
+ * machinarium.
+ *
+ * cooperative multitasking engine.
+*/
+
+void mm_splice_free(mm_io_t*);
+
+#endif /* MM_SPLICE_H */
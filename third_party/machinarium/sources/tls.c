@@ -255,6 +255,219 @@ mm_tlsio_error(mm_tlsio_t *io, int ssl_rc, char *fmt, ...)
 	io->error = 1;
 }
 
+static int
+mm_tlsio_session_new_cb(SSL *ssl, SSL_SESSION *ssl_session)
+{
+	/* keep the latest session offered by the server, including
+	 * tickets received after the handshake */
+	mm_tls_session_t *session;
+	session = SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl));
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L)
+	/* a copy is kept, since the connection session is
+	 * invalidated on a fatal error, such as unexpected eof */
+	ssl_session = SSL_SESSION_dup(ssl_session);
+	if (ssl_session == NULL)
+		return 0;
+#endif
+	pthread_spin_lock(&session->lock);
+	SSL_SESSION *prev = session->session;
+	session->session = ssl_session;
+	pthread_spin_unlock(&session->lock);
+	if (prev)
+		SSL_SESSION_free(prev);
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L)
+	return 0;
+#else
+	/* session reference is taken */
+	return 1;
+#endif
+}
+
+static inline void
+mm_tlsio_session_set(mm_tls_session_t *session, SSL *ssl)
+{
+	pthread_spin_lock(&session->lock);
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L)
+	/* connection uses its own copy, so the shared session
+	 * is not invalidated together with the connection */
+	SSL_SESSION *copy = NULL;
+	if (session->session)
+		copy = SSL_SESSION_dup(session->session);
+	pthread_spin_unlock(&session->lock);
+	if (copy) {
+		SSL_set_session(ssl, copy);
+		SSL_SESSION_free(copy);
+	}
+#else
+	if (session->session)
+		SSL_set_session(ssl, session->session);
+	pthread_spin_unlock(&session->lock);
+#endif
+}
+
+static inline void
+mm_tlsio_session_reset(mm_tls_session_t *session)
+{
+	pthread_spin_lock(&session->lock);
+	SSL_SESSION *prev = session->session;
+	session->session = NULL;
+	pthread_spin_unlock(&session->lock);
+	if (prev)
+		SSL_SESSION_free(prev);
+}
+
+static inline int64_t
+mm_tls_tickets_time(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec;
+}
+
+static inline int
+mm_tls_key_generate(mm_tls_key_t *key)
+{
+	int rc;
+	rc = RAND_bytes(key->name, sizeof(key->name));
+	if (rc != 1)
+		return -1;
+	rc = RAND_bytes(key->hmac_key, sizeof(key->hmac_key));
+	if (rc != 1)
+		return -1;
+	rc = RAND_bytes(key->aes_key, sizeof(key->aes_key));
+	if (rc != 1)
+		return -1;
+	key->time = mm_tls_tickets_time();
+	return 0;
+}
+
+int mm_tls_tickets_init(mm_tls_tickets_t *tickets, int rotate)
+{
+	int rc;
+	rc = mm_tls_key_generate(&tickets->current);
+	if (rc == -1)
+		return -1;
+	pthread_spin_init(&tickets->lock, PTHREAD_PROCESS_PRIVATE);
+	tickets->rotate = rotate;
+	tickets->has_previous = 0;
+	return 0;
+}
+
+static inline void
+mm_tlsio_tickets_rotate(mm_tls_tickets_t *tickets)
+{
+	/* keys are rotated on use, age of the previous key
+	 * is checked on match */
+	int64_t now = mm_tls_tickets_time();
+	pthread_spin_lock(&tickets->lock);
+	int64_t age = now - tickets->current.time;
+	pthread_spin_unlock(&tickets->lock);
+	if (age < tickets->rotate)
+		return;
+
+	/* generated without the lock held, concurrent rotations
+	 * keep the first key */
+	mm_tls_key_t key;
+	int rc;
+	rc = mm_tls_key_generate(&key);
+	if (rc == -1)
+		return;
+	pthread_spin_lock(&tickets->lock);
+	age = key.time - tickets->current.time;
+	if (age >= tickets->rotate) {
+		tickets->has_previous = 1;
+		tickets->previous = tickets->current;
+		tickets->current = key;
+	}
+	pthread_spin_unlock(&tickets->lock);
+	OPENSSL_cleanse(&key, sizeof(key));
+}
+
+static inline int
+mm_tlsio_tickets_match(mm_tls_tickets_t *tickets, unsigned char *name,
+                       mm_tls_key_t *key)
+{
+	/* copy current key or the key matching ticket name,
+	 * returns 1 for the current key and 2 for the previous one.
+	 *
+	 * Previous key is accepted for two rotation periods since
+	 * it was generated, so tickets issued with it stay valid
+	 * for at most one period after rotation */
+	int64_t now = mm_tls_tickets_time();
+	int rc = 0;
+	pthread_spin_lock(&tickets->lock);
+	if (name == NULL ||
+	    memcmp(name, tickets->current.name, sizeof(key->name)) == 0) {
+		*key = tickets->current;
+		rc = 1;
+	} else
+	if (tickets->has_previous &&
+	    now - tickets->previous.time < tickets->rotate * 2 &&
+	    memcmp(name, tickets->previous.name, sizeof(key->name)) == 0) {
+		*key = tickets->previous;
+		rc = 2;
+	}
+	pthread_spin_unlock(&tickets->lock);
+	return rc;
+}
+
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+static int
+mm_tlsio_tickets_cb(SSL *ssl, unsigned char *name, unsigned char *iv,
+                    EVP_CIPHER_CTX *cipher_ctx, EVP_MAC_CTX *mac_ctx,
+                    int enc)
+#else
+static int
+mm_tlsio_tickets_cb(SSL *ssl, unsigned char *name, unsigned char *iv,
+                    EVP_CIPHER_CTX *cipher_ctx, HMAC_CTX *mac_ctx,
+                    int enc)
+#endif
+{
+	mm_tls_tickets_t *tickets;
+	tickets = SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl));
+	mm_tlsio_tickets_rotate(tickets);
+
+	mm_tls_key_t key;
+	int match;
+	int rc;
+	if (enc) {
+		match = mm_tlsio_tickets_match(tickets, NULL, &key);
+		memcpy(name, key.name, sizeof(key.name));
+		rc = RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc()));
+		if (rc == 1)
+			rc = EVP_EncryptInit_ex(cipher_ctx, EVP_aes_256_cbc(), NULL,
+			                        key.aes_key, iv);
+	} else {
+		/* unknown or expired key, full handshake is done
+		 * and a new ticket is issued */
+		match = mm_tlsio_tickets_match(tickets, name, &key);
+		if (match == 0)
+			return 0;
+		rc = EVP_DecryptInit_ex(cipher_ctx, EVP_aes_256_cbc(), NULL,
+		                        key.aes_key, iv);
+	}
+	if (rc == 1) {
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+		OSSL_PARAM params[3];
+		params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY,
+		                                              key.hmac_key,
+		                                              sizeof(key.hmac_key));
+		params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST,
+		                                             "sha256", 0);
+		params[2] = OSSL_PARAM_construct_end();
+		rc = EVP_MAC_CTX_set_params(mac_ctx, params);
+#else
+		rc = HMAC_Init_ex(mac_ctx, key.hmac_key, sizeof(key.hmac_key),
+		                  EVP_sha256(), NULL);
+#endif
+	}
+	OPENSSL_cleanse(&key, sizeof(key));
+	if (rc != 1)
+		return -1;
+	/* tickets of the previous key are renewed */
+	return match;
+}
+
 static int
 mm_tlsio_prepare(mm_tls_t *tls, mm_tlsio_t *io, int client)
 {
@@ -340,6 +553,35 @@ mm_tlsio_prepare(mm_tls_t *tls, mm_tlsio_t *io, int client)
 	if (! client)
 		SSL_CTX_set_options(ctx, SSL_OP_CIPHER_SERVER_PREFERENCE);
 
+	/* client session cache is shared by all connections
+	 * using the tls object session */
+	if (client && tls->session) {
+		SSL_CTX_set_app_data(ctx, tls->session);
+		SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT|
+		                                    SSL_SESS_CACHE_NO_INTERNAL_STORE);
+		SSL_CTX_sess_set_new_cb(ctx, mm_tlsio_session_new_cb);
+	}
+
+	/* server tickets are encrypted with keys shared by all
+	 * connections using the tls object tickets, session id
+	 * cache of a per connection context is never hit */
+	if (! client && tls->tickets) {
+		const unsigned char sid_ctx[] = "machinarium";
+		rc = SSL_CTX_set_session_id_context(ctx, sid_ctx, sizeof(sid_ctx) - 1);
+		if (rc != 1) {
+			mm_tlsio_error(io, 0, "SSL_CTX_set_session_id_context()");
+			goto error;
+		}
+		SSL_CTX_set_app_data(ctx, tls->tickets);
+		SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+		SSL_CTX_set_timeout(ctx, tls->tickets->rotate);
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+		SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, mm_tlsio_tickets_cb);
+#else
+		SSL_CTX_set_tlsext_ticket_key_cb(ctx, mm_tlsio_tickets_cb);
+#endif
+	}
+
 	ssl = SSL_new(ctx);
 	if (ssl == NULL) {
 		mm_tlsio_error(io, 0, "SSL_new()");
@@ -492,9 +734,14 @@ int mm_tlsio_connect(mm_tlsio_t *io, mm_tls_t *tls)
 	rc = mm_tlsio_prepare(tls, io, 1);
 	if (rc == -1)
 		return -1;
+	if (tls->session)
+		mm_tlsio_session_set(tls->session, io->ssl);
 	rc = SSL_connect(io->ssl);
 	if (rc <= 0) {
 		mm_tlsio_error(io, rc, "SSL_connect()");
+		/* do not offer the session again */
+		if (tls->session)
+			mm_tlsio_session_reset(tls->session);
 		return -1;
 	}
 	if (tls->server) {
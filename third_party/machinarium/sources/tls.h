@@ -22,6 +22,7 @@ struct mm_tlsio
 
 void mm_tls_init(void);
 void mm_tls_free(void);
+int  mm_tls_tickets_init(mm_tls_tickets_t*, int);
 
 static inline int
 mm_tlsio_is_active(mm_tlsio_t *io) {
@@ -25,6 +25,8 @@ machine_tls_create(void)
 	tls->ca_file   = NULL;
 	tls->cert_file = NULL;
 	tls->key_file  = NULL;
+	tls->session   = NULL;
+	tls->tickets   = NULL;
 	return (machine_tls_t*)tls;
 }
 
@@ -161,6 +163,84 @@ machine_tls_set_key_file(machine_tls_t *obj, char *path)
 	return 0;
 }
 
+MACHINE_API int
+machine_tls_set_session(machine_tls_t *obj, machine_tls_session_t *session_obj)
+{
+	mm_tls_t *tls = mm_cast(mm_tls_t*, obj);
+	mm_errno_set(0);
+	tls->session = mm_cast(mm_tls_session_t*, session_obj);
+	return 0;
+}
+
+MACHINE_API machine_tls_session_t*
+machine_tls_session_create(void)
+{
+	mm_errno_set(0);
+	mm_tls_session_t *session;
+	session = malloc(sizeof(*session));
+	if (session == NULL) {
+		mm_errno_set(ENOMEM);
+		return NULL;
+	}
+	pthread_spin_init(&session->lock, PTHREAD_PROCESS_PRIVATE);
+	session->session = NULL;
+	return (machine_tls_session_t*)session;
+}
+
+MACHINE_API void
+machine_tls_session_free(machine_tls_session_t *obj)
+{
+	mm_tls_session_t *session = mm_cast(mm_tls_session_t*, obj);
+	mm_errno_set(0);
+	if (session->session)
+		SSL_SESSION_free(session->session);
+	pthread_spin_destroy(&session->lock);
+	free(session);
+}
+
+MACHINE_API int
+machine_tls_set_tickets(machine_tls_t *obj, machine_tls_tickets_t *tickets_obj)
+{
+	mm_tls_t *tls = mm_cast(mm_tls_t*, obj);
+	mm_errno_set(0);
+	tls->tickets = mm_cast(mm_tls_tickets_t*, tickets_obj);
+	return 0;
+}
+
+MACHINE_API machine_tls_tickets_t*
+machine_tls_tickets_create(int rotate)
+{
+	mm_errno_set(0);
+	if (rotate <= 0) {
+		mm_errno_set(EINVAL);
+		return NULL;
+	}
+	mm_tls_tickets_t *tickets;
+	tickets = malloc(sizeof(*tickets));
+	if (tickets == NULL) {
+		mm_errno_set(ENOMEM);
+		return NULL;
+	}
+	int rc;
+	rc = mm_tls_tickets_init(tickets, rotate);
+	if (rc == -1) {
+		free(tickets);
+		mm_errno_set(EIO);
+		return NULL;
+	}
+	return (machine_tls_tickets_t*)tickets;
+}
+
+MACHINE_API void
+machine_tls_tickets_free(machine_tls_tickets_t *obj)
+{
+	mm_tls_tickets_t *tickets = mm_cast(mm_tls_tickets_t*, obj);
+	mm_errno_set(0);
+	pthread_spin_destroy(&tickets->lock);
+	OPENSSL_cleanse(tickets, sizeof(*tickets));
+	free(tickets);
+}
+
 MACHINE_API int
 machine_set_tls(machine_io_t *obj, machine_tls_t *tls_obj)
 {
@@ -7,7 +7,10 @@
  * cooperative multitasking engine.
 */
 
-typedef struct mm_tls mm_tls_t;
+typedef struct mm_tls         mm_tls_t;
+typedef struct mm_tls_session mm_tls_session_t;
+typedef struct mm_tls_key     mm_tls_key_t;
+typedef struct mm_tls_tickets mm_tls_tickets_t;
 
 typedef enum
 {
@@ -16,6 +19,34 @@ typedef enum
 	MM_TLS_PEER_STRICT
 } mm_tlsverify_t;
 
+/* client session shared between connections
+ * to the same server, used for resumption */
+struct mm_tls_session
+{
+	pthread_spinlock_t lock;
+	SSL_SESSION       *session;
+};
+
+struct mm_tls_key
+{
+	unsigned char name[16];
+	unsigned char hmac_key[32];
+	unsigned char aes_key[32];
+	int64_t       time;
+};
+
+/* server session ticket keys shared between connections
+ * of all machines, the previous key is accepted until two
+ * rotation periods since it was generated */
+struct mm_tls_tickets
+{
+	pthread_spinlock_t lock;
+	int                rotate;
+	mm_tls_key_t       current;
+	mm_tls_key_t       previous;
+	int                has_previous;
+};
+
 struct mm_tls
 {
 	mm_tlsverify_t verify;
@@ -25,6 +56,8 @@ struct mm_tls
 	char          *ca_file;
 	char          *cert_file;
 	char          *key_file;
+	mm_tls_session_t *session;
+	mm_tls_tickets_t *tickets;
 };
 
 #endif /* MM_TLS_API_H */
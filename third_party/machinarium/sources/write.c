@@ -23,6 +23,40 @@ mm_write_eventfd(mm_io_t *io, char *buf, int size)
 	return 0;
 }
 
+static inline int
+mm_write_advance(mm_io_t *io, int written)
+{
+	struct iovec *iov;
+	iov = (struct iovec*)io->write_iov.start + io->write_iov_pos;
+	while (io->write_queue_count > 0)
+	{
+		if (iov->iov_len > (size_t)written) {
+			iov->iov_base = (char*)iov->iov_base + written;
+			iov->iov_len -= written;
+			io->write_queue_size -= written;
+			return 0;
+		}
+
+		mm_msg_t *msg;
+		msg = mm_container_of(io->write_queue.next, mm_msg_t, link);
+		mm_list_unlink(&msg->link);
+		machine_msg_free((machine_msg_t*)msg);
+
+		io->write_queue_count--;
+		io->write_queue_size -= iov->iov_len;
+		io->write_iov_pos++;
+
+		written -= iov->iov_len;
+		iov++;
+	}
+	assert(io->write_queue_size == 0);
+	io->write_iov_pos = 0;
+	mm_buf_reset(&io->write_iov);
+
+	/* bytes written past the end of the queue */
+	return written;
+}
+
 static void
 mm_write_cb(mm_fd_t *handle)
 {
@@ -49,33 +83,10 @@ mm_write_cb(mm_fd_t *handle)
 
 		goto wakeup;
 	}
-	int written = rc;
-
-	while (io->write_queue_count > 0)
-	{
-		if (iov->iov_len > (size_t)written) {
-			iov->iov_base = (char*)iov->iov_base + written;
-			iov->iov_len -= written;
-			break;
-		}
-
-		mm_msg_t *msg;
-		msg = mm_container_of(io->write_queue.next, mm_msg_t, link);
-		mm_list_unlink(&msg->link);
-		machine_msg_free((machine_msg_t*)msg);
-
-		io->write_queue_count--;
-		io->write_iov_pos++;
-
-		written -= iov->iov_len;
-		iov++;
-	}
+	mm_write_advance(io, rc);
 
 	if (io->write_queue_count == 0)
 	{
-		io->write_iov_pos = 0;
-		mm_buf_reset(&io->write_iov);
-
 		mm_machine_t *machine = mm_self;
 		mm_loop_write_stop(&machine->loop, &io->handle);
 
@@ -83,6 +94,10 @@ mm_write_cb(mm_fd_t *handle)
 		goto wakeup;
 	}
 
+	/* write queue is drained below the requested size */
+	if (io->write_queue_size <= io->write_wait)
+		goto wakeup;
+
 	return;
 
 wakeup:
@@ -112,6 +127,7 @@ mm_write(mm_io_t *io, machine_msg_t *obj)
 
 	mm_list_append(&io->write_queue, &msg->link);
 	io->write_queue_count++;
+	io->write_queue_size += iov->iov_len;
 
 	rc = mm_loop_write(&machine->loop, &io->handle, mm_write_cb, io);
 	if (rc == -1) {
@@ -122,6 +138,54 @@ mm_write(mm_io_t *io, machine_msg_t *obj)
 	return 0;
 }
 
+int
+mm_write_direct(mm_io_t *io, char *buf, int size)
+{
+	/* queue a copy, if the write queue can not be
+	 * merged with the buffer */
+	if (mm_call_is_active(&io->call) ||
+	    io->write_queue_count >= IOV_MAX)
+		return mm_write_buf(io, buf, size);
+
+	int rc;
+	rc = mm_buf_ensure(&io->write_iov, sizeof(struct iovec));
+	if (rc == -1) {
+		mm_errno_set(ENOMEM);
+		return -1;
+	}
+
+	/* write pending queue and the buffer in one writev() call,
+	 * buffer iovec is not accounted as a part of the queue */
+	struct iovec *iov;
+	iov = (struct iovec*)io->write_iov.pos;
+	iov->iov_base = buf;
+	iov->iov_len  = size;
+	iov = (struct iovec*)io->write_iov.start + io->write_iov_pos;
+	rc = mm_socket_writev(io->fd, iov, io->write_queue_count + 1);
+	if (rc == -1) {
+		if (errno != EAGAIN &&
+		    errno != EWOULDBLOCK &&
+		    errno != EINTR) {
+			io->write_status = errno;
+			mm_errno_set(errno);
+			return -1;
+		}
+		rc = 0;
+	}
+	int written;
+	written = mm_write_advance(io, rc);
+
+	if (io->write_queue_count == 0) {
+		mm_machine_t *machine = mm_self;
+		mm_loop_write_stop(&machine->loop, &io->handle);
+	}
+	if (written == size)
+		return 0;
+
+	/* copy unsent part */
+	return mm_write_buf(io, buf + written, size - written);
+}
+
 MACHINE_API int
 machine_write(machine_io_t *obj, machine_msg_t *msg)
 {
@@ -154,6 +218,34 @@ machine_write(machine_io_t *obj, machine_msg_t *msg)
 	return mm_write(io, msg);
 }
 
+MACHINE_API int
+machine_write_direct(machine_io_t *obj, char *buf, int size)
+{
+	mm_io_t *io = mm_cast(mm_io_t*, obj);
+	mm_errno_set(0);
+
+	if (! io->connected) {
+		mm_errno_set(ENOTCONN);
+		return -1;
+	}
+	if (! io->attached) {
+		mm_errno_set(ENOTCONN);
+		return -1;
+	}
+	if (io->is_eventfd) {
+		mm_errno_set(EINVAL);
+		return -1;
+	}
+	if (io->write_status != 0) {
+		mm_errno_set(io->write_status);
+		return -1;
+	}
+	if (mm_tlsio_is_active(&io->tls))
+		return mm_tlsio_write(&io->tls, buf, size);
+
+	return mm_write_direct(io, buf, size);
+}
+
 MACHINE_API int
 machine_write_batch(machine_io_t *obj, machine_channel_t *obj_channel)
 {
@@ -214,7 +306,50 @@ machine_flush(machine_io_t *obj, uint32_t time_ms)
 		return 0;
 
 	/* wait for write completion */
+	io->write_wait = 0;
+	mm_call(&io->call, MM_CALL_FLUSH, time_ms);
+
+	int rc;
+	rc = io->call.status;
+	if (rc != 0) {
+		mm_errno_set(rc);
+		return -1;
+	}
+
+	return 0;
+}
+
+MACHINE_API int
+machine_write_wait(machine_io_t *obj, uint32_t time_ms)
+{
+	mm_io_t *io = mm_cast(mm_io_t*, obj);
+	mm_errno_set(0);
+
+	if (mm_call_is_active(&io->call)) {
+		mm_errno_set(EINPROGRESS);
+		return -1;
+	}
+	if (! io->connected) {
+		mm_errno_set(ENOTCONN);
+		return -1;
+	}
+	if (! io->attached) {
+		mm_errno_set(ENOTCONN);
+		return -1;
+	}
+
+	if (io->write_status != 0) {
+		mm_errno_set(io->write_status);
+		return -1;
+	}
+
+	if (io->write_queue_size <= io->write_low)
+		return 0;
+
+	/* wait until write queue drops to the low watermark */
+	io->write_wait = io->write_low;
 	mm_call(&io->call, MM_CALL_FLUSH, time_ms);
+	io->write_wait = 0;
 
 	int rc;
 	rc = io->call.status;
@@ -225,3 +360,19 @@ machine_flush(machine_io_t *obj, uint32_t time_ms)
 
 	return 0;
 }
+
+MACHINE_API int
+machine_write_overflow(machine_io_t *obj)
+{
+	mm_io_t *io = mm_cast(mm_io_t*, obj);
+	if (io->write_high == 0)
+		return 0;
+	return io->write_queue_size >= io->write_high;
+}
+
+MACHINE_API int
+machine_write_queue_size(machine_io_t *obj)
+{
+	mm_io_t *io = mm_cast(mm_io_t*, obj);
+	return io->write_queue_size;
+}
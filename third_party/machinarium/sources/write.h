@@ -8,6 +8,7 @@
 */
 
 int mm_write(mm_io_t*, machine_msg_t*);
+int mm_write_direct(mm_io_t*, char*, int);
 
 static inline int
 mm_write_buf(mm_io_t *io, char *buf, int size)